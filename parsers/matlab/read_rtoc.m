@@ -0,0 +1,68 @@
+function experiment = read_rtoc(path)
+%READ_RTOC Reads the binary columnar experiment export (.rtoc) of RTOC.
+%   experiment = READ_RTOC(path) returns a struct with the fields
+%       columns      - struct with one field per exported attribute. Each
+%                      field is an (objects x components) matrix
+%       trackOffsets - (tracks + 1) vector. Objects of track i are rows
+%                      trackOffsets(i) + 1 : trackOffsets(i + 1)
+%
+%   The file layout is documented in src/RTOC/lib/binaryexporter.h.
+
+fid = fopen(path, 'r', 'ieee-le');
+if fid < 0
+    error('read_rtoc:open', 'Could not open %s', path);
+end
+cleanup = onCleanup(@() fclose(fid));
+
+if ~strcmp(char(fread(fid, 8, 'uint8=>char')'), sprintf('RTOCBIN\0'))
+    error('read_rtoc:format', 'Not an RTOC binary export');
+end
+fread(fid, 1, 'uint32');  % format version
+nColumns = fread(fid, 1, 'uint32');
+names = cell(nColumns, 1);
+components = zeros(nColumns, 1);
+types = cell(nColumns, 1);
+for c = 1:nColumns
+    nameLength = fread(fid, 1, 'uint32');
+    names{c} = matlab.lang.makeValidName(char(fread(fid, nameLength, 'uint8=>char')'));
+    fread(fid, 1, 'uint32');  % data flag
+    components(c) = fread(fid, 1, 'uint32');
+    if fread(fid, 1, 'uint32') == 0
+        types{c} = 'int32=>double';
+    else
+        types{c} = 'double';
+    end
+end
+
+% Locate blocks through the trailer
+fseek(fid, -8, 'eof');
+fseek(fid, fread(fid, 1, 'uint64'), 'bof');
+if ~strcmp(char(fread(fid, 8, 'uint8=>char')'), sprintf('RTOCEND\0'))
+    error('read_rtoc:format', 'Missing trailer - file is incomplete');
+end
+nBlocks = fread(fid, 1, 'uint64');
+blockOffsets = fread(fid, nBlocks, 'uint64');
+
+parts = cell(nColumns, nBlocks);
+trackOffsets = {0};
+objectBase = 0;
+for b = 1:nBlocks
+    fseek(fid, blockOffsets(b), 'bof');
+    fread(fid, 4, 'uint8');  % block magic
+    nTracks = fread(fid, 1, 'uint64');
+    nObjects = fread(fid, 1, 'uint64');
+    offsets = fread(fid, nTracks + 1, 'uint64');
+    trackOffsets{end + 1} = offsets(2:end) + objectBase; %#ok<AGROW>
+    objectBase = objectBase + nObjects;
+    for c = 1:nColumns
+        values = fread(fid, nObjects * components(c), types{c});
+        parts{c, b} = reshape(values, components(c), nObjects)';
+    end
+end
+
+experiment.columns = struct();
+for c = 1:nColumns
+    experiment.columns.(names{c}) = vertcat(parts{c, :});
+end
+experiment.trackOffsets = vertcat(trackOffsets{:});
+end
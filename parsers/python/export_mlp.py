@@ -0,0 +1,36 @@
+"""Exports a trained scikit-learn MLPClassifier to the RTOC neural network model format.
+
+The format is documented in src/RTOC/lib/machinelearning.h (ArtificialNeuralNetwork). Features
+are given as (position, attribute name) pairs in the column order of the training data. If the
+training data was standardized, pass the fitted StandardScaler to fold it into the first layer.
+
+Example:
+    import export_mlp
+    features = [(0, "Area"), (25, "Major axis"), (50, "Symmetry")]
+    export_mlp.export(clf, features, "model_ann.txt", scaler=scaler)
+"""
+import numpy as np
+
+_ACTIVATIONS = {"identity": "linear", "relu": "relu", "logistic": "sigmoid", "tanh": "tanh"}
+
+
+def export(clf, features, path, scaler=None):
+    """Writes clf, a binary MLPClassifier, to path."""
+    weights = [w.copy() for w in clf.coefs_]
+    biases = [b.copy() for b in clf.intercepts_]
+    if scaler is not None:
+        # x' = (x - mean) / scale  =>  W x' + b = (W / scale) x + (b - W mean / scale)
+        biases[0] = biases[0] - (scaler.mean_ / scaler.scale_) @ weights[0]
+        weights[0] = weights[0] / scaler.scale_[:, None]
+
+    lines = ["ANN,", "%d," % len(features)]
+    lines += ["%d,%s," % (position, name) for position, name in features]
+    lines.append("%d," % len(weights))
+    for layer, (w, b) in enumerate(zip(weights, biases)):
+        last = layer == len(weights) - 1
+        activation = "sigmoid" if last else _ACTIVATIONS[clf.activation]
+        lines.append("%d,%d,%s," % (w.shape[0], w.shape[1], activation))
+        lines.append(",".join("%.9g" % v for v in w.T.ravel()) + ",")
+        lines.append(",".join("%.9g" % v for v in b) + ",")
+    with open(path, "w") as f:
+        f.write("\n".join(lines) + "\n")
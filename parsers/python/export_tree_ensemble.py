@@ -0,0 +1,49 @@
+"""Exports a trained scikit-learn tree ensemble to the RTOC tree ensemble model format.
+
+The format is documented in src/RTOC/lib/machinelearning.h (TreeEnsemble). Each training feature
+is an attribute resampled at a relative x-position, and is given as a (position, attribute name)
+pair in the column order of the training data.
+
+Example:
+    from sklearn.ensemble import GradientBoostingClassifier
+    import export_tree_ensemble
+    features = [(0, "Area"), (25, "Major axis"), (50, "Symmetry")]
+    clf = GradientBoostingClassifier().fit(X, y)
+    export_tree_ensemble.export(clf, features, "model_gbt.txt")
+"""
+import numpy as np
+
+
+def _tree_lines(tree, leaf_value):
+    t = tree.tree_
+    lines = ["%d," % t.node_count]
+    for node in range(t.node_count):
+        if t.children_left[node] == -1:
+            lines.append("-1,0,-1,-1,%.17g," % leaf_value(t.value[node]))
+        else:
+            lines.append("%d,%.17g,%d,%d,0," % (t.feature[node], t.threshold[node],
+                                                t.children_left[node], t.children_right[node]))
+    return lines
+
+
+def export(clf, features, path):
+    """Writes clf, a binary RandomForestClassifier or GradientBoostingClassifier, to path."""
+    if hasattr(clf, "estimators_") and hasattr(clf, "learning_rate"):
+        # Gradient boosting: log-odds of the class prior plus scaled regression tree outputs
+        prior = clf.init_.class_prior_[1]
+        kind, base = "GBT", np.log(prior / (1 - prior))
+        trees = [estimator[0] for estimator in clf.estimators_]
+        leaf_value = lambda value: clf.learning_rate * value[0][0]
+    else:
+        # Random forest: mean class 1 fraction of the leaves
+        kind, base = "RF", 0.0
+        trees = clf.estimators_
+        leaf_value = lambda value: value[0][1] / np.sum(value[0])
+
+    lines = [kind + ",", "%.17g," % base, "%d," % len(features)]
+    lines += ["%d,%s," % (position, name) for position, name in features]
+    lines.append("%d," % len(trees))
+    for tree in trees:
+        lines += _tree_lines(tree, leaf_value)
+    with open(path, "w") as f:
+        f.write("\n".join(lines) + "\n")
@@ -0,0 +1,82 @@
+"""Reader for the binary columnar experiment export (.rtoc) of RTOC.
+
+The file layout is documented in src/RTOC/lib/binaryexporter.h.
+
+Example:
+    import rtoc_binary
+    experiment = rtoc_binary.read("experiment.rtoc")
+    areas = experiment["columns"]["Area"]          # all objects, in track order
+    for track in rtoc_binary.tracks(experiment):   # one dict of arrays per track
+        print(track["Centroid"][:, 0])
+"""
+import struct
+
+import numpy as np
+
+_DTYPES = {0: np.dtype("<i4"), 1: np.dtype("<f8")}
+
+
+def _read_header(f):
+    if f.read(8) != b"RTOCBIN\0":
+        raise ValueError("Not an RTOC binary export")
+    version, n_columns = struct.unpack("<II", f.read(8))
+    columns = []
+    for _ in range(n_columns):
+        (name_length,) = struct.unpack("<I", f.read(4))
+        name = f.read(name_length).decode("utf-8")
+        flag, components, dtype = struct.unpack("<III", f.read(12))
+        columns.append((name, flag, components, _DTYPES[dtype]))
+    return version, columns
+
+
+def read(path):
+    """Reads an .rtoc file.
+
+    Returns a dict with
+        "columns":       name -> array of shape (objects,) or (objects, components)
+        "flags":         name -> data flag of the column
+        "track_offsets": array of length tracks + 1. Objects of track i are
+                         [track_offsets[i], track_offsets[i + 1])
+    """
+    with open(path, "rb") as f:
+        version, columns = _read_header(f)
+
+        # Locate blocks through the trailer
+        f.seek(-8, 2)
+        (trailer_offset,) = struct.unpack("<Q", f.read(8))
+        f.seek(trailer_offset)
+        if f.read(8) != b"RTOCEND\0":
+            raise ValueError("Missing trailer - file is incomplete")
+        (n_blocks,) = struct.unpack("<Q", f.read(8))
+        block_offsets = struct.unpack("<%dQ" % n_blocks, f.read(8 * n_blocks))
+
+        parts = {name: [] for name, _, _, _ in columns}
+        track_offsets = [np.zeros(1, dtype=np.uint64)]
+        object_base = 0
+        for offset in block_offsets:
+            f.seek(offset)
+            if f.read(4) != b"BLK\0":
+                raise ValueError("Corrupt block at offset %d" % offset)
+            n_tracks, n_objects = struct.unpack("<QQ", f.read(16))
+            offsets = np.frombuffer(f.read(8 * (n_tracks + 1)), dtype="<u8")
+            track_offsets.append(offsets[1:] + object_base)
+            object_base += n_objects
+            for name, _, components, dtype in columns:
+                count = n_objects * components
+                values = np.frombuffer(f.read(count * dtype.itemsize), dtype=dtype)
+                parts[name].append(values.reshape(-1, components) if components > 1 else values)
+
+    result = {"version": version, "columns": {}, "flags": {}}
+    for name, flag, components, dtype in columns:
+        empty = np.empty((0, components) if components > 1 else (0,), dtype=dtype)
+        result["columns"][name] = np.concatenate(parts[name]) if parts[name] else empty
+        result["flags"][name] = flag
+    result["track_offsets"] = np.concatenate(track_offsets)
+    return result
+
+
+def tracks(experiment):
+    """Yields a dict of column arrays for each track in experiment."""
+    offsets = experiment["track_offsets"]
+    for begin, end in zip(offsets[:-1], offsets[1:]):
+        yield {name: values[begin:end] for name, values in experiment["columns"].items()}
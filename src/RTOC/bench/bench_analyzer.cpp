@@ -0,0 +1,345 @@
+/**
+ * End-to-end throughput benchmark of the Analyzer.
+ *
+ * A synthetic flow of objects moving through the channel (see FlowGenerator) is rendered into
+ * memory, and replayed through Analyzer::runAnalyzer by an image getter, such that neither camera
+ * nor GUI is involved. The ground truth of the flow can be written with --ground-truth, for
+ * comparing the exported tracks against.
+ * The flow is run with several Setup configurations, and the sustained frame rate, the per-stage
+ * latencies and the peak resident memory are reported for each.
+ *
+ * Usage: RTOC_bench_analyzer [--frames <n>] [--size <width>x<height>] [--density <objects>]
+ *                            [--speed <pixels/frame>] [--spacing <object lengths>]
+ *                            [--noise <sigma>] [--config <name>] [--csv <path>]
+ *                            [--ground-truth <path>]
+ */
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <opencv/cv.hpp>
+
+#include "../lib/analyzer.h"
+#include "../lib/flowgenerator.h"
+#include "../lib/process.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+namespace fs = boost::filesystem;
+typedef std::chrono::steady_clock Clock;
+
+struct Options {
+    long frames = 2000;
+    cv::Size size = {1024, 256};
+    int density = 8;      // objects in the channel at any time
+    double speed = 6.0;   // pixels per frame
+    double spacing = 1;   // minimum spacing of objects in object lengths, 0 allows overlap
+    double noise = 3;     // standard deviation of the pixel noise
+    std::string config;   // run a single configuration
+    std::string csvPath;
+    std::string groundTruthPath;
+};
+
+struct Configuration {
+    std::string name;
+    bool extractData;
+    bool classifyObjects;
+    bool storeImages;
+};
+
+struct Result {
+    std::string config;
+    long frames;
+    double acquisitionFps;  // frames/s until all frames were acquired
+    double sustainedFps;    // frames/s until all frames were analyzed and stored
+    double peakRssMb;
+    std::string latencyReport;
+};
+
+/**
+ * @brief Returns the resident memory of the process in bytes, or 0 if unavailable
+ */
+size_t currentRss() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return counters.WorkingSetSize;
+    }
+    return 0;
+#elif defined(__APPLE__)
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t) &info, &count) ==
+        KERN_SUCCESS) {
+        return info.resident_size;
+    }
+    return 0;
+#else
+    std::ifstream statm("/proc/self/statm");
+    size_t pages = 0, residentPages = 0;
+    if (statm >> pages >> residentPages) {
+        return residentPages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    }
+    return 0;
+#endif
+}
+
+/**
+ * @brief Samples the resident memory of the process until destroyed, and keeps the maximum
+ */
+class RssSampler {
+public:
+    RssSampler() : m_peak(currentRss()), m_thread(&RssSampler::sample, this) {}
+    ~RssSampler() {
+        m_stop = true;
+        m_thread.join();
+    }
+    size_t peak() const { return m_peak; }
+
+private:
+    void sample() {
+        while (!m_stop) {
+            m_peak = std::max<size_t>(m_peak, currentRss());
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        }
+    }
+
+    std::atomic<bool> m_stop{false};
+    std::atomic<size_t> m_peak;
+    std::thread m_thread;
+};
+
+FlowGeneratorConfig flowConfig(const Options& options) {
+    FlowGeneratorConfig config;
+    config.width = options.size.width;
+    config.height = options.size.height;
+    // As in makeSetup()
+    config.inlet = {options.size.width / 8, options.size.width * 7 / 8};
+    config.outlet = config.inlet;
+    config.density = options.density;
+    config.speed = options.speed;
+    config.minSpacing = options.spacing;
+    config.noise = options.noise;
+    config.majorAxisMin = std::max(8, options.size.height / 12);
+    config.majorAxisMax = std::max(12, options.size.height / 8);
+    config.period = static_cast<long>(
+        std::ceil((options.size.width + config.majorAxisMax) * 1.5 / options.speed));
+    config.seed = 42;
+    return config;
+}
+
+/**
+ * @brief Renders one period of the flow. The first frame is the empty channel, which the Analyzer
+ * uses as background
+ */
+std::vector<cv::Mat> renderFlow(FlowGenerator& generator) {
+    std::vector<cv::Mat> frames = {generator.background().clone()};
+    for (long t = 0; t < generator.config().period; t++) {
+        frames.emplace_back();
+        generator.render(t, frames.back());
+    }
+    return frames;
+}
+
+void writeModel(const std::string& path, const cv::Size& size) {
+    // Logistic regression over shape features sampled at three positions along the channel
+    std::ofstream model(path);
+    model << "LR,\n0.5,\n" << 0 << ",Area,0.01,\n"
+          << size.width / 4 << ",Major axis,-0.05,\n"
+          << size.width / 2 << ",Perimeter,0.02";
+}
+
+Setup makeSetup(const Configuration& config, const Options& options, const fs::path& outputPath) {
+    Setup setup;
+    setup.runProcessing = true;
+    setup.extractData = config.extractData;
+    setup.classifyObjects = config.classifyObjects;
+    setup.storeRaw = config.storeImages;
+    setup.storeProcessed = config.storeImages;
+    setup.storeImagesDuringExperiment = config.storeImages;
+    setup.countThreshold = 3;
+    setup.distanceThresholdInlet = 3 * options.speed;
+    setup.distanceThresholdPath = 3 * options.speed;
+    setup.dataFlags = data::AllFlags;
+    setup.conditionFlags = 0;
+    setup.recordingTime = 0;
+    // Straight inlet and outlet lines at 1/8th and 7/8th of the channel
+    setup.inlet = {options.size.width / 8, options.size.width * 7 / 8};
+    setup.outlet = setup.inlet;
+    setup.rawPrefix = "raw";
+    setup.processedPrefix = "processed";
+    setup.outputPath = outputPath.string();
+    setup.experimentName = config.name;
+    setup.modelPath = (outputPath / "model.csv").string();
+    setup.exportFormat = ExportFormat::Binary;
+    return setup;
+}
+
+void setupProcesses(Analyzer& analyzer) {
+    // The default process chain for dark objects on a bright background
+    processContainerPtr processes = analyzer.getProcessContainerPtr();
+    processes->clear();
+    processes->emplace_back(new SubtractBG());
+    auto binarize = new Binarize();
+    binarize->m_edgeThreshold.setValue(30);
+    processes->emplace_back(binarize);
+    auto morph = new Morph();
+    morph->m_morphValueX.setValue(3);
+    morph->m_morphValueY.setValue(3);
+    processes->emplace_back(morph);
+    processes->emplace_back(new FloodFillProcess());
+}
+
+Result run(const Configuration& config, const Options& options, const std::vector<cv::Mat>& flow,
+           const fs::path& outputPath) {
+    Analyzer analyzer;
+    setupProcesses(analyzer);
+
+    // Replay the flow. The first frame (the empty channel) is only shown once
+    long index = 0;
+    cv::Mat image;
+    analyzer.setImageGetterFunction([&](bool& successful) -> cv::Mat& {
+        successful = index < options.frames;
+        if (successful) {
+            const size_t i = index == 0 ? 0 : 1 + (index - 1) % (flow.size() - 1);
+            flow[i].copyTo(image);
+            index++;
+        }
+        return image;
+    });
+
+    const Setup setup = makeSetup(config, options, outputPath);
+    Result result;
+    result.config = config.name;
+    {
+        RssSampler rss;
+        const auto start = Clock::now();
+        analyzer.runAnalyzer(setup);
+        const auto acquired = Clock::now();
+        analyzer.stop();
+        const auto stopped = Clock::now();
+
+        result.frames = index;
+        result.acquisitionFps =
+            index / std::chrono::duration<double>(acquired - start).count();
+        result.sustainedFps = index / std::chrono::duration<double>(stopped - start).count();
+        result.peakRssMb = rss.peak() / (1024.0 * 1024.0);
+    }
+    result.latencyReport = analyzer.latency().report();
+    return result;
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        const bool hasValue = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--frames") && hasValue) {
+            options.frames = std::atol(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--size") && hasValue) {
+            if (std::sscanf(argv[++i], "%dx%d", &options.size.width, &options.size.height) != 2) {
+                return false;
+            }
+        } else if (!std::strcmp(argv[i], "--density") && hasValue) {
+            options.density = std::atoi(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--speed") && hasValue) {
+            options.speed = std::atof(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--spacing") && hasValue) {
+            options.spacing = std::atof(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--noise") && hasValue) {
+            options.noise = std::atof(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--config") && hasValue) {
+            options.config = argv[++i];
+        } else if (!std::strcmp(argv[i], "--csv") && hasValue) {
+            options.csvPath = argv[++i];
+        } else if (!std::strcmp(argv[i], "--ground-truth") && hasValue) {
+            options.groundTruthPath = argv[++i];
+        } else {
+            return false;
+        }
+    }
+    return options.frames > 0 && options.size.area() > 0 && options.density > 0 &&
+           options.speed > 0 && options.spacing >= 0 && options.noise >= 0;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::printf(
+            "Usage: %s [--frames <n>] [--size <width>x<height>] [--density <objects>]\n"
+            "       [--speed <pixels/frame>] [--spacing <object lengths>] [--noise <sigma>]\n"
+            "       [--config <name>] [--csv <path>] [--ground-truth <path>]\n",
+            argv[0]);
+        return 1;
+    }
+
+    const std::vector<Configuration> configurations = {
+        {"processing", false, false, false},
+        {"extraction", true, false, false},
+        {"classification", true, true, false},
+        {"storage", true, false, true},
+    };
+
+    boost::system::error_code ec;
+    const fs::path outputPath = fs::temp_directory_path() / fs::unique_path("rtoc_bench_%%%%%%");
+    fs::create_directories(outputPath, ec);
+    writeModel((outputPath / "model.csv").string(), options.size);
+
+    FlowGenerator generator(flowConfig(options));
+    const std::vector<cv::Mat> flow = renderFlow(generator);
+    if (!options.groundTruthPath.empty()) {
+        // Acquired image n + 1 is frame n of the flow
+        if (!generator.writeGroundTruth(options.groundTruthPath, options.frames - 1)) {
+            std::printf("Could not write %s\n", options.groundTruthPath.c_str());
+            return 1;
+        }
+    }
+    std::printf("%ld frames of %dx%d, %d objects in the channel, %.1f pixels/frame\n\n",
+                options.frames, options.size.width, options.size.height, options.density,
+                options.speed);
+
+    std::vector<Result> results;
+    for (const auto& config : configurations) {
+        if (!options.config.empty() && options.config != config.name) {
+            continue;
+        }
+        const Result r = run(config, options, flow, outputPath);
+        std::printf("== %s: %.1f frames/s sustained, %.1f frames/s acquired, peak RSS %.1f MB\n",
+                    r.config.c_str(), r.sustainedFps, r.acquisitionFps, r.peakRssMb);
+        std::printf("%s\n", r.latencyReport.c_str());
+        results.push_back(r);
+    }
+    fs::remove_all(outputPath, ec);
+
+    if (!options.csvPath.empty()) {
+        std::ofstream out(options.csvPath);
+        out << "config,frames,width,height,density,speed,sustained_fps,acquisition_fps,"
+               "peak_rss_mb\n";
+        for (const auto& r : results) {
+            out << r.config << "," << r.frames << "," << options.size.width << ","
+                << options.size.height << "," << options.density << "," << options.speed << ","
+                << r.sustainedFps << "," << r.acquisitionFps << "," << r.peakRssMb << "\n";
+        }
+        if (out.fail()) {
+            std::printf("Could not write %s\n", options.csvPath.c_str());
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,343 @@
+/**
+ * Micro-benchmarks of each process of the process chain.
+ *
+ * Each process is run over synthetic frames at several resolutions and object densities, and over
+ * recorded frames (--images) scaled to the same resolutions. Results are reported in ns/pixel and
+ * frames/s, and can be written as CSV (--csv) for regression tracking.
+ *
+ * Usage: RTOC_bench_processes [--images <folder>] [--csv <path>] [--min-time <ms>]
+ *                             [--filter <process>]
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <opencv/cv.hpp>
+
+#include "../lib/experiment.h"
+#include "../lib/process.h"
+
+namespace {
+namespace fs = boost::filesystem;
+typedef std::chrono::steady_clock Clock;
+
+// Input expected by a process at its usual position in the process chain
+enum class Input { Gray, Binary };
+
+struct ProcessCase {
+    std::string name;
+    Input input;
+    std::function<std::unique_ptr<ProcessBase>()> create;
+};
+
+// A frame set at a single resolution
+struct Frames {
+    std::string source;   // "synthetic" or "recorded"
+    std::string density;  // object density of synthetic frames
+    cv::Size size;
+    std::vector<cv::Mat> gray;
+    std::vector<cv::Mat> binary;
+    cv::Mat background;
+};
+
+struct Result {
+    std::string process;
+    std::string source;
+    std::string density;
+    cv::Size size;
+    long iterations;
+    double nsPerPixel;
+    double fps;
+};
+
+struct Options {
+    std::string imageFolder;
+    std::string csvPath;
+    std::string filter;
+    double minTimeMs = 200;
+};
+
+std::vector<ProcessCase> processCases() {
+    std::vector<ProcessCase> cases;
+    cases.push_back({SubtractBG::getName(), Input::Gray, [] {
+                         return std::unique_ptr<ProcessBase>(new SubtractBG());
+                     }});
+    cases.push_back({Normalize::getName(), Input::Gray, [] {
+                         return std::unique_ptr<ProcessBase>(new Normalize());
+                     }});
+    cases.push_back({Binarize::getName(), Input::Gray, [] {
+                         return std::unique_ptr<ProcessBase>(new Binarize());
+                     }});
+    cases.push_back({Canny::getName(), Input::Gray, [] {
+                         return std::unique_ptr<ProcessBase>(new Canny());
+                     }});
+    cases.push_back({Morph::getName(), Input::Binary, [] {
+                         auto morph = new Morph();
+                         morph->m_morphValueX.setValue(5);
+                         morph->m_morphValueY.setValue(5);
+                         return std::unique_ptr<ProcessBase>(morph);
+                     }});
+    cases.push_back({ClearBorder::getName(), Input::Binary, [] {
+                         return std::unique_ptr<ProcessBase>(new ClearBorder());
+                     }});
+    cases.push_back({FloodFillProcess::getName(), Input::Binary, [] {
+                         return std::unique_ptr<ProcessBase>(new FloodFillProcess());
+                     }});
+    cases.push_back({PropFilter::getName(), Input::Binary, [] {
+                         // Remove small and very large objects, as when filtering out debris
+                         auto filter = new PropFilter();
+                         filter->m_lowerLimit.setValue(20);
+                         filter->m_upperLimit.setValue(1e6);
+                         return std::unique_ptr<ProcessBase>(filter);
+                     }});
+    return cases;
+}
+
+/**
+ * @brief Binarizes gray frames as the start of the default process chain does (background
+ * subtraction followed by a threshold), as input for the processes working on binary frames
+ */
+void binarizeFrames(Frames& frames) {
+    Experiment experiment;
+    SubtractBG subtract;
+    Binarize binarize;
+    binarize.m_edgeThreshold.setValue(10);
+    for (const cv::Mat& gray : frames.gray) {
+        cv::Mat img = gray.clone();
+        cv::Mat bg = frames.background.clone();
+        subtract.doProcessing(img, bg, experiment);
+        binarize.doProcessing(img, bg, experiment);
+        frames.binary.push_back(img);
+    }
+}
+
+/**
+ * @brief Generates frames of a channel with dark elliptic objects on a lit background
+ * @param objectsPerMpx : number of objects per megapixel
+ */
+Frames syntheticFrames(cv::Size size, const std::string& density, double objectsPerMpx) {
+    const int frameCount = 8;
+    Frames frames;
+    frames.source = "synthetic";
+    frames.density = density;
+    frames.size = size;
+
+    // Horizontal illumination gradient, as seen in the recorded frames
+    frames.background = cv::Mat(size, CV_8UC1);
+    for (int x = 0; x < size.width; x++) {
+        frames.background.col(x).setTo(cv::Scalar(170 + 40.0 * x / size.width));
+    }
+
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<double> unit(0, 1);
+    const int objects =
+        std::max(1, static_cast<int>(objectsPerMpx * size.area() / 1e6 + 0.5));
+    for (int f = 0; f < frameCount; f++) {
+        cv::Mat frame = frames.background.clone();
+        for (int i = 0; i < objects; i++) {
+            const cv::Point center(static_cast<int>(unit(rng) * size.width),
+                                   static_cast<int>(unit(rng) * size.height));
+            const cv::Size axes(4 + static_cast<int>(unit(rng) * 6),
+                                4 + static_cast<int>(unit(rng) * 6));
+            cv::ellipse(frame, center, axes, unit(rng) * 180, 0, 360,
+                        cv::Scalar(60 + unit(rng) * 60), cv::FILLED);
+        }
+        cv::Mat noise(size, CV_8UC1);
+        cv::randn(noise, cv::Scalar(0), cv::Scalar(4));
+        frame += noise;
+        frames.gray.push_back(frame);
+    }
+    binarizeFrames(frames);
+    return frames;
+}
+
+/**
+ * @brief Scales recorded frames to size. The per-pixel median of the frames is used as background
+ */
+Frames recordedFrames(const std::vector<cv::Mat>& recorded, cv::Size size) {
+    Frames frames;
+    frames.source = "recorded";
+    frames.density = "-";
+    frames.size = size;
+    for (const cv::Mat& image : recorded) {
+        cv::Mat scaled;
+        cv::resize(image, scaled, size, 0, 0, cv::INTER_LINEAR);
+        frames.gray.push_back(scaled);
+    }
+
+    frames.background = cv::Mat(size, CV_8UC1);
+    std::vector<uchar> values(frames.gray.size());
+    for (int y = 0; y < size.height; y++) {
+        for (int x = 0; x < size.width; x++) {
+            for (size_t i = 0; i < frames.gray.size(); i++) {
+                values[i] = frames.gray[i].at<uchar>(y, x);
+            }
+            std::nth_element(values.begin(), values.begin() + values.size() / 2, values.end());
+            frames.background.at<uchar>(y, x) = values[values.size() / 2];
+        }
+    }
+    binarizeFrames(frames);
+    return frames;
+}
+
+std::vector<cv::Mat> loadRecorded(const std::string& folder) {
+    std::vector<std::string> paths;
+    boost::system::error_code ec;
+    for (fs::directory_iterator it(folder, ec), end; !ec && it != end; it.increment(ec)) {
+        const std::string extension = it->path().extension().string();
+        if (extension == ".png" || extension == ".bmp" || extension == ".tif") {
+            paths.push_back(it->path().string());
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+
+    std::vector<cv::Mat> images;
+    for (const auto& path : paths) {
+        cv::Mat image = cv::imread(path, cv::IMREAD_GRAYSCALE);
+        if (!image.empty()) {
+            images.push_back(image);
+        }
+    }
+    return images;
+}
+
+/**
+ * @brief Runs process over frames, cycling through the frames, until at least minTimeMs has been
+ * spent in doProcessing(). Copying the input frame is not included in the measured time
+ */
+Result run(const ProcessCase& processCase, const Frames& frames, double minTimeMs) {
+    const std::vector<cv::Mat>& inputs =
+        processCase.input == Input::Gray ? frames.gray : frames.binary;
+    std::unique_ptr<ProcessBase> process = processCase.create();
+    Experiment experiment;
+    cv::Mat img, bg;
+
+    auto runOnce = [&](long i) {
+        inputs[i % inputs.size()].copyTo(img);
+        frames.background.copyTo(bg);
+        const auto start = Clock::now();
+        process->doProcessing(img, bg, experiment);
+        return Clock::now() - start;
+    };
+
+    // Warm up caches and lazily allocated buffers
+    for (long i = 0; i < 2; i++) {
+        runOnce(i);
+    }
+
+    Clock::duration total(0);
+    long iterations = 0;
+    const auto minTime = std::chrono::duration<double, std::milli>(minTimeMs);
+    while (total < minTime || iterations < 5) {
+        total += runOnce(iterations);
+        iterations++;
+    }
+
+    const double ns = std::chrono::duration<double, std::nano>(total).count();
+    Result result;
+    result.process = processCase.name;
+    result.source = frames.source;
+    result.density = frames.density;
+    result.size = frames.size;
+    result.iterations = iterations;
+    result.nsPerPixel = ns / iterations / frames.size.area();
+    result.fps = iterations / (ns * 1e-9);
+    return result;
+}
+
+bool writeCsv(const std::string& path, const std::vector<Result>& results) {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        return false;
+    }
+    out << "process,source,density,width,height,iterations,ns_per_pixel,frames_per_second\n";
+    for (const auto& r : results) {
+        out << "\"" << r.process << "\"," << r.source << "," << r.density << ","
+            << r.size.width << "," << r.size.height << "," << r.iterations << ","
+            << r.nsPerPixel << "," << r.fps << "\n";
+    }
+    return !out.fail();
+}
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        const bool hasValue = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--images") && hasValue) {
+            options.imageFolder = argv[++i];
+        } else if (!std::strcmp(argv[i], "--csv") && hasValue) {
+            options.csvPath = argv[++i];
+        } else if (!std::strcmp(argv[i], "--min-time") && hasValue) {
+            options.minTimeMs = std::atof(argv[++i]);
+        } else if (!std::strcmp(argv[i], "--filter") && hasValue) {
+            options.filter = argv[++i];
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::printf(
+            "Usage: %s [--images <folder>] [--csv <path>] [--min-time <ms>] [--filter <process>]\n",
+            argv[0]);
+        return 1;
+    }
+
+    const std::vector<cv::Size> sizes = {{640, 128}, {1024, 256}, {2048, 512}};
+    const std::vector<std::pair<std::string, double>> densities = {{"sparse", 25},
+                                                                    {"dense", 400}};
+
+    std::vector<Frames> frameSets;
+    for (const auto& size : sizes) {
+        for (const auto& density : densities) {
+            frameSets.push_back(syntheticFrames(size, density.first, density.second));
+        }
+    }
+    if (!options.imageFolder.empty()) {
+        const std::vector<cv::Mat> recorded = loadRecorded(options.imageFolder);
+        if (recorded.empty()) {
+            std::printf("No images found in %s\n", options.imageFolder.c_str());
+            return 1;
+        }
+        for (const auto& size : sizes) {
+            frameSets.push_back(recordedFrames(recorded, size));
+        }
+    }
+
+    std::printf("%-20s %-10s %-8s %11s %12s %12s\n", "Process", "Source", "Density", "Resolution",
+                "ns/pixel", "frames/s");
+    std::vector<Result> results;
+    for (const auto& processCase : processCases()) {
+        if (!options.filter.empty() && processCase.name.find(options.filter) == std::string::npos) {
+            continue;
+        }
+        for (const auto& frames : frameSets) {
+            const Result r = run(processCase, frames, options.minTimeMs);
+            const std::string resolution =
+                std::to_string(r.size.width) + "x" + std::to_string(r.size.height);
+            std::printf("%-20s %-10s %-8s %11s %12.3f %12.1f\n", r.process.c_str(),
+                        r.source.c_str(), r.density.c_str(), resolution.c_str(), r.nsPerPixel,
+                        r.fps);
+            results.push_back(r);
+        }
+    }
+
+    if (!options.csvPath.empty() && !writeCsv(options.csvPath, results)) {
+        std::printf("Could not write %s\n", options.csvPath.c_str());
+        return 1;
+    }
+    return 0;
+}
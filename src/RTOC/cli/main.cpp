@@ -0,0 +1,320 @@
+/**
+ * Headless batch runner.
+ *
+ * Runs the analysis and export of a recorded experiment without the GUI, from a process preset
+ * (stored through the Configurator) and an experiment setup (stored through "Export setup" in the
+ * Experiment tab). The experiment is written to <output>/<name>, as when run from the GUI.
+ *
+ * Multiple experiments are reprocessed concurrently by listing them in a job file, given through
+ * --jobs instead of --setup and --input. Each line of the file holds the setup, the input and
+ * optionally the name of an experiment, separated by whitespace. Lines starting with # are ignored.
+ *
+ * A parameter sweep evaluates combinations of process and setup parameter values on a recorded
+ * experiment, given through --sweep. Each line of the sweep file holds a process index (or
+ * "setup"), a parameter name and its values, separated by whitespace. Values may be given as
+ * ranges, first:step:last. The object count of each combination is written to --results.
+ *
+ * Usage: RTOC_cli --preset <preset> --setup <setup.xml> --input <folder|list.txt|video>
+ *                 [--images <folder>] [--output <path>] [--name <experiment name>] [--overwrite]
+ *                 [--prefetch-window <n>] [--prefetch-threads <n>]
+ *        RTOC_cli --preset <preset> --jobs <jobs.txt> [--output <path>] [--overwrite]
+ *                 [--prefetch-window <n>] [--threads <n>] [--max-jobs <n>]
+ *                 [--memory-budget <MB>]
+ *        RTOC_cli --preset <preset> --setup <setup.xml> --input <folder|list.txt|video>
+ *                 --sweep <sweep.txt> [--results <sweep.csv>] [--images <folder>]
+ *                 [--prefetch-window <n>] [--prefetch-threads <n>]
+ */
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <boost/filesystem.hpp>
+
+#include <opencv2/videoio.hpp>
+
+#include "../lib/analyzer.h"
+#include "../lib/batchrunner.h"
+#include "../lib/batchscheduler.h"
+#include "../lib/framefinder.h"
+#include "../lib/parametersweep.h"
+
+namespace {
+struct Options {
+    BatchJob job;
+    std::string jobsPath;
+    BatchSchedulerConfig config;
+    std::string sweepPath;
+    std::string resultsPath = "sweep.csv";
+};
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    BatchJob& job = options.job;
+    std::string& jobsPath = options.jobsPath;
+    BatchSchedulerConfig& config = options.config;
+    for (int i = 1; i < argc; i++) {
+        const bool hasValue = i + 1 < argc;
+        if (!std::strcmp(argv[i], "--sweep") && hasValue) {
+            options.sweepPath = argv[++i];
+        } else if (!std::strcmp(argv[i], "--results") && hasValue) {
+            options.resultsPath = argv[++i];
+        } else if (!std::strcmp(argv[i], "--jobs") && hasValue) {
+            jobsPath = argv[++i];
+        } else if (!std::strcmp(argv[i], "--threads") && hasValue) {
+            config.threads = static_cast<unsigned int>(std::atoi(argv[++i]));
+        } else if (!std::strcmp(argv[i], "--max-jobs") && hasValue) {
+            config.maxConcurrentJobs = static_cast<unsigned int>(std::atoi(argv[++i]));
+        } else if (!std::strcmp(argv[i], "--memory-budget") && hasValue) {
+            config.memoryBudget = static_cast<size_t>(std::atol(argv[++i])) * 1024 * 1024;
+        } else if (!std::strcmp(argv[i], "--preset") && hasValue) {
+            job.presetPath = argv[++i];
+        } else if (!std::strcmp(argv[i], "--setup") && hasValue) {
+            job.setupPath = argv[++i];
+        } else if (!std::strcmp(argv[i], "--input") && hasValue) {
+            job.inputPath = argv[++i];
+        } else if (!std::strcmp(argv[i], "--images") && hasValue) {
+            job.imageFolder = argv[++i];
+        } else if (!std::strcmp(argv[i], "--output") && hasValue) {
+            job.outputPath = argv[++i];
+        } else if (!std::strcmp(argv[i], "--name") && hasValue) {
+            job.experimentName = argv[++i];
+        } else if (!std::strcmp(argv[i], "--overwrite")) {
+            job.overwrite = true;
+        } else if (!std::strcmp(argv[i], "--prefetch-window") && hasValue) {
+            job.prefetchWindow = static_cast<size_t>(std::atol(argv[++i]));
+        } else if (!std::strcmp(argv[i], "--prefetch-threads") && hasValue) {
+            job.prefetchThreads = static_cast<unsigned int>(std::atoi(argv[++i]));
+        } else {
+            return false;
+        }
+    }
+    if (job.presetPath.empty() || job.prefetchWindow == 0) {
+        return false;
+    }
+    if (!jobsPath.empty()) {
+        return job.setupPath.empty() && job.inputPath.empty() && job.experimentName.empty() &&
+               options.sweepPath.empty();
+    }
+    return !job.setupPath.empty() && !job.inputPath.empty();
+}
+
+/**
+ * @brief Reads a job file, each line of which holds the setup, input and optional experiment name
+ * of a job. Other options are taken from the template job
+ */
+bool readJobs(const std::string& path, const BatchJob& jobTemplate, BatchScheduler& scheduler) {
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        BatchJob job = jobTemplate;
+        if (!(fields >> job.setupPath) || job.setupPath[0] == '#') {
+            continue;
+        }
+        if (!(fields >> job.inputPath)) {
+            return false;
+        }
+        fields >> job.experimentName;
+        scheduler.addJob(job);
+    }
+    return scheduler.jobCount() > 0;
+}
+
+int runJobs(const std::string& jobsPath, const BatchJob& jobTemplate,
+            const BatchSchedulerConfig& config) {
+    BatchScheduler scheduler(config);
+    if (!readJobs(jobsPath, jobTemplate, scheduler)) {
+        std::fprintf(stderr, "Error: Could not read job file %s\n", jobsPath.c_str());
+        return 1;
+    }
+    std::printf("Running %zu experiments on %u threads, at most %u at a time\n",
+                scheduler.jobCount(), scheduler.threads(), scheduler.maxConcurrentJobs());
+    scheduler.setProgressCallback([](size_t index, const BatchResult& result) {
+        if (result.success) {
+            std::printf("[%zu] %ld frames analyzed in %.1f s, written to %s\n", index,
+                        result.frames, result.seconds, result.experimentFolder.c_str());
+        } else {
+            std::fprintf(stderr, "[%zu] Error: %s\n", index, result.error.c_str());
+        }
+        std::fflush(stdout);
+    });
+
+    const auto start = std::chrono::steady_clock::now();
+    const std::vector<BatchResult> results = scheduler.run();
+    const double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    long frames = 0;
+    size_t failed = 0;
+    for (const auto& result : results) {
+        frames += result.frames;
+        failed += result.success ? 0 : 1;
+    }
+    std::printf("%zu of %zu experiments analyzed, %ld frames in %.1f s (%.1f frames/s)\n",
+                results.size() - failed, results.size(), frames, seconds,
+                seconds > 0 ? frames / seconds : 0.0);
+    return failed > 0 ? 2 : 0;
+}
+
+/**
+ * @brief Reads a sweep file, each line of which holds a process index or "setup", a parameter name
+ * and its values. Values given as first:step:last are expanded to a range
+ */
+bool readSweep(const std::string& path, ParameterSweep& sweep) {
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string target;
+        if (!(fields >> target) || target[0] == '#') {
+            continue;
+        }
+        SweepAxis axis;
+        axis.process = target == "setup" ? -1 : std::stoi(target);
+        if (!(fields >> axis.parameter)) {
+            return false;
+        }
+        std::string value;
+        while (fields >> value) {
+            double first, step, last;
+            char separator1, separator2;
+            std::istringstream range(value);
+            if (range >> first >> separator1 >> step >> separator2 >> last && separator1 == ':' &&
+                separator2 == ':') {
+                const auto values = ParameterSweep::range(first, last, step);
+                axis.values.insert(axis.values.end(), values.begin(), values.end());
+            } else {
+                axis.values.push_back(value);
+            }
+        }
+        sweep.addAxis(axis);
+    }
+    return !sweep.axes().empty();
+}
+
+int runSweep(const Options& options) {
+    const BatchJob& job = options.job;
+    Setup setup;
+    if (!loadExperimentSetup(job.setupPath, setup)) {
+        std::fprintf(stderr, "Error: Could not load experiment setup %s\n", job.setupPath.c_str());
+        return 2;
+    }
+    // As in runBatchJob(), recorded input is analyzed in full
+    setup.recordingTime = 0;
+    Analyzer analyzer;
+    if (!analyzer.loadSetup(job.presetPath)) {
+        std::fprintf(stderr, "Error: Could not load process preset %s\n", job.presetPath.c_str());
+        return 2;
+    }
+    const std::vector<std::unique_ptr<ProcessBase>>& processes = *analyzer.getProcessContainerPtr();
+
+    ParameterSweep sweep(processes, setup);
+    try {
+        if (!readSweep(options.sweepPath, sweep)) {
+            std::fprintf(stderr, "Error: Could not read sweep file %s\n",
+                         options.sweepPath.c_str());
+            return 1;
+        }
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "Error: %s\n", e.what());
+        return 1;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<SweepResult> results;
+    const boost::filesystem::path input(job.inputPath);
+    std::vector<std::string> files;
+    if (boost::filesystem::is_directory(input)) {
+        framefinder::read_image_folder(job.inputPath, files);
+    } else if (input.extension() == ".txt") {
+        const std::string imageFolder =
+            job.imageFolder.empty() ? input.parent_path().string() : job.imageFolder;
+        framefinder::read_frame_list(job.inputPath, files);
+        for (auto& file : files) {
+            file = imageFolder + "/" + file;
+        }
+    } else {
+        cv::VideoCapture video(job.inputPath);
+        if (video.isOpened()) {
+            results = sweep.run([&video](cv::Mat& frame) {
+                if (!video.read(frame)) {
+                    return false;
+                }
+                if (frame.channels() == 3) {
+                    cv::cvtColor(frame, frame, cv::COLOR_BGR2GRAY);
+                }
+                return true;
+            });
+        }
+    }
+    if (!files.empty()) {
+        const unsigned int prefetchThreads =
+            job.prefetchThreads > 0 ? job.prefetchThreads
+                                    : std::max(1u, std::thread::hardware_concurrency() / 2);
+        results = sweep.run(files, job.prefetchWindow, prefetchThreads);
+    }
+    if (sweep.frames() == 0) {
+        std::fprintf(stderr, "Error: Could not read input %s\n", job.inputPath.c_str());
+        return 2;
+    }
+    const double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    if (!sweep.writeResults(options.resultsPath, results)) {
+        std::fprintf(stderr, "Error: Could not write %s\n", options.resultsPath.c_str());
+        return 2;
+    }
+    std::printf("%zu combinations of %ld frames evaluated in %.1f s, written to %s\n",
+                results.size(), sweep.frames(), seconds, options.resultsPath.c_str());
+    std::printf("%zu process evaluations and %zu processed images per frame "
+                "(%zu without sharing)\n",
+                sweep.processEvaluations(), sweep.chainEvaluations(),
+                results.size() * processes.size());
+    return 0;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::printf(
+            "Usage: %s --preset <preset> --setup <setup.xml> --input <folder|list.txt|video>\n"
+            "       [--images <folder>] [--output <path>] [--name <experiment name>] "
+            "[--overwrite]\n"
+            "       [--prefetch-window <n>] [--prefetch-threads <n>]\n"
+            "   or: %s --preset <preset> --jobs <jobs.txt> [--output <path>] [--overwrite]\n"
+            "       [--prefetch-window <n>] [--threads <n>] [--max-jobs <n>] "
+            "[--memory-budget <MB>]\n"
+            "   or: %s --preset <preset> --setup <setup.xml> --input <folder|list.txt|video>\n"
+            "       --sweep <sweep.txt> [--results <sweep.csv>] [--images <folder>]\n"
+            "       [--prefetch-window <n>] [--prefetch-threads <n>]\n",
+            argv[0], argv[0], argv[0]);
+        return 1;
+    }
+    if (!options.jobsPath.empty()) {
+        return runJobs(options.jobsPath, options.job, options.config);
+    }
+    if (!options.sweepPath.empty()) {
+        return runSweep(options);
+    }
+
+    const BatchResult result = runBatchJob(options.job);
+    if (!result.success) {
+        std::fprintf(stderr, "Error: %s\n", result.error.c_str());
+        return 2;
+    }
+    std::printf("%ld frames analyzed in %.1f s (%.1f frames/s), written to %s\n", result.frames,
+                result.seconds, result.seconds > 0 ? result.frames / result.seconds : 0.0,
+                result.experimentFolder.c_str());
+    return 0;
+}
@@ -14,13 +14,30 @@ cv::Mat& AcquisitionInterface::getNextImage(bool& successful) {
         switch (m_source) {
             case AcqSource::IronManCamera: {
 #ifdef BUILD_IRONMAN
-                auto imageData = m_acquisitor->requestImageDataBlocking(successful);
-                m_ironmanImage = cv::Mat(m_ironManDimensions.second, m_ironManDimensions.first,
-                                         CV_8UC1, imageData->data());
+                // The analyzer is done with the previous frame once it requests a new one, so its
+                // DMA buffer can be handed back to the framegrabber
+                releaseIronManFrame();
+                successful = m_acquisitor->acquireFrame(m_ironmanFrame, 1000);
+                if (successful) {
+                    m_ironmanFrameHeld = true;
+                    // Wrap DMA memory - no copy
+                    m_ironmanImage = cv::Mat(m_ironManDimensions.second, m_ironManDimensions.first,
+                                             CV_8UC1, m_ironmanFrame.data);
+                }
                 newImage = &m_ironmanImage;
 #endif
                 break;
             }
+            case AcqSource::Simulator: {
+                releaseSimulatedFrame();
+                if (!m_simulatedCamera->isRunning()) {
+                    m_simulatedCamera->start();
+                }
+                successful = m_simulatedCamera->acquireFrame(m_simulatedFrame, 1000);
+                m_simulatedFrameHeld = successful;
+                newImage = &m_simulatedFrame.image;
+                break;
+            }
             case AcqSource::Webcam: {
                 newImage = m_genericCameraWidget->getNextImage(successful);
                 break;
@@ -38,12 +55,15 @@ cv::Mat& AcquisitionInterface::getNextImage(bool& successful) {
         if (m_ffEnabled) {
             if (m_lastImage.empty()) {
                 // last image needs to be initialized
-                m_lastImage = *newImage;
+                m_lastImage = newImage->clone();
             }
             if (framefinder::hasChanged(m_lastImage, *newImage, m_threshold)) {
                 // A sufficient change between current and last image has been detected, return the
-                // newly acquired image
-                m_lastImage = *newImage;
+                // newly acquired image. Camera frames live in DMA buffers which are released on the
+                // next acquisition, so the reference frame must be copied
+                bool dmaSource =
+                    m_source == AcqSource::IronManCamera || m_source == AcqSource::Simulator;
+                m_lastImage = dmaSource ? newImage->clone() : *newImage;
                 return m_lastImage;
             } else {
                 // Continue querying acquisition source until hasChanged() returns true
@@ -60,4 +80,35 @@ void AcquisitionInterface::reset() {
     // Reset all acquisition devices such that they are ready to be queried for images from their
     // initial state/position
     m_imageDisplayerWidget->reset();
+
+    // Stop the simulated camera. Its frame counters are kept until the next experiment starts it
+    if (m_simulatedCamera) {
+        releaseSimulatedFrame();
+        m_simulatedCamera->stop();
+    }
+
+#ifdef BUILD_IRONMAN
+    // Return all DMA buffers to the framegrabber, such that live view resumes
+    m_ironmanFrameHeld = false;
+    m_ironmanImage.release();
+    if (m_acquisitor) {
+        m_acquisitor->detachConsumer();
+    }
+#endif
 }
+
+void AcquisitionInterface::releaseSimulatedFrame() {
+    if (m_simulatedFrameHeld) {
+        m_simulatedCamera->releaseFrame(m_simulatedFrame);
+        m_simulatedFrameHeld = false;
+    }
+}
+
+#ifdef BUILD_IRONMAN
+void AcquisitionInterface::releaseIronManFrame() {
+    if (m_ironmanFrameHeld) {
+        m_acquisitor->releaseFrame(m_ironmanFrame);
+        m_ironmanFrameHeld = false;
+    }
+}
+#endif
@@ -12,12 +12,13 @@
 #include <QMetaType>
 #include "genericcamerawidget.h"
 #include "imagedisplayerwidget.h"
+#include "simulatedcamerawidget.h"
 
 #ifdef BUILD_IRONMAN
 #include "ironman_lib/acquisitor_src/acquisitor.h"
 #endif
 
-enum class AcqSource { IronManCamera, Folder, Webcam };
+enum class AcqSource { IronManCamera, Folder, Webcam, Simulator };
 Q_DECLARE_METATYPE(AcqSource)
 
 class AcquisitionInterface : public QObject {
@@ -32,6 +33,26 @@ public:
 public:
     void setFFState(int state) { m_ffEnabled = state; }
     void setFFThresh(int value) { m_threshold = value; }
+    void setSimulatedCamera(SimulatedCamera* camera) { m_simulatedCamera = camera; }
+
+    // Read-ahead of the image folder source
+    void setPrefetchConfig(int window, int threads) {
+        m_imageDisplayerWidget->setPrefetchConfig(window, threads);
+    }
+    PrefetchStats prefetchStats() const {
+        return m_source == AcqSource::Folder ? m_imageDisplayerWidget->prefetchStats()
+                                             : PrefetchStats();
+    }
+
+    // Frames dropped by the camera source before reaching the analyzer
+    long droppedFrames() const {
+#ifdef BUILD_IRONMAN
+        if (m_source == AcqSource::IronManCamera && m_acquisitor != nullptr) {
+            return static_cast<long>(m_acquisitor->droppedFrames());
+        }
+#endif
+        return 0;
+    }
 
 private:
     bool m_ffEnabled = false;
@@ -42,15 +63,27 @@ private:
     ImageDisplayerWidget* m_imageDisplayerWidget;
     GenericCameraWidget* m_genericCameraWidget;
 
+    void releaseSimulatedFrame();
+
+    // Frame currently lent from the simulated camera
+    SimulatedCamera* m_simulatedCamera = nullptr;
+    SimulatedFrame m_simulatedFrame;
+    bool m_simulatedFrameHeld = false;
+
 #ifdef BUILD_IRONMAN
 public:
     void setAcquisitor(Acquisitor* acq) { m_acquisitor = acq; }
     void setIronManDimensions(QPair<int, int> dim) { m_ironManDimensions = dim; }
 
 private:
-    Acquisitor* m_acquisitor;
+    void releaseIronManFrame();
+
+    Acquisitor* m_acquisitor = nullptr;
     QPair<int, int> m_ironManDimensions;
 
+    // DMA buffer currently lent from the acquisitor. m_ironmanImage wraps its memory without copying
+    FrameBuffer m_ironmanFrame;
+    bool m_ironmanFrameHeld = false;
     cv::Mat m_ironmanImage;
 #endif
 
@@ -1,16 +1,26 @@
 #include "experimentrunner.h"
 #include "ui_experimentrunner.h"
 
+#include <QFontDatabase>
+#include <QGuiApplication>
 #include <QMessageBox>
 #include <QPushButton>
+#include <QScreen>
+#include <QScrollBar>
 #include <QTimer>
 
 #include <QFuture>
 #include <QtConcurrent/QtConcurrent>
 
-ExperimentRunner::ExperimentRunner(Analyzer* analyzer, Setup setup, QWidget* parent)
-    : QDialog(parent), ui(new Ui::ExperimentRunner), m_setup(setup), m_analyzer(analyzer) {
+ExperimentRunner::ExperimentRunner(Analyzer* analyzer, AcquisitionInterface* iface, Setup setup,
+                                   QWidget* parent)
+    : QDialog(parent),
+      ui(new Ui::ExperimentRunner),
+      m_setup(setup),
+      m_analyzer(analyzer),
+      m_interface(iface) {
     ui->setupUi(this);
+    ui->latencyReport->setFont(QFontDatabase::systemFont(QFontDatabase::FixedFont));
 
     // change "Abort" button to stop acquisition
     ui->buttonBox->button(QDialogButtonBox::Abort)->setText("Finish acquisition");
@@ -28,6 +38,14 @@ ExperimentRunner::ExperimentRunner(Analyzer* analyzer, Setup setup, QWidget* par
     m_time.start();
     m_timer->start();
 
+    // Live view of the acquired frames, sampled at the display refresh rate independently of the
+    // acquisition rate
+    m_liveViewTimer = new QTimer(this);
+    const double refreshRate = QGuiApplication::primaryScreen()->refreshRate();
+    m_liveViewTimer->setInterval(static_cast<int>(1000 / (refreshRate > 0 ? refreshRate : 60)));
+    connect(m_liveViewTimer, &QTimer::timeout, this, &ExperimentRunner::liveViewTimerElapsed);
+    m_liveViewTimer->start();
+
     // Start the experiment
     stateChanged(State::Acquiring);
 }
@@ -56,10 +74,14 @@ void ExperimentRunner::stateChanged(State state) {
         case State::Storing: {
             // ACQUISITION FINISHED - wait for analyzer to finish writing data
             ui->infoLabel->setText("Storing remaining images & data to disk...");
+            m_liveViewTimer->stop();
             ui->buttonBox->button(QDialogButtonBox::Abort)->setEnabled(false);
 
             // make sure that the actual value of the acquired images is written
             ui->acqCount->setText(QString::number(m_analyzer->acquiredImagesCnt()));
+            updateDroppedFrames();
+            updateDecodeStats();
+            updateLatency();
 
             ui->acqProgress->setMaximum(0);
             ui->acqProgress->setValue(0);
@@ -77,6 +99,8 @@ void ExperimentRunner::stateChanged(State state) {
             ui->acqProgress->setValue(1);
 
             ui->processImageN->setText(ui->acqCount->text());
+            updateDroppedFrames();
+            updateLatency();
 
             ui->infoLabel->setText("Finished experiment");
             setWindowTitle("Finished experiment");
@@ -95,6 +119,19 @@ void ExperimentRunner::stateChanged(State state) {
     }
 }
 
+void ExperimentRunner::liveViewTimerElapsed() {
+    cv::Mat frame;
+    if (!m_analyzer->liveFrame().take(frame)) {
+        return;
+    }
+    // Only the downscaled frame is converted and uploaded to the display
+    cv::Mat display;
+    downscaleToFit(frame, ui->liveView->width(), ui->liveView->height(), display);
+    ui->liveView->setPixmap(
+        QPixmap::fromImage(QImage(display.data, display.cols, display.rows,
+                                  static_cast<int>(display.step), QImage::Format_Grayscale8)));
+}
+
 void ExperimentRunner::guiUpdateTimerElapsed() {
     int ms = m_time.elapsed();
     if (m_state != State::Finished) {
@@ -118,6 +155,57 @@ void ExperimentRunner::guiUpdateTimerElapsed() {
         // Set current image progress
         ui->acqCount->setText(QString::number(acquiredImages));
     }
+
+    if (m_state != State::Finished) {
+        updateDroppedFrames();
+        updateLatency();
+    }
+    if (m_state == State::Acquiring) {
+        updateDecodeStats();
+    }
+}
+
+void ExperimentRunner::updateDroppedFrames() {
+    // Report frames which have been dropped due to the queue policies set in the experiment setup,
+    // and frames the camera source could not hand over to the analyzer
+    ui->droppedAcquisition->setText(QString::number(m_interface->droppedFrames()));
+    ui->droppedAnalysis->setText(
+        QString::number(m_analyzer->droppedFrames(QueueType::Analysis)));
+    ui->droppedStorage->setText(
+        QString::number(m_analyzer->droppedFrames(QueueType::StorageRaw) +
+                        m_analyzer->droppedFrames(QueueType::StorageProcessed)));
+}
+
+void ExperimentRunner::updateDecodeStats() {
+    // Report the cost of decoding images from an image folder, compared to the time the analyzer
+    // spends on each image. Only available when acquiring from an image folder
+    const PrefetchStats stats = m_interface->prefetchStats();
+    if (stats.decodedImages == 0 || stats.consumedImages == 0) {
+        return;
+    }
+    ui->decodeTime->setText(QString::number(stats.decodeMs / stats.decodedImages, 'f', 2));
+    ui->analysisTime->setText(QString::number(stats.consumerMs / stats.consumedImages, 'f', 2));
+    ui->decodeWait->setText(QString::number(stats.waitMs / stats.consumedImages, 'f', 2));
+}
+
+void ExperimentRunner::updateLatency() {
+    // Report the latency of each pipeline stage, the current depth of the frame queues and the
+    // number of frames dropped along the pipeline
+    QString report = QString("Queue depth: analysis %1, storage %2\n"
+                             "Dropped frames: camera %3, analysis %4, storage %5\n\n")
+                         .arg(m_analyzer->queueDepth(QueueType::Analysis))
+                         .arg(m_analyzer->queueDepth(QueueType::StorageRaw) +
+                              m_analyzer->queueDepth(QueueType::StorageProcessed))
+                         .arg(m_interface->droppedFrames())
+                         .arg(m_analyzer->droppedFrames(QueueType::Analysis))
+                         .arg(m_analyzer->droppedFrames(QueueType::StorageRaw) +
+                              m_analyzer->droppedFrames(QueueType::StorageProcessed));
+    report += QString::fromStdString(m_analyzer->latency().report());
+
+    // Keep the scroll position, as the report is replaced on each GUI update
+    const int scroll = ui->latencyReport->verticalScrollBar()->value();
+    ui->latencyReport->setPlainText(report);
+    ui->latencyReport->verticalScrollBar()->setValue(scroll);
 }
 
 void ExperimentRunner::reject() {
@@ -8,6 +8,7 @@
 #include <QWidget>
 
 #include "../lib/analyzer.h"
+#include "acquisitioninterface.h"
 
 namespace Ui {
 class ExperimentRunner;
@@ -24,7 +25,8 @@ class ExperimentRunner : public QDialog {
     Q_OBJECT
 
 public:
-    explicit ExperimentRunner(Analyzer* analyzer, Setup setup, QWidget* parent = 0);
+    explicit ExperimentRunner(Analyzer* analyzer, AcquisitionInterface* iface, Setup setup,
+                              QWidget* parent = 0);
     ~ExperimentRunner();
     Ui::ExperimentRunner* ui;
 
@@ -33,18 +35,24 @@ public slots:
 
 private slots:
     void guiUpdateTimerElapsed();
+    void liveViewTimerElapsed();
     void on_buttonBox_clicked(QAbstractButton* button);
 
 private:
     enum class State { Acquiring, Storing, Finished };
     void stateChanged(State state);
     void checkAnalyzerStatusMessage(const int status) const;
+    void updateDroppedFrames();
+    void updateDecodeStats();
+    void updateLatency();
 
     State m_state;
     Setup m_setup;
 
     Analyzer* m_analyzer;
+    AcquisitionInterface* m_interface;
     QTimer* m_timer;
+    QTimer* m_liveViewTimer;
     QTime m_time;
 
     // A future is set for each state change
@@ -39,6 +39,26 @@ ExperimentSetup::ExperimentSetup(Analyzer* analyzer, AcquisitionInterface* iface
     connect(ui->experimentType, QOverload<int>::of(&QComboBox::currentIndexChanged), this,
             &ExperimentSetup::updateCurrentSetup);
 
+    // Populate queue policies
+    for (const auto& item : qpDescriptors.keys()) {
+        ui->analysisQueuePolicy->addItem(qpDescriptors[item], QVariant::fromValue(item));
+        ui->storageQueuePolicy->addItem(qpDescriptors[item], QVariant::fromValue(item));
+    }
+    ui->analysisQueuePolicy->setToolTip(
+        "<nobr>Action taken when the analysis queue is full,</nobr> ie. when object finding is "
+        "falling behind acquisition.");
+    ui->storageQueuePolicy->setToolTip(
+        "<nobr>Action taken when an image writer queue is full,</nobr> ie. when writing images "
+        "to disk is falling behind acquisition.");
+
+    // Populate export formats
+    for (const auto& item : efDescriptors.keys()) {
+        ui->exportFormat->addItem(efDescriptors[item], QVariant::fromValue(item));
+    }
+    ui->exportFormat->setToolTip(
+        "<nobr>File format of the extracted data.</nobr> The binary format is considerably faster "
+        "to write and read for large experiments - see parsers/ for readers.");
+
     // Only allow alphanumeric characters in lineedit
     QRegExpValidator* validator = new QRegExpValidator();
     validator->setRegExp(QRegExp(QString("\\S+")));
@@ -48,6 +68,20 @@ ExperimentSetup::ExperimentSetup(Analyzer* analyzer, AcquisitionInterface* iface
 
     ui->rectime->setRange(0, 999999999);
 
+    ui->prefetchThreads->setValue(std::max(1, QThread::idealThreadCount() / 2));
+    ui->prefetchWindow->setToolTip(
+        "<nobr>Number of images decoded ahead of the analyzer</nobr> when acquiring from an image "
+        "folder.");
+    ui->earlyDecisionMargin->setToolTip(
+        "<nobr>Classify objects while they are still in the channel.</nobr> A label is committed "
+        "once the probability computed from the model terms passed so far is this far from the "
+        "decision boundary. Only supported by logistic regression models.");
+
+    ui->traceTimeline->setToolTip(
+        "<nobr>Record the time spent by each thread on each frame,</nobr> and write it to "
+        "&lt;experiment name&gt;_trace.json. Open the file in chrome://tracing or "
+        "ui.perfetto.dev to find the bottleneck of the pipeline.");
+
     connectWidgets();
 
     // Update current setup to load default GUI values
@@ -74,6 +108,19 @@ void ExperimentSetup::connectWidgets() {
     connect(ui->countThreshold, QOverload<int>::of(&QSpinBox::valueChanged),
             [=] { updateCurrentSetup(); });
     connect(ui->modelPath, &QLineEdit::textChanged, [=] { updateCurrentSetup(); });
+    connect(ui->earlyDecisionMargin, QOverload<double>::of(&QDoubleSpinBox::valueChanged),
+            [=] { updateCurrentSetup(); });
+    connect(ui->analysisQueueCapacity, QOverload<int>::of(&QSpinBox::valueChanged),
+            [=] { updateCurrentSetup(); });
+    connect(ui->storageQueueCapacity, QOverload<int>::of(&QSpinBox::valueChanged),
+            [=] { updateCurrentSetup(); });
+    connect(ui->analysisQueuePolicy, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            [=] { updateCurrentSetup(); });
+    connect(ui->storageQueuePolicy, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            [=] { updateCurrentSetup(); });
+    connect(ui->exportFormat, QOverload<int>::of(&QComboBox::currentIndexChanged),
+            [=] { updateCurrentSetup(); });
+    connect(ui->traceTimeline, &QCheckBox::clicked, [=] { updateCurrentSetup(); });
 }
 
 ExperimentSetup::~ExperimentSetup() {
@@ -88,12 +135,22 @@ void ExperimentSetup::updateCurrentSetup() {
     m_currentSetup.processedPrefix = ui->processedPrefix->text().toStdString();
     m_currentSetup.outputPath = ui->experimentPath->text().toStdString();
     m_currentSetup.modelPath = ui->modelPath->text().toStdString();
+    m_currentSetup.earlyDecisionMargin = ui->earlyDecisionMargin->value();
     m_currentSetup.experimentName = ui->experimentName->text().toStdString();
     m_currentSetup.outputPath = ui->experimentPath->text().toStdString();
     m_currentSetup.recordingTime = ui->rectime->value();
     m_currentSetup.countThreshold = ui->countThreshold->value();
     m_currentSetup.distanceThresholdInlet = ui->distanceThresholdInlet->value();
     m_currentSetup.distanceThresholdPath = ui->distanceThresholdPath->value();
+    m_currentSetup.analysisQueueCapacity = ui->analysisQueueCapacity->value();
+    m_currentSetup.storageQueueCapacity = ui->storageQueueCapacity->value();
+    m_currentSetup.analysisQueuePolicy =
+        ui->analysisQueuePolicy->currentData(Qt::UserRole).value<QueuePolicy>();
+    m_currentSetup.storageQueuePolicy =
+        ui->storageQueuePolicy->currentData(Qt::UserRole).value<QueuePolicy>();
+    m_currentSetup.exportFormat =
+        ui->exportFormat->currentData(Qt::UserRole).value<ExportFormat>();
+    m_currentSetup.traceTimeline = ui->traceTimeline->isChecked();
 
     m_currentSetup.extractData = false;
     m_currentSetup.runProcessing = true;
@@ -226,10 +283,16 @@ void ExperimentSetup::on_run_clicked() {
         // Update setup - just to be sure that we have the latest changes
         updateCurrentSetup();
 
+        m_interface->setPrefetchConfig(ui->prefetchWindow->value(),
+                                       ui->prefetchThreads->value());
+
         // we can run the experiment
-        ExperimentRunner runner(m_analyzer, m_currentSetup);
+        ExperimentRunner runner(m_analyzer, m_interface, m_currentSetup);
         runner.ui->experimentName->setText(ui->experimentName->text());
         runner.exec();
+
+        // Release the acquisition source, such that it is ready for the next experiment
+        m_interface->reset();
     }
 }
 
@@ -269,6 +332,25 @@ void ExperimentSetup::serialize(Archive& ar, const unsigned int version) {
     SERIALIZE_SPINBOX(ar, ui->distanceThresholdInlet, distanceThresholdInlet);
     SERIALIZE_SPINBOX(ar, ui->distanceThresholdPath, distanceThresholdPath);
     SERIALIZE_SPINBOX(ar, ui->countThreshold, countThreshold);
+    if (version > 0) {
+        SERIALIZE_SPINBOX(ar, ui->analysisQueueCapacity, analysisQueueCapacity);
+        SERIALIZE_SPINBOX(ar, ui->storageQueueCapacity, storageQueueCapacity);
+        SERIALIZE_COMBOBOX(ar, ui->analysisQueuePolicy, analysisQueuePolicy);
+        SERIALIZE_COMBOBOX(ar, ui->storageQueuePolicy, storageQueuePolicy);
+    }
+    if (version > 1) {
+        SERIALIZE_SPINBOX(ar, ui->prefetchWindow, prefetchWindow);
+        SERIALIZE_SPINBOX(ar, ui->prefetchThreads, prefetchThreads);
+    }
+    if (version > 2) {
+        SERIALIZE_COMBOBOX(ar, ui->exportFormat, exportFormat);
+    }
+    if (version > 3) {
+        SERIALIZE_SPINBOX(ar, ui->earlyDecisionMargin, earlyDecisionMargin);
+    }
+    if (version > 4) {
+        SERIALIZE_CHECKBOX(ar, ui->traceTimeline, traceTimeline);
+    }
     for (auto dataOption : ui->extractData->findChildren<QCheckBox*>()) {
         bool v = dataOption->isChecked();
         QString name = dataOption->text();
@@ -287,6 +369,7 @@ void ExperimentSetup::on_experimentType_currentIndexChanged(int index) {
     const auto type = ui->experimentType->currentData(Qt::UserRole).value<ExperimentTypes>();
     ui->setModelPath->setEnabled(false);
     ui->modelPath->setEnabled(false);
+    ui->earlyDecisionMargin->setEnabled(false);
 
     if (type == ExperimentTypes::Acquisition) {
         // disable storeProcessed stuff
@@ -308,6 +391,7 @@ void ExperimentSetup::on_experimentType_currentIndexChanged(int index) {
     if (type == ExperimentTypes::AcquisitionAndRealTimeID) {
         ui->setModelPath->setEnabled(true);
         ui->modelPath->setEnabled(true);
+        ui->earlyDecisionMargin->setEnabled(true);
     }
 }
 
@@ -355,3 +439,14 @@ void ExperimentSetup::on_setModelPath_clicked() {
     if (!filename.isNull())
         ui->modelPath->setText(filename);
 }
+
+void ExperimentSetup::on_exportSetup_clicked() {
+    auto filename = QFileDialog::getSaveFileName(this, "Export setup for RTOC_cli",
+                                                 QDir::currentPath(), "xml file (*.xml)");
+    if (filename.isNull())
+        return;
+    updateCurrentSetup();
+    if (!storeExperimentSetup(m_currentSetup, filename.toStdString())) {
+        QMessageBox::warning(this, "Error", QString("Could not write setup to %1").arg(filename));
+    }
+}
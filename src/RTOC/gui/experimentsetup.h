@@ -34,6 +34,20 @@ static QMap<ExperimentTypes, QString> etDescriptors{
 
 Q_DECLARE_METATYPE(ExperimentTypes)
 
+static QMap<QueuePolicy, QString> qpDescriptors{
+    {QueuePolicy::Block, "Block acquisition"},
+    {QueuePolicy::DropOldest, "Drop oldest frame"},
+    {QueuePolicy::DropNewest, "Drop newest frame"},
+    {QueuePolicy::DropStorage, "Drop storage only, keep analysis"}};
+
+Q_DECLARE_METATYPE(QueuePolicy)
+
+static QMap<ExportFormat, QString> efDescriptors{
+    {ExportFormat::Text, "Text"},
+    {ExportFormat::Binary, "Binary (columnar, .rtoc)"}};
+
+Q_DECLARE_METATYPE(ExportFormat)
+
 namespace Ui {
 class ExperimentSetup;
 }
@@ -65,6 +79,8 @@ private slots:
 
     void on_setModelPath_clicked();
 
+    void on_exportSetup_clicked();
+
 private:
     void setToolTips();
     void setupDataOptions();
@@ -83,4 +99,6 @@ private:
     QList<QCheckBox*> m_dataOptionCheckboxes;
 };
 
+BOOST_CLASS_VERSION(ExperimentSetup, 5)
+
 #endif  // EXPERIMENTSETUP_H
@@ -4,17 +4,14 @@
 cv::Mat* FolderAcquisition::getNextImage(bool& successful) {
     successful = true;
 
-    if (m_acqIndex < m_imageFileList.size()) {
-        m_image = cv::imread(m_imageFileList[m_acqIndex++].absoluteFilePath().toStdString(),
-                             cv::IMREAD_GRAYSCALE);
-    } else {
+    if (!m_prefetcher.next(m_image)) {
         successful = false;
         return &m_image;
     }
 
     if (!m_image.data) {
         successful = false;
-        m_acqIndex = 0;
+        m_prefetcher.seek(0);
     }
 
     return &m_image;
@@ -22,7 +19,8 @@ cv::Mat* FolderAcquisition::getNextImage(bool& successful) {
 
 
 void FolderAcquisition::reset() {
-    m_acqIndex = 0;
+    m_prefetcher.seek(0);
+    m_prefetcher.resetStats();
 }
 
 void FolderAcquisition::setPath(const QString& path) {
@@ -43,6 +41,12 @@ void FolderAcquisition::indexDirectory() {
 
     m_nImages = m_imageFileList.size();
 
+    std::vector<std::string> files;
+    for (const auto& fileInfo : m_imageFileList) {
+        files.push_back(fileInfo.absoluteFilePath().toStdString());
+    }
+    m_prefetcher.setFiles(files);
+
     /*
 
     Then, Update gui!
@@ -8,6 +8,7 @@
 #include "opencv/cv.hpp"
 
 #include "../lib/framefinder.h"
+#include "../lib/imageprefetcher.h"
 
 
 class FolderAcquisition {
@@ -17,16 +18,20 @@ public:
 
     void setPath(const QString& path);
 
+    void setPrefetchConfig(int window, int threads) { m_prefetcher.setConfig(window, threads); }
+    PrefetchStats prefetchStats() const { return m_prefetcher.stats(); }
+
 private:
     void indexDirectory();
 
     cv::Mat m_image;
 
-    int m_acqIndex;
     int m_nImages;
     QDir m_dir;
     QFileInfoList m_imageFileList;
 
+    ImagePrefetcher m_prefetcher;
+
 };
 
 
@@ -41,7 +41,12 @@ void GenericCameraWidget::showImage() {
     bool success = false;
     getNextImage(success);
     if (success) {
-        ui->image->setPixmap(QPixmap::fromImage(QImage(m_image.data, m_image.cols, m_image.rows, QImage::Format_Grayscale8)));
+        // Only the image downscaled to the label is converted and uploaded to the display
+        cv::Mat display;
+        downscaleToFit(m_image, ui->image->width(), ui->image->height(), display);
+        ui->image->setPixmap(QPixmap::fromImage(QImage(display.data, display.cols, display.rows,
+                                                       static_cast<int>(display.step),
+                                                       QImage::Format_Grayscale8)));
     }
 
 }
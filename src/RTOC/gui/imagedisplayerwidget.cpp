@@ -45,6 +45,27 @@ ImageDisplayerWidget::ImageDisplayerWidget(QWidget* parent)
     // slow hard drives can take multiple seconds.
     connect(&m_directoryIndexingWatcher, &QFutureWatcher<void>::finished, this,
             &ImageDisplayerWidget::directoryIndexingFinished);
+    connect(&m_previewWatcher, &QFutureWatcher<bool>::finished, this,
+            &ImageDisplayerWidget::previewFinished);
+
+    // Images decoded by the frame cache worker are displayed on the GUI thread
+    m_frameCache.setReadyCallback([this](size_t index) {
+        QMetaObject::invokeMethod(this, "frameReady", Qt::QueuedConnection,
+                                  Q_ARG(int, static_cast<int>(index)));
+    });
+    connect(ui->cacheSize, &QSpinBox::editingFinished, this,
+            &ImageDisplayerWidget::updateFrameCacheConfig);
+
+    // Thumbnails follow the size of the image label. Resizing invalidates the cached thumbnails,
+    // so the frame cache is only reconfigured once resizing has settled
+    m_resizeTimer.setSingleShot(true);
+    m_resizeTimer.setInterval(200);
+    connect(&m_resizeTimer, &QTimer::timeout, [=] {
+        updateFrameCacheConfig();
+        if (m_analyzer == nullptr && !m_imageFileList.isEmpty()) {
+            refreshImage();
+        }
+    });
 
     // Set default image text
     ui->image->setText("Please set an image folder path");
@@ -54,6 +75,10 @@ ImageDisplayerWidget::ImageDisplayerWidget(QWidget* parent)
 }
 
 ImageDisplayerWidget::~ImageDisplayerWidget() {
+    m_frameCache.setReadyCallback(nullptr);
+    // Cancel and wait for a running preview, which refers to the cache
+    m_previewRequest++;
+    m_previewWatcher.waitForFinished();
     delete ui;
 }
 
@@ -81,6 +106,9 @@ void ImageDisplayerWidget::directoryIndexingFinished() {
     m_directoryIndexingProgress->reset();
     delete m_directoryIndexingProgress;
 
+    m_displayIndex = -1;
+    updateFrameCacheConfig();
+
     // Set slider range
     ui->imageSlider->setRange(1, m_nImages);
 
@@ -105,28 +133,109 @@ void ImageDisplayerWidget::displayImage(int index) {
     ui->image->setText("");
     // display image at index from the current selected directory
     if (!m_imageFileList.isEmpty() && m_imageFileList.size() > index) {
+        // Prefetch along the direction of movement
+        m_frameCache.setPosition(index, index >= m_displayIndex ? 1 : -1);
+        m_displayIndex = index;
         if (m_analyzer != nullptr) {
-            // An analyzer has been set, load image as a cv::mat and process it through analyzer
-            m_image = cv::imread(m_imageFileList[index].absoluteFilePath().toStdString(),
-                                 cv::IMREAD_GRAYSCALE);
-            // Render unprocessed image
-            if (ui->showUnprocessed->isChecked()) {
-                ui->unprocessed->setPixmap(QPixmap::fromImage(
-                    QImage(m_image.data, m_image.cols, m_image.rows, QImage::Format_Grayscale8)));
+            // An analyzer has been set, process the image through the process chain of the
+            // analyzer. A running preview is cancelled, and restarted once it has stopped
+            m_previewIndex = index;
+            m_previewRequest++;
+            if (!m_previewWatcher.isRunning()) {
+                startPreview();
             }
-            // Process image and set preview image
-            m_analyzer->processSingleFrame(m_image);
-            ui->image->setPixmap(QPixmap::fromImage(
-                QImage(m_image.data, m_image.cols, m_image.rows, QImage::Format_Grayscale8)));
         } else {
-            // Regular mode, just display the image onto the label
-            ui->image->setPixmap(QPixmap(m_imageFileList[index].absoluteFilePath()));
+            // Regular mode, display the thumbnail of the image, once it has been decoded
+            m_displayPending = true;
+            frameReady(index);
         }
     }
 }
 
+void ImageDisplayerWidget::frameReady(int index) {
+    cv::Mat thumbnail;
+    if (!m_displayPending || index != m_displayIndex ||
+        !m_frameCache.thumbnail(index, thumbnail)) {
+        return;
+    }
+    m_displayPending = false;
+    ui->image->setPixmap(
+        QPixmap::fromImage(QImage(thumbnail.data, thumbnail.cols, thumbnail.rows,
+                                  static_cast<int>(thumbnail.step), QImage::Format_Grayscale8)));
+}
+
+/**
+ * @brief Configures the frame cache from the cache size and image rate. One second of playback is
+ * prefetched, and images are displayed as thumbnails bounded by the size of the image label,
+ * unless they are previewed through the analyzer
+ */
+void ImageDisplayerWidget::updateFrameCacheConfig() {
+    FrameCacheConfig config = m_frameCache.config();
+    config.memoryBudget = static_cast<size_t>(ui->cacheSize->value()) * 1024 * 1024;
+    config.lookahead = std::max<size_t>(16, static_cast<size_t>(ui->ips->value()));
+    config.keepFrames = m_analyzer != nullptr;
+    config.thumbnailWidth = m_analyzer != nullptr ? 0 : ui->image->width();
+    config.thumbnailHeight = m_analyzer != nullptr ? 0 : ui->image->height();
+    m_frameCache.setConfig(config);
+}
+
+void ImageDisplayerWidget::resizeEvent(QResizeEvent* event) {
+    QWidget::resizeEvent(event);
+    m_resizeTimer.start();
+}
+
+void ImageDisplayerWidget::startPreview() {
+    if (m_previewIndex < 0 || m_previewIndex >= m_imageFileList.size()) {
+        return;
+    }
+    // The chain is copied on the GUI thread, where it is edited
+    m_chainCache.setChain(*m_analyzer->getProcessContainerPtr());
+    m_runningPreviewRequest = m_previewRequest;
+    const unsigned int request = m_runningPreviewRequest;
+    const int index = m_previewIndex;
+    const std::string path = m_imageFileList[index].absoluteFilePath().toStdString();
+    m_previewWatcher.setFuture(QtConcurrent::run([this, index, path, request] {
+        if (m_chainCache.frameKey() != path) {
+            cv::Mat frame;
+            if (!m_frameCache.readFrame(static_cast<size_t>(index), frame)) {
+                return false;
+            }
+            m_chainCache.setFrame(frame, path);
+        }
+        return m_chainCache.process(m_preview, [this, request] {
+            return m_previewRequest != request;
+        });
+    }));
+}
+
+void ImageDisplayerWidget::previewFinished() {
+    if (m_runningPreviewRequest != m_previewRequest) {
+        // The image or the process chain has changed while processing
+        startPreview();
+        return;
+    }
+    if (!m_previewWatcher.result()) {
+        ui->image->setText("Could not read image");
+        return;
+    }
+    // Render unprocessed image
+    const cv::Mat& frame = m_chainCache.frame();
+    if (ui->showUnprocessed->isChecked()) {
+        ui->unprocessed->setPixmap(
+            QPixmap::fromImage(QImage(frame.data, frame.cols, frame.rows,
+                                      static_cast<int>(frame.step), QImage::Format_Grayscale8)));
+    }
+    // Set preview image
+    ui->image->setPixmap(
+        QPixmap::fromImage(QImage(m_preview.data, m_preview.cols, m_preview.rows,
+                                  static_cast<int>(m_preview.step), QImage::Format_Grayscale8)));
+}
+
 void ImageDisplayerWidget::setAnalyzer(Analyzer* analyzer) {
     m_analyzer = analyzer;
+    updateFrameCacheConfig();
+    // Previews are shown at full size, rather than being fitted to the available space
+    ui->image->setSizePolicy(QSizePolicy::Preferred, QSizePolicy::Preferred);
     // Show the "show unprocessed image" checkbox
     ui->showUnprocessed->show();
 
@@ -137,28 +246,26 @@ void ImageDisplayerWidget::setAnalyzer(Analyzer* analyzer) {
 cv::Mat* ImageDisplayerWidget::getNextImage(bool& successful) {
     successful = true;
 
-    if (m_acqIndex >= m_imageFileList.size()) {
+    if (m_prefetcher.position() >= m_prefetcher.size()) {
         if (ui->loop->isChecked()) {
-            m_acqIndex = 0;
+            m_prefetcher.seek(0);
         } else {
             successful = false;
             return &m_image;
         }
     }
 
-    m_image = cv::imread(m_imageFileList[m_acqIndex++].absoluteFilePath().toStdString(),
-                         cv::IMREAD_GRAYSCALE);
-
-    if (!m_image.data) {
+    if (!m_prefetcher.next(m_image) || !m_image.data) {
         successful = false;
-        m_acqIndex = 0;
+        m_prefetcher.seek(0);
     }
 
     return &m_image;
 }
 
 void ImageDisplayerWidget::reset() {
-    m_acqIndex = 0;
+    m_prefetcher.seek(0);
+    m_prefetcher.resetStats();
 }
 
 void ImageDisplayerWidget::indexDirectory() {
@@ -173,6 +280,13 @@ void ImageDisplayerWidget::indexDirectory() {
     framefinder::sort_qfilelist(m_imageFileList);
 
     m_nImages = m_imageFileList.size();
+
+    std::vector<std::string> files;
+    for (const auto& fileInfo : m_imageFileList) {
+        files.push_back(fileInfo.absoluteFilePath().toStdString());
+    }
+    m_prefetcher.setFiles(files);
+    m_frameCache.setFiles(files);
 }
 
 void ImageDisplayerWidget::on_play_clicked() {
@@ -217,6 +331,7 @@ void ImageDisplayerWidget::on_ips_editingFinished() {
     m_playTimer.setInterval(interval);
     if (running)
         m_playTimer.start();
+    updateFrameCacheConfig();
 
     ui->ips->clearFocus();  // remove focus from spinbox after edit
 }
@@ -236,6 +351,7 @@ void ImageDisplayerWidget::save(Archive& ar, const unsigned int version) const {
     SERIALIZE_SPINBOX(ar, ui->ips, ips);
     SERIALIZE_CHECKBOX(ar, ui->showUnprocessed, showUnprocessed);
     SERIALIZE_SPINBOX(ar, ui->imageSlider, imageSlider);
+    SERIALIZE_SPINBOX(ar, ui->cacheSize, cacheSize);
 }
 
 template <class Archive>
@@ -245,6 +361,10 @@ void ImageDisplayerWidget::load(Archive& ar, const unsigned int version) {
     SERIALIZE_SPINBOX(ar, ui->ips, ips);
     SERIALIZE_CHECKBOX(ar, ui->showUnprocessed, showUnprocessed);
     SERIALIZE_SPINBOX(ar, ui->imageSlider, imageSlider);
+    if (version > 0) {
+        SERIALIZE_SPINBOX(ar, ui->cacheSize, cacheSize);
+    }
+    updateFrameCacheConfig();
 }
 
 // Explicit instantiation of template functions
@@ -8,10 +8,15 @@
 #include <QTimer>
 #include <QWidget>
 
+#include <atomic>
+
 #include <opencv/cv.hpp>
 
 #include "../lib/analyzer.h"
+#include "../lib/framecache.h"
 #include "../lib/framefinder.h"
+#include "../lib/imageprefetcher.h"
+#include "../lib/processchaincache.h"
 
 namespace Ui {
 class ImageDisplayerWidget;
@@ -28,6 +33,9 @@ public:
     void reset();
     void setAnalyzer(Analyzer* analyzer);
 
+    void setPrefetchConfig(int window, int threads) { m_prefetcher.setConfig(window, threads); }
+    PrefetchStats prefetchStats() const { return m_prefetcher.stats(); }
+
     friend class boost::serialization::access;
     // Serialization function for project storage
     template <class Archive>
@@ -36,10 +44,14 @@ public:
     void load(Archive& ar, const unsigned int version);
     BOOST_SERIALIZATION_SPLIT_MEMBER()
 
+protected:
+    void resizeEvent(QResizeEvent* event) override;
+
 public slots:
     void setPath(const QString& path);
     void refreshImage();
     void directoryIndexingFinished();
+    void previewFinished();
 
 private slots:
     void on_play_clicked();
@@ -47,6 +59,7 @@ private slots:
     void on_imageSlider_sliderMoved(int position);
 
     void displayImage(int index);
+    void frameReady(int index);
     void playTimerTimeout();
     void on_ips_editingFinished();
 
@@ -54,22 +67,46 @@ private slots:
 
 private:
     void indexDirectory();
+    void startPreview();
+    void updateFrameCacheConfig();
 
     Ui::ImageDisplayerWidget* ui;
 
     cv::Mat m_image;
 
-    int m_acqIndex;
     int m_nImages;
     QDir m_dir;
     QFileInfoList m_imageFileList;
 
+    // Decodes images ahead of the analyzer when acquiring from the image folder
+    ImagePrefetcher m_prefetcher;
+
+    // Decodes images around the displayed image on a worker thread, for browsing the image folder
+    FrameCache m_frameCache;
+    int m_displayIndex = -1;
+    bool m_displayPending = false;  // the displayed image is shown once it has been decoded
+
     QTimer m_playTimer;
 
+    // Thumbnails are resized once the widget has not been resized for a while
+    QTimer m_resizeTimer;
+
     Analyzer* m_analyzer = nullptr;
 
+    // Preview of the processed image. Processing runs on a worker thread through the chain cache,
+    // which only reruns the processes following a changed process. A single request is processed
+    // at a time; requests made meanwhile cancel it, and the latest of them is processed next
+    ProcessChainCache m_chainCache;
+    QFutureWatcher<bool> m_previewWatcher;
+    std::atomic<unsigned int> m_previewRequest{0};
+    unsigned int m_runningPreviewRequest = 0;
+    int m_previewIndex = -1;
+    cv::Mat m_preview;
+
     QFutureWatcher<void> m_directoryIndexingWatcher;
     QProgressDialog* m_directoryIndexingProgress;
 };
 
+BOOST_CLASS_VERSION(ImageDisplayerWidget, 1)
+
 #endif  // IMAGEDISPLAYERWIDGET_H
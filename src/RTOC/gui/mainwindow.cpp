@@ -31,6 +31,11 @@ MainWindow::MainWindow(const QString& projectFilePath, QWidget* parent)
         [=](bool& successful) -> cv::Mat& { return m_acqInterface->getNextImage(successful); });
     m_acqInterface->moveToThread(analyzerThread);
 
+    // Add simulated camera
+    m_simulatedCameraWidget = new SimulatedCameraWidget();
+    ui->simulatorLayout->addWidget(m_simulatedCameraWidget);
+    m_acqInterface->setSimulatedCamera(m_simulatedCameraWidget->camera());
+
     // create various objects
     m_processInterface = new ProcessInterface(m_analyzer);
     m_configurator = new Configurator(m_processInterface, m_analyzer);
@@ -124,6 +129,10 @@ void MainWindow::acqSelectionChanged(int index) {
             ui->acqWidgets->setCurrentIndex(0);
             break;
         }
+        case AcqSource::Simulator: {
+            ui->acqWidgets->setCurrentIndex(3);
+            break;
+        }
     }
 }
 /* TODO: FRAMEFINDER
@@ -138,6 +147,7 @@ void MainWindow::setupAcqCombobox() {
     ui->acqSource->addItem("Generic camera", QVariant::fromValue(AcqSource::Webcam));
     ui->acqSource->addItem("microEnable 5 ironman AQ8-CXP6D",
                            QVariant::fromValue(AcqSource::IronManCamera));
+    ui->acqSource->addItem("Simulated camera", QVariant::fromValue(AcqSource::Simulator));
 
     connect(ui->acqSource, QOverload<int>::of(&QComboBox::currentIndexChanged), this,
             &MainWindow::acqSelectionChanged);
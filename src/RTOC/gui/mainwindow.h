@@ -12,6 +12,7 @@
 #include "experimentsetup.h"
 #include "imagedisplayerwidget.h"
 #include "processinterface.h"
+#include "simulatedcamerawidget.h"
 
 namespace Ui {
 class MainWindow;
@@ -53,6 +54,7 @@ private:
     ImageDisplayerWidget* m_imageDisplayerWidget;
     AcquisitionInterface* m_acqInterface;
     ExperimentSetup* m_experimentSetup;
+    SimulatedCameraWidget* m_simulatedCameraWidget;
 
 #ifdef BUILD_IRONMAN
     IronManWidget* m_acquisitionWdiget;
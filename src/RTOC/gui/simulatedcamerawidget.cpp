@@ -0,0 +1,105 @@
+#include "simulatedcamerawidget.h"
+#include "ui_simulatedcamerawidget.h"
+
+#include <QDir>
+#include <QFileDialog>
+#include <QMessageBox>
+
+#include "../lib/framefinder.h"
+
+SimulatedCameraWidget::SimulatedCameraWidget(QWidget* parent)
+    : QWidget(parent), ui(new Ui::SimulatedCameraWidget) {
+    ui->setupUi(this);
+
+    ui->jitter->setToolTip("Standard deviation of the time at which each frame is generated");
+    ui->bufferCount->setToolTip(
+        "Number of frame buffers in the acquisition ring. A frame is missed when all buffers are "
+        "held by the analyzer");
+
+    for (auto spinbox : {ui->width, ui->height, ui->bufferCount, ui->objectCount}) {
+        connect(spinbox, &QSpinBox::editingFinished, this, &SimulatedCameraWidget::updateConfig);
+    }
+    for (auto spinbox : {ui->fps, ui->jitter, ui->objectSpeed}) {
+        connect(spinbox, &QDoubleSpinBox::editingFinished, this,
+                &SimulatedCameraWidget::updateConfig);
+    }
+    updateConfig();
+
+    connect(&m_statTimer, &QTimer::timeout, this, &SimulatedCameraWidget::updateStatistics);
+    m_statTimer.start(200);
+}
+
+SimulatedCameraWidget::~SimulatedCameraWidget() {
+    m_camera.stop();
+    delete ui;
+}
+
+void SimulatedCameraWidget::updateConfig() {
+    SimulatedCameraConfig config;
+    config.width = ui->width->value();
+    config.height = ui->height->value();
+    config.fps = ui->fps->value();
+    config.jitterUs = ui->jitter->value();
+    config.bufferCount = ui->bufferCount->value();
+    config.objectCount = ui->objectCount->value();
+    config.objectSpeed = ui->objectSpeed->value();
+    m_camera.setConfig(config);
+}
+
+void SimulatedCameraWidget::updateStatistics() {
+    // Configuration cannot be changed while the camera is running
+    ui->configGroup->setEnabled(!m_camera.isRunning());
+
+    ui->generated->setText(QString::number(m_camera.generatedFrames()));
+    ui->missed->setText(QString::number(m_camera.missedFrames()));
+    ui->overrun->setText(QString::number(m_camera.overrunFrames()));
+}
+
+void SimulatedCameraWidget::on_replay_clicked() {
+    auto dirName = QFileDialog::getExistingDirectory(this, "Select replay directory", "/",
+                                                     QFileDialog::ShowDirsOnly);
+    if (dirName.isNull()) {
+        return;
+    }
+
+    QStringList filters;
+    filters << "*.png"
+            << "*.jpg"
+            << "*.bmp";
+    QFileInfoList files = QDir(dirName).entryInfoList(filters, QDir::Files);
+    framefinder::sort_qfilelist(files);
+
+    // Replay frames are kept in memory, such that disk access does not limit the frame rate
+    std::vector<cv::Mat> frames;
+    for (const auto& file : files) {
+        cv::Mat image = cv::imread(file.absoluteFilePath().toStdString(), cv::IMREAD_GRAYSCALE);
+        if (!frames.empty() && image.size() != frames[0].size()) {
+            QMessageBox::warning(this, "Error", "All replay images must have the same dimensions");
+            return;
+        }
+        frames.push_back(image);
+    }
+    if (frames.empty()) {
+        QMessageBox::warning(this, "Error", "No images found in directory");
+        return;
+    }
+
+    m_camera.setReplayFrames(frames);
+    ui->width->setValue(frames[0].cols);
+    ui->height->setValue(frames[0].rows);
+    ui->width->setEnabled(false);
+    ui->height->setEnabled(false);
+    ui->objectCount->setEnabled(false);
+    ui->objectSpeed->setEnabled(false);
+    ui->replayPath->setText(QString("%1 (%2 images)").arg(dirName).arg(frames.size()));
+}
+
+void SimulatedCameraWidget::on_clearReplay_clicked() {
+    m_camera.setReplayFrames({});
+    ui->width->setEnabled(true);
+    ui->height->setEnabled(true);
+    ui->objectCount->setEnabled(true);
+    ui->objectSpeed->setEnabled(true);
+    ui->replayPath->setText("Generated frames");
+    updateConfig();
+}
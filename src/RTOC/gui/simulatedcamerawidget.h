@@ -0,0 +1,41 @@
+#ifndef SIMULATEDCAMERAWIDGET_H
+#define SIMULATEDCAMERAWIDGET_H
+
+#include <QTimer>
+#include <QWidget>
+
+#include "../lib/simulatedcamera.h"
+
+namespace Ui {
+class SimulatedCameraWidget;
+}
+
+/**
+ * @brief The SimulatedCameraWidget class
+ * Configures the SimulatedCamera acquisition source and displays its frame loss counters. The
+ * camera is started by the AcquisitionInterface on the first image request of an experiment, and
+ * stopped when the acquisition interface is reset.
+ */
+class SimulatedCameraWidget : public QWidget {
+    Q_OBJECT
+
+public:
+    explicit SimulatedCameraWidget(QWidget* parent = 0);
+    ~SimulatedCameraWidget();
+
+    SimulatedCamera* camera() { return &m_camera; }
+
+private slots:
+    void updateConfig();
+    void updateStatistics();
+    void on_replay_clicked();
+    void on_clearReplay_clicked();
+
+private:
+    Ui::SimulatedCameraWidget* ui;
+
+    SimulatedCamera m_camera;
+    QTimer m_statTimer;
+};
+
+#endif  // SIMULATEDCAMERAWIDGET_H
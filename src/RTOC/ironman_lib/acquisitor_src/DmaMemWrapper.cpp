@@ -11,11 +11,11 @@ DmaMemWrapper::~DmaMemWrapper(){
     }
 }
 
-std::shared_ptr<DmaMemWrapper> DmaMemWrapper::create(std::weak_ptr<FgWrapper> fg, int32_t dmaPort, bool initialize){
+std::shared_ptr<DmaMemWrapper> DmaMemWrapper::create(std::weak_ptr<FgWrapper> fg, int32_t dmaPort, bool initialize, size_t bufferCount){
     std::shared_ptr<DmaMemWrapper> dma = std::make_shared<DmaMemWrapper>();
     dma->setFgHandle(fg);
     if(initialize)
-        dma->initialize(16, dmaPort );
+        dma->initialize(bufferCount, dmaPort );
     return dma;
 }
 
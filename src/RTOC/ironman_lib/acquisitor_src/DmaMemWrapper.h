@@ -10,7 +10,7 @@ class DmaMemWrapper{
 public:
     DmaMemWrapper();
     ~DmaMemWrapper();
-    static std::shared_ptr<DmaMemWrapper> create(std::weak_ptr<FgWrapper> fg, int32_t dmaPort, bool initialize = true);
+    static std::shared_ptr<DmaMemWrapper> create(std::weak_ptr<FgWrapper> fg, int32_t dmaPort, bool initialize = true, size_t bufferCount = 16);
     void setFgHandle(std::weak_ptr<FgWrapper> handle);
     dma_mem* getMemHandle();
     dma_mem* initialize(size_t bufferCount, int32_t dmaPort);
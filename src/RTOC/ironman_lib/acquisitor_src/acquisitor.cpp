@@ -5,7 +5,9 @@
 #include <QtConcurrent/qtconcurrentrun.h>
 #include <QtGlobal>
 
+#include <chrono>
 #include <sstream>
+
 Acquisitor::Acquisitor(QObject* parent) : QObject(parent) {}
 Acquisitor::~Acquisitor() {
     if (m_thread) {
@@ -108,7 +110,7 @@ int Acquisitor::initialize(const QString& xmlPath, const QString& configPath, bo
             emit writeToLog("Framegrabber successfully configured to camera dimensions");
 
             /*FgDmaChannelExample shows dma initialization.*/
-            m_dmaHandle = DmaMemWrapper::create(m_FgHandle, m_dmaPort);
+            m_dmaHandle = DmaMemWrapper::create(m_FgHandle, m_dmaPort, true, s_dmaBufferCount);
             emit writeToLog("DMA memory created successfully");
 
             // Resize m_image according to the framegrabber image size
@@ -158,16 +160,43 @@ void Acquisitor::acquisitionSgc() {
     Fg_Struct* fgHandle = m_FgHandle->getFgHandle();
     dma_mem* dmaHandle = m_dmaHandle->getMemHandle();
 
+    // Bookkeeping of buffers which are currently lent to a consumer
+    uint64_t generation = m_generation;
+    size_t buffersInFlight = 0;
+
     if (Fg_AcquireEx(fgHandle, m_dmaPort, MaxPics, ACQ_BLOCK, dmaHandle) != FG_OK)
         throwLastFgError();
 
     /*Start the camera acquisition*/
     Sgc_startAcquisition(m_camera, 0);
     while (!isError && m_acqState == AcqState::Acquiring) {
-        bufNr = Fg_getImageEx(fgHandle, SEL_ACT_IMAGE, 0, m_dmaPort, waitDurationInMs, dmaHandle);
+        // Hand buffers returned by the consumer back to the framegrabber
+        if (generation != m_generation) {
+            // Consumer has detached (or re-attached) - every lent buffer is implicitly returned
+            Fg_setStatusEx(fgHandle, FG_UNBLOCK_ALL, 0, m_dmaPort, dmaHandle);
+            generation = m_generation;
+            buffersInFlight = 0;
+        }
+        FrameBuffer released;
+        while (m_releasedFrames.try_dequeue(released)) {
+            if (released.generation == generation) {
+                Fg_setStatusEx(fgHandle, FG_UNBLOCK, released.bufNr, m_dmaPort, dmaHandle);
+                buffersInFlight--;
+            }
+        }
+
+        // With a consumer attached, every frame is required in sequence. Otherwise, only the most
+        // recent frame is of interest (live view)
+        const bool consumerAttached = m_consumerAttached;
+        bufNr = Fg_getImageEx(fgHandle, consumerAttached ? SEL_NEXT_IMAGE : SEL_ACT_IMAGE, 0,
+                              m_dmaPort, waitDurationInMs, dmaHandle);
 
         if (bufNr < 0) {
             if (bufNr == FG_TIMEOUT_ERR) {
+                if (buffersInFlight > 0) {
+                    // All frames may be waiting for the consumer - keep servicing releases
+                    continue;
+                }
                 // No more frame
                 break;
             } else {
@@ -175,17 +204,30 @@ void Acquisitor::acquisitionSgc() {
             }
         }
 
-        if (m_requestImage) {
-            // Access a pointer to an image in the buffer denoted by bufNr
-            void* pos = Fg_getImagePtrEx(fgHandle, bufNr, m_dmaPort, dmaHandle);
+        // Access a pointer to an image in the buffer denoted by bufNr
+        void* pos = Fg_getImagePtrEx(fgHandle, bufNr, m_dmaPort, dmaHandle);
 
-            // Copy image buffer to m_image
+        if (m_requestImage) {
+            // Copy image buffer to m_image for the live view
             std::memcpy(m_image.data(), pos, m_image.size());
             emit sendImageData(m_image);
             m_requestImage = false;
         }
-        // Unblock the buffer
-        Fg_setStatusEx(fgHandle, FG_UNBLOCK, bufNr, m_dmaPort, dmaHandle);
+
+        if (consumerAttached) {
+            // Publish the buffer - it stays blocked until the consumer has released it. Stale
+            // entries of a previous attachment may still occupy the ring, in which case the frame
+            // is dropped rather than leaking its buffer
+            if (m_publishedFrames.try_enqueue(FrameBuffer{bufNr, pos, generation})) {
+                buffersInFlight++;
+            } else {
+                Fg_setStatusEx(fgHandle, FG_UNBLOCK, bufNr, m_dmaPort, dmaHandle);
+                m_droppedFrames++;
+            }
+        } else {
+            // Unblock the buffer
+            Fg_setStatusEx(fgHandle, FG_UNBLOCK, bufNr, m_dmaPort, dmaHandle);
+        }
     }
 
     /*Stop framegrabber */
@@ -194,30 +236,69 @@ void Acquisitor::acquisitionSgc() {
 
     /*Stop the camera acquisition*/
     Sgc_stopAcquisition(m_camera, 0);
+
+    // Invalidate any buffers still held by a consumer
+    m_generation++;
 }
 
 void Acquisitor::throwLastFgError() {
     throwLastFgError(m_FgHandle->getFgHandle());
 }
 
-#include <chrono>
+/**
+ * @brief Waits for the next acquired frame. The returned buffer points directly into DMA memory and
+ * remains valid until it is handed back through releaseFrame(). The first call attaches the caller
+ * as the consumer of the acquisition stream, after which no frames are skipped by the acquisition
+ * loop.
+ * @param frame : set to the acquired frame on success
+ * @param timeoutMs : maximum time to wait for a frame
+ * @return true if a frame was acquired
+ */
+bool Acquisitor::acquireFrame(FrameBuffer& frame, int timeoutMs) {
+    if (!m_consumerAttached.exchange(true)) {
+        // Attaching - entries published under a previous attachment have already been unblocked
+        discardPublishedFrames();
+    }
 
-std::vector<char>* Acquisitor::requestImageDataBlocking(bool& successful) {
-    // Request a pointer to the most recently acquisited image. This function does not use the Qt
-    // event loop, and is blocking until the data has been copied
-    auto start = std::chrono::system_clock::now();
-    auto end = std::chrono::system_clock::now();
-    m_requestImage = true;
-    successful = true;
-    while (m_requestImage) {
-        end = std::chrono::system_clock::now();
-        if (end - start > std::chrono::milliseconds(1000)) {
-            successful = false;
-            break;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+    while (true) {
+        auto remaining = std::chrono::duration_cast<std::chrono::microseconds>(
+            deadline - std::chrono::steady_clock::now());
+        if (remaining.count() <= 0 || !m_publishedFrames.wait_dequeue_timed(frame, remaining)) {
+            return false;
+        }
+        if (frame.generation == m_generation) {
+            return true;
         }
+        // Stale buffer from a previous attachment - it has already been unblocked
     }
+}
+
+/**
+ * @brief Hands a buffer obtained through acquireFrame() back to the framegrabber
+ */
+void Acquisitor::releaseFrame(const FrameBuffer& frame) {
+    m_releasedFrames.try_enqueue(frame);
+}
 
-    return &m_image;
+/**
+ * @brief Stops publishing frames to the consumer and returns all lent buffers to the framegrabber.
+ * Buffers previously returned by acquireFrame() must not be accessed after detaching.
+ */
+void Acquisitor::detachConsumer() {
+    m_consumerAttached = false;
+    m_generation++;
+    discardPublishedFrames();
+}
+
+/**
+ * @brief Empties the published frame ring. Must be called from the consuming thread, as the ring
+ * has a single consumer
+ */
+void Acquisitor::discardPublishedFrames() {
+    FrameBuffer stale;
+    while (m_publishedFrames.try_dequeue(stale)) {
+    }
 }
 
 void Acquisitor::throwLastFgError(Fg_Struct* fgHandle) {
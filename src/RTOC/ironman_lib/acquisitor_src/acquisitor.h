@@ -20,8 +20,15 @@
 #include <QMutex>
 #include <QThread>
 
+#include <atomic>
+
 #include "../acquisitor_src/DmaMemWrapper.h"
 
+#ifndef NDEBUG
+#define NDEBUG
+#endif
+#include "../../external/readerwriterqueue/readerwriterqueue.h"
+
 #include "../src/logger.h"
 
 /**
@@ -43,6 +50,16 @@ typedef struct {
 
 enum class AcqState { Idle, Initializing, Initialized, Acquiring };
 
+/**
+ * @brief A DMA buffer which has been filled by the framegrabber and handed to a consumer. The
+ * buffer is blocked (ACQ_BLOCK) until the consumer returns it through Acquisitor::releaseFrame.
+ */
+struct FrameBuffer {
+    frameindex_t bufNr;
+    void* data;
+    uint64_t generation;  // consumer attachment the buffer was published under
+};
+
 Q_DECLARE_METATYPE(AcqState)
 
 class Acquisitor : public QObject {
@@ -50,7 +67,12 @@ class Acquisitor : public QObject {
 public:
     static Acquisitor* get();
     ~Acquisitor();
-    std::vector<char>* requestImageDataBlocking(bool& successful);
+
+    // Zero-copy frame access. Called from the consuming (analyzer) thread
+    bool acquireFrame(FrameBuffer& frame, int timeoutMs);
+    void releaseFrame(const FrameBuffer& frame);
+    void detachConsumer();
+    uint64_t droppedFrames() const { return m_droppedFrames; }
 
 public slots:
     int initialize(const QString& xmlPath, const QString& configPath, bool useConfigFile);
@@ -90,6 +112,22 @@ private:
 
     AcqState m_acqState = AcqState::Idle;
 
+    static const size_t s_dmaBufferCount = 16;
+
+    /* Every acquired DMA buffer is published to m_publishedFrames while a consumer is attached.
+     * The consumer hands buffers back through m_releasedFrames, and only then are they unblocked
+     * by the acquisition loop. Both rings are single-producer/single-consumer and lock free.
+     * Detaching increments m_generation, upon which the acquisition loop unblocks all buffers and
+     * the consumer discards stale entries still in m_publishedFrames. Frames which cannot be
+     * published because the ring is full are unblocked immediately and counted as dropped.
+     */
+    moodycamel::BlockingReaderWriterQueue<FrameBuffer> m_publishedFrames{s_dmaBufferCount};
+    moodycamel::ReaderWriterQueue<FrameBuffer> m_releasedFrames{s_dmaBufferCount};
+    std::atomic<bool> m_consumerAttached{false};
+    std::atomic<uint64_t> m_generation{0};
+    std::atomic<uint64_t> m_droppedFrames{0};
+    void discardPublishedFrames();
+
     /* We have no mutexes on m_image, since we assume that the protocol:
      *  1: GUI requests image;
      *  2: Acquisitor stores copies image data into m_image std::vector<char> (contiguous memory)
@@ -1,6 +1,8 @@
 #include "analyzer.h"
 
 #include <boost/filesystem.hpp>
+#include <boost/version.hpp>
+#include <thread>
 
 #include "../external/timer/timer.h"
 
@@ -32,15 +34,72 @@ void Analyzer::stopAnalyzer() {
     return;
 
 /**
- * @brief
+ * @brief Sets the image source of the analyzer to the frames listed in a text file, as written by
+ * framefinder::write_frame_lists
+ * @details Images are decoded ahead of the analyzer by m_listPrefetcher
  *
- * @warning NOT IMPLEMENTED
+ * @param imgFolder : folder containing the listed images
+ * @param listPath : path to accepted (or rejected) frame list
+ * @return false if the list could not be read or is empty
  */
-void Analyzer::loadImagesFromText() {
-    std::string accepted;  // Path to accepted text-file
-    std::string rejected;  // Path to rejected text-file
+bool Analyzer::loadImagesFromText(const std::string& imgFolder, const std::string& listPath) {
+    std::vector<std::string> filenames;
+    if (!framefinder::read_frame_list(listPath, filenames) || filenames.empty()) {
+        return false;
+    }
     // Compile img_folder path with filenames from text-files
-    // and push frames to m_experiment
+    for (auto& filename : filenames) {
+        filename = imgFolder + "/" + filename;
+    }
+    m_listPrefetcher.setFiles(filenames);
+
+    setImageGetterFunction([this](bool& successful) -> cv::Mat& {
+        successful = m_listPrefetcher.next(m_listImage) && !m_listImage.empty();
+        return m_listImage;
+    });
+    return true;
+}
+
+/**
+ * @brief Sets the image source of the analyzer to the images of a folder, ordered by the frame
+ * number in their filenames (eg. raw_12.png), as when acquiring from a folder in the GUI
+ *
+ * @param imgFolder : folder containing .png, .jpg, .bmp or .tif images
+ * @return false if the folder could not be read or contains no images
+ */
+bool Analyzer::loadImagesFromFolder(const std::string& imgFolder) {
+    std::vector<std::string> filenames;
+    if (!framefinder::read_image_folder(imgFolder, filenames)) {
+        return false;
+    }
+    m_listPrefetcher.setFiles(filenames);
+
+    setImageGetterFunction([this](bool& successful) -> cv::Mat& {
+        successful = m_listPrefetcher.next(m_listImage) && !m_listImage.empty();
+        return m_listImage;
+    });
+    return true;
+}
+
+/**
+ * @brief Sets the image source of the analyzer to the frames of a recorded video container. Color
+ * frames are converted to grayscale
+ *
+ * @param path : path to a video file readable by cv::VideoCapture
+ * @return false if the video could not be opened
+ */
+bool Analyzer::loadVideo(const std::string& path) {
+    if (!m_video.open(path)) {
+        return false;
+    }
+    setImageGetterFunction([this](bool& successful) -> cv::Mat& {
+        successful = m_video.read(m_videoFrame) && !m_videoFrame.empty();
+        if (successful && m_videoFrame.channels() == 3) {
+            cv::cvtColor(m_videoFrame, m_videoFrame, cv::COLOR_BGR2GRAY);
+        }
+        return m_videoFrame;
+    });
+    return true;
 }
 
 /**
@@ -112,6 +171,29 @@ void Analyzer::spinLockWait(int micros) const {
 void Analyzer::runAnalyzer(const Setup& s) {
     Timer t;
     softReset();
+    m_experiment.resetDroppedCounts();
+    LatencyRecorder& latency = m_experiment.latency;
+    latency.reset();
+    // Such that the live view does not show the last frame of the previous experiment
+    m_liveFrame.reset();
+    std::vector<std::string> processNames;
+    for (const auto& process : m_processes) {
+        processNames.push_back(process->getTypeName());
+    }
+    latency.setProcessNames(processNames);
+
+    // Start tracing before setup(), such that the threads started by it are traced
+    TraceRecorder& trace = m_experiment.trace;
+    if (s.traceTimeline) {
+        trace.start();
+        trace.setThreadName("Acquisition");
+    } else {
+        trace.stop();
+    }
+    m_processTraceNames.clear();
+    for (const auto& name : processNames) {
+        m_processTraceNames.push_back(trace.internName(name));
+    }
 
     // Set setup. This will be used other subsequent actions in an analyzer call
     setup(s);
@@ -119,7 +201,9 @@ void Analyzer::runAnalyzer(const Setup& s) {
     bool success;
     t.tic();
     while (true) {
+        const auto acquireStart = LatencyRecorder::now();
         m_img = m_imageGetterFunction(success);
+        const auto acquired = LatencyRecorder::now();
 
         if (!success || m_asyncStopAnalyzer) {
             m_asyncStopAnalyzer = false;  // reset, such that the same flag can be used to stop
@@ -131,17 +215,33 @@ void Analyzer::runAnalyzer(const Setup& s) {
             break;
         }
 
+        latency.record(LatencyStage::Acquire, acquired - acquireStart);
+        trace.span("Acquire", m_imageCnt, acquireStart, acquired);
+
+        // The live view only copies a frame when the display asks for one
+        m_liveFrame.publish(m_img);
+
         if (m_bg.cols != m_img.cols || m_bg.rows != m_img.rows) {
             // set bg
             m_bg = m_img.clone();
         }
         if (m_setup.extractData) {
-            // Push data to raw and processed image buffers
-            m_experiment.raw.enqueue(m_img.clone());
+            // Push data to the raw and processed image pair buffer. Depending on the analysis queue
+            // policy, this may block or drop a frame if the object finder is falling behind
+            AnalysisFrame frame;
+            frame.acquired = acquired;
+            frame.index = m_imageCnt;
+            frame.raw = m_img.clone();
             if (m_setup.runProcessing) {
                 processImage(m_img, m_bg);
-                m_experiment.processed.enqueue(m_img.clone());
+                frame.processed = m_img.clone();
             }
+            const size_t depth = m_experiment.frames.size_approx();
+            latency.recordQueueDepth(LatencyQueue::Analysis, depth);
+            trace.counter("Analysis queue depth", static_cast<double>(depth));
+            TraceSpan span(trace, "Enqueue analysis frame", m_imageCnt);
+            frame.enqueued = LatencyRecorder::now();
+            m_experiment.frames.enqueue(std::move(frame));
         } else {
             // Push data directly to write buffers
             if (m_setup.storeRaw)
@@ -164,6 +264,36 @@ void Analyzer::setup(const Setup& setup) {
     // Calculate inlet/outlet lines
     m_experiment.setInletOutletLines(m_setup.inlet, m_setup.outlet);
 
+    // Apply queue limits. DropStorage never drops frames for analysis, only frames for storage
+    QueuePolicy analysisPolicy = m_setup.analysisQueuePolicy == QueuePolicy::DropStorage
+                                     ? QueuePolicy::Block
+                                     : m_setup.analysisQueuePolicy;
+    QueuePolicy storagePolicy = m_setup.storageQueuePolicy == QueuePolicy::DropStorage
+                                    ? QueuePolicy::DropNewest
+                                    : m_setup.storageQueuePolicy;
+    // If images are not written during the experiment, no one consumes the storage queues until
+    // stop() is called - a blocking storage queue would thus stall acquisition indefinitely
+    size_t storageCapacity = m_setup.storageQueueCapacity;
+    if (!m_setup.storeImagesDuringExperiment && storagePolicy == QueuePolicy::Block) {
+        storageCapacity = 0;
+    }
+    m_experiment.frames.setCapacity(m_setup.analysisQueueCapacity, analysisPolicy);
+    m_experiment.writeBuffer_raw.setCapacity(storageCapacity, storagePolicy);
+    m_experiment.writeBuffer_processed.setCapacity(storageCapacity, storagePolicy);
+
+    // Stream closed tracks to disk during the experiment, bounding the memory held by tracks of
+    // long running experiments. Only the binary format supports this, as the text format requires
+    // the total track count up front
+    if (m_setup.extractData && m_setup.exportFormat == ExportFormat::Binary) {
+        const fs::path experimentFolder =
+            fs::path(m_setup.outputPath) / fs::path(m_setup.experimentName);
+        boost::system::error_code ec;
+        fs::create_directories(experimentFolder, ec);
+        const fs::path path = experimentFolder / fs::path(m_setup.experimentName + ".rtoc");
+        // If this fails, tracks are kept in memory and exported when the experiment is stopped
+        m_experiment.trackExporter.open(path.string(), data::AllFlags);
+    }
+
     // Setup objectFinder if we are extracting data
     if (m_setup.extractData) {
         m_objectFinder = new ObjectFinder(&m_experiment, &m_setup);
@@ -197,17 +327,27 @@ void Analyzer::stop() {
 
     // Wait for threads to finish
     m_asyncStopAnalyzer = true;
-    if (m_setup.extractData)
+    int writeTarget = m_imageCnt;
+    if (m_setup.extractData) {
         m_objectFinder->waitForThreadToFinish(m_imageCnt);
+        // Image writers are fed by the object finder, and thus never see frames which were dropped
+        // from the analysis queue
+        writeTarget -= m_experiment.frames.droppedCount();
+    }
     if (m_setup.storeProcessed)
-        m_experiment.writeBuffer_processed.finishWriting(m_imageCnt);
+        m_experiment.writeBuffer_processed.finishWriting(writeTarget);
     if (m_setup.storeRaw)
-        m_experiment.writeBuffer_raw.finishWriting(m_imageCnt);
+        m_experiment.writeBuffer_raw.finishWriting(writeTarget);
 
     // Export experiment data
     if (m_setup.extractData)
         exportExperiment(m_setup.experimentName);
 
+    writeLatencyReport();
+    if (m_experiment.trace.enabled()) {
+        writeTrace();
+    }
+
     // All done, we can reset
     softReset();
 }
@@ -219,6 +359,8 @@ void Analyzer::forceStop() {
     // stops all objects which are handled by analyzer
     // stop objectfinder before image writers!
     m_asyncStopAnalyzer = true;
+    m_experiment.trace.stop();
+    m_experiment.frames.abort();
     if (m_objectFinder) {
         m_objectFinder->forceStop();
         m_objectFinder->waitForThreadToClose();
@@ -310,7 +452,9 @@ bool Analyzer::loadSetup(const string& path) {
         std::ifstream ifs(path);
         {
             boost::archive::xml_iarchive ia(ifs);
-#ifndef __linux__  // https://stackoverflow.com/questions/50038329/serializing-stdvector-of-unique-ptr-using-boostserialization-fails-on-linux
+// https://stackoverflow.com/questions/50038329/serializing-stdvector-of-unique-ptr-using-boostserialization-fails-on-linux
+// Loading works on linux as of Boost 1.74
+#if !defined(__linux__) || BOOST_VERSION >= 107400
             ia >> BOOST_SERIALIZATION_NVP(m_processes);
 #endif
         }
@@ -332,52 +476,108 @@ void Analyzer::exportExperiment(const string& name) {
     const fs::path experimentFolder =
         fs::path(m_setup.outputPath) / fs::path(m_setup.experimentName);
     const std::string path = fs::path(experimentFolder / fs::path(name)).string();
-    if (m_experiment.data.empty()) {
+    if (m_experiment.data.empty() && !m_experiment.trackExporter.isOpen()) {
         // No objects to export
         m_status |= StatusBits::NoObjectsFound;
         return;
     }
 
-    std::vector<std::string> attributes = m_experiment.data[0]->extractAttributeName();
-    std::ofstream out(path);
-    // Add list of attributes
-    for (const auto& attribute : attributes) {
-        out << attribute << "'";
+    switch (m_setup.exportFormat) {
+        case ExportFormat::Text: {
+            exportText(path);
+            break;
+        }
+        case ExportFormat::Binary: {
+            exportBinary(path + ".rtoc");
+            break;
+        }
     }
-    out << "\n";
+}
+
+/**
+ * @brief Exports all tracks in the columnar format described in BinaryExporter. Tracks are written
+ * in blocks of roughly maxBlockObjects objects, to bound the size of the column buffers.
+ * If tracks have been streamed during the experiment, the remaining tracks are appended to the
+ * streamed file, and the export is reduced to writing the trailer
+ */
+void Analyzer::exportBinary(const std::string& path) {
+    const size_t maxBlockObjects = 1 << 20;
 
-    // Add number number of values for chosen attributes
-    std::vector<int> attributeLengths = m_experiment.data[0]->extractAttributeLengths();
-    for (const auto& value : attributeLengths) {
-        out << value << " ";
+    BinaryExporter& exporter = m_experiment.trackExporter;
+    if (!exporter.isOpen() && !exporter.open(path, data::AllFlags)) {
+        m_status |= StatusBits::UnknownError;
+        return;
     }
+    size_t begin = 0;
+    size_t blockObjects = 0;
+    for (size_t i = 0; i < m_experiment.data.size(); i++) {
+        if (!m_experiment.data[i]) {
+            continue;
+        }
+        blockObjects += m_experiment.data[i]->size();
+        if (blockObjects >= maxBlockObjects) {
+            exporter.writeBlock(m_experiment.data, begin, i + 1);
+            begin = i + 1;
+            blockObjects = 0;
+        }
+    }
+    exporter.writeBlock(m_experiment.data, begin, m_experiment.data.size());
+    const bool noTracks = exporter.trackCount() == 0;
+    if (!exporter.close()) {
+        m_status |= StatusBits::UnknownError;
+    } else if (noTracks) {
+        m_status |= StatusBits::NoObjectsFound;
+    }
+}
 
-    // Add number of containers
-    out << "\n" << m_experiment.data.size() << "\n";
+void Analyzer::exportText(const std::string& path) {
+    TextExporter exporter(std::max(1u, std::thread::hardware_concurrency()));
+    if (!exporter.write(path, m_experiment.data)) {
+        m_status |= StatusBits::UnknownError;
+    }
+}
 
-    // Goes through all containers
-    for (int i = 0; i < m_experiment.data.size(); i++) {
-        // CHECK_ASYNC_STOP
-        out << "Observation" << (i + 1) << " " << m_experiment.data[i]->size() << "\n";
+/**
+ * @brief Writes the latency report of the experiment to <experimentName>_latency.txt in the
+ * experiment folder
+ */
+void Analyzer::writeLatencyReport() {
+    const fs::path experimentFolder =
+        fs::path(m_setup.outputPath) / fs::path(m_setup.experimentName);
+    boost::system::error_code ec;
+    fs::create_directories(experimentFolder, ec);
+    const fs::path path = experimentFolder / fs::path(m_setup.experimentName + "_latency.txt");
+    m_experiment.latency.writeReport(path.string());
+}
 
-        // Goes through all objects
-        for (int j = 0; j < m_experiment.data[i]->size(); j++) {
-            // Extracts vector of doubles from object
-            std::vector<double> objectVector = m_experiment.data[i]->extractObjectInDoubles(j);
-            for (const auto& item : objectVector) {
-                out << item << " ";
-            }
-            out << "\n";
-        }
-    }
-    out.close();
-    // ASYNC_END_SIDEEFFECT(([&out]() { out.close(); }))
+/**
+ * @brief Stops tracing, and writes the timeline of the experiment to <experimentName>_trace.json in
+ * the experiment folder. The file can be opened in chrome://tracing or https://ui.perfetto.dev
+ */
+void Analyzer::writeTrace() {
+    m_experiment.trace.stop();
+    const fs::path experimentFolder =
+        fs::path(m_setup.outputPath) / fs::path(m_setup.experimentName);
+    boost::system::error_code ec;
+    fs::create_directories(experimentFolder, ec);
+    const fs::path path = experimentFolder / fs::path(m_setup.experimentName + "_trace.json");
+    m_experiment.trace.write(path.string());
 }
 
 void Analyzer::processImage(cv::Mat& img, cv::Mat& bg) {
-    for (const auto& process : m_processes) {
-        process->doProcessing(img, bg, m_experiment);
+    LatencyRecorder& latency = m_experiment.latency;
+    const auto chainStart = LatencyRecorder::now();
+    auto processStart = chainStart;
+    for (size_t i = 0; i < m_processes.size(); i++) {
+        m_processes[i]->doProcessing(img, bg, m_experiment);
+        const auto processEnd = LatencyRecorder::now();
+        latency.recordProcess(i, processEnd - processStart);
+        if (i < m_processTraceNames.size()) {
+            m_experiment.trace.span(m_processTraceNames[i], m_imageCnt, processStart, processEnd);
+        }
+        processStart = processEnd;
     }
+    latency.record(LatencyStage::Processing, processStart - chainStart);
 }
 
 long Analyzer::getSetupDataFlags() {
@@ -387,3 +587,41 @@ long Analyzer::getSetupDataFlags() {
 const Experiment* Analyzer::getExperiment() {
     return &m_experiment;
 }
+
+/**
+ * @brief Returns the latency histograms of the current, or most recent, experiment
+ */
+const LatencyRecorder& Analyzer::latency() const {
+    return m_experiment.latency;
+}
+
+/**
+ * @brief Returns the current number of frames held by the given queue
+ */
+size_t Analyzer::queueDepth(QueueType queue) const {
+    switch (queue) {
+        case QueueType::Analysis:
+            return m_experiment.frames.size_approx();
+        case QueueType::StorageRaw:
+            return m_experiment.writeBuffer_raw.queueSize();
+        case QueueType::StorageProcessed:
+            return m_experiment.writeBuffer_processed.queueSize();
+    }
+    return 0;
+}
+
+/**
+ * @brief Returns the number of frames dropped by the given queue, as per the queue policies set in
+ * the current Setup
+ */
+long Analyzer::droppedFrames(QueueType queue) const {
+    switch (queue) {
+        case QueueType::Analysis:
+            return m_experiment.frames.droppedCount();
+        case QueueType::StorageRaw:
+            return m_experiment.writeBuffer_raw.droppedCount();
+        case QueueType::StorageProcessed:
+            return m_experiment.writeBuffer_processed.droppedCount();
+    }
+    return 0;
+}
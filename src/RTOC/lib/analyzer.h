@@ -3,12 +3,17 @@
 #include <algorithm>
 #include <fstream>
 #include <iostream>
+#include "binaryexporter.h"
 #include "experiment.h"
 #include "framefinder.h"
+#include "imageprefetcher.h"
+#include "latencyrecorder.h"
+#include "latestframeslot.h"
 #include "machinelearning.h"
 #include "objectfinder.h"
 #include "process.h"
 #include "setup.h"
+#include "textexporter.h"
 #include "tracker.h"
 
 #include <boost/archive/xml_iarchive.hpp>
@@ -18,6 +23,7 @@
 #include <boost/serialization/vector.hpp>
 
 #include <opencv/cv.hpp>
+#include <opencv2/videoio.hpp>
 
 #include <functional>
 
@@ -25,12 +31,20 @@
 // ExperimentRunner::checkAnalyzerStatusMessage
 enum StatusBits { UnknownError = 1 << 0, NoObjectsFound = 1 << 1 };
 
+// Queues which may drop frames, as per the queue policies of a Setup
+enum class QueueType { Analysis, StorageRaw, StorageProcessed };
+
 class Analyzer : public QObject {
     Q_OBJECT
 public:
     processContainerPtr getProcessContainerPtr() { return &m_processes; }
 
-    void loadImagesFromText();
+    bool loadImagesFromText(const std::string& imgFolder, const std::string& listPath);
+    bool loadImagesFromFolder(const std::string& imgFolder);
+    bool loadVideo(const std::string& path);
+    void setPrefetchConfig(size_t window, unsigned int threads) {
+        m_listPrefetcher.setConfig(window, threads);
+    }
     void setBG(const cv::Mat& bg);
     void runProcesses();
     void runAnalyzer(const Setup& setup);
@@ -46,6 +60,11 @@ public:
     void softReset();
     void hardReset();
     const int getStatus() const { return m_status; }
+    long droppedFrames(QueueType queue) const;
+    size_t queueDepth(QueueType queue) const;
+    const LatencyRecorder& latency() const;
+    // Latest acquired frame, for display during an experiment
+    LatestFrameSlot& liveFrame() { return m_liveFrame; }
 
     void setImageGetterFunction(std::function<cv::Mat&(bool&)> function) {
         m_imageGetterFunction = function;
@@ -94,12 +113,29 @@ private:
     bool m_asyncStopAnalyzer = false;  // called externally when analyzer should stop preliminarily
 
     void processImage(cv::Mat& img, cv::Mat& bg);
+    void exportText(const std::string& path);
+    void exportBinary(const std::string& path);
+    void writeLatencyReport();
+    void writeTrace();
 
     std::vector<std::unique_ptr<ProcessBase>> m_processes;
+    // Names of m_processes in the timeline trace, set at the start of an experiment
+    std::vector<const char*> m_processTraceNames;
 
     std::vector<std::unique_ptr<DataContainer>> m_data;  // experiment data here ? (JL, 17-04-18)
 
     std::function<cv::Mat&(bool& sucessful)> m_imageGetterFunction;
+
+    // Image source for frame lists and folders loaded through loadImagesFromText() and
+    // loadImagesFromFolder()
+    ImagePrefetcher m_listPrefetcher;
+
+    LatestFrameSlot m_liveFrame;
+    cv::Mat m_listImage;
+
+    // Image source for recordings loaded through loadVideo()
+    cv::VideoCapture m_video;
+    cv::Mat m_videoFrame;
 };
 
 #endif  // RTOC_CSHELPER_H
@@ -0,0 +1,121 @@
+#include "batchrunner.h"
+
+#include <algorithm>
+#include <chrono>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+#include <boost/filesystem.hpp>
+
+#include "analyzer.h"
+
+namespace {
+namespace fs = boost::filesystem;
+
+bool setImageSource(Analyzer& analyzer, const BatchJob& job) {
+    const fs::path input(job.inputPath);
+    boost::system::error_code ec;
+    if (fs::is_directory(input, ec)) {
+        return analyzer.loadImagesFromFolder(job.inputPath);
+    }
+    if (input.extension() == ".txt") {
+        const std::string imageFolder =
+            job.imageFolder.empty() ? input.parent_path().string() : job.imageFolder;
+        return analyzer.loadImagesFromText(imageFolder, job.inputPath);
+    }
+    return analyzer.loadVideo(job.inputPath);
+}
+
+// Process presets are loaded through the global type registries of boost::serialization, which
+// are not safe to use from concurrent jobs
+std::mutex presetMutex;
+
+BatchResult fail(BatchResult result, const std::string& error) {
+    result.success = false;
+    result.error = error;
+    return result;
+}
+}  // namespace
+
+/**
+ * @brief Runs the analysis and export of a single experiment, without any GUI
+ * @details The experiment is written to <outputPath>/<experimentName>, as when running the
+ * experiment from the GUI. Blocks until all images have been analyzed and written.
+ */
+BatchResult runBatchJob(const BatchJob& job) {
+    BatchResult result;
+    try {
+        Setup setup;
+        if (!loadExperimentSetup(job.setupPath, setup)) {
+            return fail(result, "Could not load experiment setup " + job.setupPath);
+        }
+        // The recording time limits live acquisition. Recorded input is always analyzed in full
+        setup.recordingTime = 0;
+        if (!job.outputPath.empty()) {
+            setup.outputPath = job.outputPath;
+        }
+        if (!job.experimentName.empty()) {
+            setup.experimentName = job.experimentName;
+        }
+        if (job.queueCapacity > 0) {
+            if (setup.analysisQueueCapacity == 0) {
+                setup.analysisQueueCapacity = job.queueCapacity;
+            }
+            if (setup.storageQueueCapacity == 0) {
+                setup.storageQueueCapacity = job.queueCapacity;
+            }
+        }
+
+        Analyzer analyzer;
+        {
+            std::lock_guard<std::mutex> lock(presetMutex);
+            if (!analyzer.loadSetup(job.presetPath)) {
+                return fail(result, "Could not load process preset " + job.presetPath);
+            }
+        }
+        if (setup.runProcessing && analyzer.getProcessContainerPtr()->empty()) {
+            return fail(result, "Process preset " + job.presetPath + " contains no processes");
+        }
+        const unsigned int prefetchThreads =
+            job.prefetchThreads > 0 ? job.prefetchThreads
+                                    : std::max(1u, std::thread::hardware_concurrency() / 2);
+        analyzer.setPrefetchConfig(job.prefetchWindow, prefetchThreads);
+        if (!setImageSource(analyzer, job)) {
+            return fail(result, "Could not read input " + job.inputPath);
+        }
+
+        // Prepare the experiment folder, as ExperimentSetup does
+        const fs::path experimentFolder = fs::path(setup.outputPath) / setup.experimentName;
+        result.experimentFolder = experimentFolder.string();
+        boost::system::error_code ec;
+        if (fs::exists(experimentFolder, ec) && !fs::is_empty(experimentFolder, ec) &&
+            !job.overwrite) {
+            return fail(result, "Experiment folder " + result.experimentFolder + " is not empty");
+        }
+        fs::create_directories(experimentFolder, ec);
+        if (setup.storeRaw) {
+            fs::create_directories(experimentFolder / setup.rawPrefix, ec);
+        }
+        if (setup.storeProcessed) {
+            fs::create_directories(experimentFolder / setup.processedPrefix, ec);
+        }
+        if (ec) {
+            return fail(result, "Could not create experiment folder " + result.experimentFolder);
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        analyzer.runAnalyzer(setup);
+        result.frames = analyzer.acquiredImagesCnt();
+        analyzer.stop();
+        result.seconds =
+            std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        result.success = true;
+    } catch (const std::exception& e) {
+        return fail(result, e.what());
+    } catch (const std::string& e) {
+        // framefinder reports errors as strings
+        return fail(result, e);
+    }
+    return result;
+}
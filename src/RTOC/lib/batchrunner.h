@@ -0,0 +1,41 @@
+#ifndef RTOC_BATCHRUNNER_H
+#define RTOC_BATCHRUNNER_H
+
+#include <string>
+
+/**
+ * @brief An offline analysis of a recorded experiment
+ */
+struct BatchJob {
+    std::string presetPath;  // process preset, as stored by Analyzer::storeSetup()
+    std::string setupPath;   // experiment setup, as stored by storeExperimentSetup()
+    // Folder of images, frame list (.txt) as written by framefinder::write_frame_lists, or video
+    std::string inputPath;
+    std::string imageFolder;  // folder of the images of a frame list. Defaults to its folder
+
+    // Override Setup::outputPath and Setup::experimentName if not empty
+    std::string outputPath;
+    std::string experimentName;
+    bool overwrite = false;  // allow writing into an existing, non-empty experiment folder
+
+    // Images decoded ahead of the analyzer, and the number of decoder threads. 0 threads uses half
+    // the hardware threads
+    size_t prefetchWindow = 16;
+    unsigned int prefetchThreads = 0;
+
+    // Capacity applied to the unbounded queues of the setup, bounding the memory held by them. 0
+    // keeps the queue limits of the setup
+    unsigned int queueCapacity = 0;
+};
+
+struct BatchResult {
+    bool success = false;
+    std::string error;
+    std::string experimentFolder;
+    long frames = 0;
+    double seconds = 0;
+};
+
+BatchResult runBatchJob(const BatchJob& job);
+
+#endif  // RTOC_BATCHRUNNER_H
@@ -0,0 +1,263 @@
+#include "batchscheduler.h"
+
+#include <algorithm>
+#include <map>
+#include <thread>
+
+#include <boost/filesystem.hpp>
+
+#include <opencv/cv.hpp>
+#include <opencv2/videoio.hpp>
+
+#include "framefinder.h"
+#include "setup.h"
+
+namespace {
+namespace fs = boost::filesystem;
+
+// Threads occupied by each analyzer besides its decoder threads: the processing thread and the
+// object finder
+constexpr unsigned int analyzerThreads = 2;
+// Images held by an analyzer besides its queues and prefetch window: the current raw image, the
+// background and the intermediate images of the process chain
+constexpr size_t workingImages = 8;
+
+/**
+ * @brief Determines the size of a grayscale frame and the number of frames of the input of a job,
+ * by decoding its first image or reading the video properties
+ */
+bool inspectInput(const BatchJob& job, size_t& frameBytes, size_t& frames) {
+    const fs::path input(job.inputPath);
+    boost::system::error_code ec;
+    std::string firstImage;
+    frames = 0;
+    if (fs::is_directory(input, ec)) {
+        std::vector<std::string> paths;
+        if (framefinder::read_image_folder(job.inputPath, paths)) {
+            firstImage = paths.front();
+            frames = paths.size();
+        }
+    } else if (input.extension() == ".txt") {
+        std::vector<std::string> filenames;
+        if (framefinder::read_frame_list(job.inputPath, filenames) && !filenames.empty()) {
+            const std::string imageFolder =
+                job.imageFolder.empty() ? input.parent_path().string() : job.imageFolder;
+            firstImage = imageFolder + "/" + filenames.front();
+            frames = filenames.size();
+        }
+    } else {
+        cv::VideoCapture video(job.inputPath);
+        if (!video.isOpened()) {
+            return false;
+        }
+        frameBytes = static_cast<size_t>(video.get(cv::CAP_PROP_FRAME_WIDTH) *
+                                         video.get(cv::CAP_PROP_FRAME_HEIGHT));
+        frames = static_cast<size_t>(std::max(0.0, video.get(cv::CAP_PROP_FRAME_COUNT)));
+        return frameBytes > 0;
+    }
+    if (firstImage.empty()) {
+        return false;
+    }
+    const cv::Mat image = cv::imread(firstImage, cv::IMREAD_GRAYSCALE);
+    frameBytes = image.total() * image.elemSize();
+    return frameBytes > 0;
+}
+
+/**
+ * @brief Returns the capacity, in frames, of a queue with the given limits. Unbounded queues may
+ * hold every frame of the experiment
+ */
+size_t queueFrames(unsigned int capacity, size_t frames) {
+    return capacity > 0 ? std::min<size_t>(capacity, frames) : frames;
+}
+
+size_t estimateMemory(const BatchJob& job, const Setup& setup) {
+    size_t frameBytes = 0;
+    size_t frames = 0;
+    if (!inspectInput(job, frameBytes, frames)) {
+        return 0;
+    }
+    const unsigned int analysisCapacity =
+        setup.analysisQueueCapacity > 0 ? setup.analysisQueueCapacity : job.queueCapacity;
+    unsigned int storageCapacity =
+        setup.storageQueueCapacity > 0 ? setup.storageQueueCapacity : job.queueCapacity;
+    // As in Analyzer::setup(), blocking storage queues are unbounded if images are only written
+    // once the experiment has stopped
+    if (!setup.storeImagesDuringExperiment && setup.storageQueuePolicy == QueuePolicy::Block) {
+        storageCapacity = 0;
+    }
+
+    // Queued analysis frames hold a raw and a processed image
+    size_t images = workingImages + std::min(job.prefetchWindow, frames);
+    if (setup.extractData) {
+        images += 2 * queueFrames(analysisCapacity, frames);
+    }
+    if (setup.storeRaw) {
+        images += queueFrames(storageCapacity, frames);
+    }
+    if (setup.storeProcessed) {
+        images += queueFrames(storageCapacity, frames);
+    }
+    return images * frameBytes;
+}
+
+void applyOverrides(const BatchJob& job, Setup& setup) {
+    if (!job.outputPath.empty()) {
+        setup.outputPath = job.outputPath;
+    }
+    if (!job.experimentName.empty()) {
+        setup.experimentName = job.experimentName;
+    }
+}
+}  // namespace
+
+/**
+ * @brief Estimates the memory, in bytes, of the images held by the analyzer of a job: its prefetch
+ * window, its analysis and storage queues and its working images. The estimate is an upper bound
+ * for a steady flow of frames, and is 0 if the setup or the input of the job cannot be read
+ */
+size_t estimateBatchJobMemory(const BatchJob& job) {
+    Setup setup;
+    if (!loadExperimentSetup(job.setupPath, setup)) {
+        return 0;
+    }
+    return estimateMemory(job, setup);
+}
+
+BatchScheduler::BatchScheduler(const BatchSchedulerConfig& config) : m_config(config) {
+    m_threads =
+        config.threads > 0 ? config.threads : std::max(1u, std::thread::hardware_concurrency());
+    m_maxConcurrentJobs = config.maxConcurrentJobs > 0
+                              ? config.maxConcurrentJobs
+                              : std::max(1u, m_threads / (analyzerThreads + 1));
+}
+
+/**
+ * @brief Adds a job to the batch
+ * @return index of the job in the results of run()
+ */
+size_t BatchScheduler::addJob(const BatchJob& job) {
+    Job entry;
+    entry.job = job;
+    if (m_config.memoryBudget > 0 && entry.job.queueCapacity == 0) {
+        entry.job.queueCapacity = m_config.queueCapacity;
+    }
+    m_jobs.push_back(entry);
+    return m_jobs.size() - 1;
+}
+
+/**
+ * @brief Stops the scheduler from starting further jobs. Running jobs are completed, and run()
+ * reports the jobs which were not started as cancelled
+ */
+void BatchScheduler::cancel() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_cancel = true;
+    m_jobFinished.notify_all();
+}
+
+/**
+ * @brief Runs all jobs, blocking until they have finished
+ * @details Jobs writing to an experiment folder which is also written by a preceding job are not
+ * run, and are reported as failed. The progress callback is called from the thread of each job
+ * as it finishes, one job at a time.
+ *
+ * @return results of the jobs, in the order they were added
+ */
+std::vector<BatchResult> BatchScheduler::run() {
+    const size_t jobCount = m_jobs.size();
+    m_results.assign(jobCount, BatchResult());
+    m_cancel = false;
+    m_peakConcurrentJobs = 0;
+    m_peakMemory = 0;
+
+    // Resolve the experiment folder and memory estimate of each job. Jobs of which the setup
+    // cannot be read are left to runBatchJob() to report
+    std::vector<bool> runnable(jobCount, true);
+    std::map<std::string, size_t> folders;
+    for (size_t i = 0; i < jobCount; i++) {
+        Job& entry = m_jobs[i];
+        Setup setup;
+        if (!loadExperimentSetup(entry.job.setupPath, setup)) {
+            continue;
+        }
+        applyOverrides(entry.job, setup);
+        const fs::path folder = fs::path(setup.outputPath) / setup.experimentName;
+        entry.experimentFolder = fs::absolute(folder).lexically_normal().string();
+        const auto inserted = folders.emplace(entry.experimentFolder, i);
+        if (!inserted.second) {
+            runnable[i] = false;
+            m_results[i].experimentFolder = folder.string();
+            m_results[i].error = "Experiment folder " + folder.string() +
+                                 " is also written by job " +
+                                 std::to_string(inserted.first->second);
+            continue;
+        }
+        entry.memory = estimateMemory(entry.job, setup);
+    }
+
+    // Number of runnable jobs from each job onwards, used to divide the threads between the jobs
+    // at the end of a batch
+    std::vector<size_t> remaining(jobCount + 1, 0);
+    for (size_t i = jobCount; i-- > 0;) {
+        remaining[i] = remaining[i + 1] + (runnable[i] ? 1 : 0);
+    }
+
+    std::vector<std::thread> workers;
+    std::vector<bool> started(jobCount, false);
+    for (size_t i = 0; i < jobCount; i++) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!runnable[i]) {
+            if (m_progressCallback) {
+                m_progressCallback(i, m_results[i]);
+            }
+            continue;
+        }
+        const size_t memory = m_jobs[i].memory;
+        m_jobFinished.wait(lock, [&] {
+            const bool fitsMemory = m_config.memoryBudget == 0 || m_runningJobs == 0 ||
+                                    m_runningMemory + memory <= m_config.memoryBudget;
+            return m_cancel || (m_runningJobs < m_maxConcurrentJobs && fitsMemory);
+        });
+        if (m_cancel) {
+            break;
+        }
+
+        BatchJob job = m_jobs[i].job;
+        if (job.prefetchThreads == 0) {
+            const size_t slots =
+                std::min<size_t>(m_maxConcurrentJobs, m_runningJobs + remaining[i]);
+            const unsigned int share = m_threads / static_cast<unsigned int>(slots);
+            job.prefetchThreads = share > analyzerThreads ? share - analyzerThreads : 1;
+        }
+        m_runningJobs++;
+        m_runningMemory += memory;
+        m_peakConcurrentJobs = std::max(m_peakConcurrentJobs, m_runningJobs);
+        m_peakMemory = std::max(m_peakMemory, m_runningMemory);
+        started[i] = true;
+        workers.emplace_back(&BatchScheduler::runJob, this, i, job);
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+
+    for (size_t i = 0; i < jobCount; i++) {
+        if (runnable[i] && !started[i]) {
+            m_results[i].error = "Cancelled";
+        }
+    }
+    return m_results;
+}
+
+void BatchScheduler::runJob(size_t index, BatchJob job) {
+    const BatchResult result = runBatchJob(job);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_results[index] = result;
+    m_runningJobs--;
+    m_runningMemory -= m_jobs[index].memory;
+    if (m_progressCallback) {
+        m_progressCallback(index, result);
+    }
+    m_jobFinished.notify_all();
+}
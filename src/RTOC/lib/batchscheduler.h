@@ -0,0 +1,83 @@
+#ifndef RTOC_BATCHSCHEDULER_H
+#define RTOC_BATCHSCHEDULER_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "batchrunner.h"
+
+struct BatchSchedulerConfig {
+    // Threads shared by all experiments. 0 uses all hardware threads
+    unsigned int threads = 0;
+    // Maximum number of experiments analyzed concurrently. 0 derives it from the thread count
+    unsigned int maxConcurrentJobs = 0;
+    // Estimated memory, in bytes, of the images held by all running experiments. 0 is unlimited
+    size_t memoryBudget = 0;
+    // Capacity of otherwise unbounded queues of jobs run under a memory budget
+    unsigned int queueCapacity = 64;
+};
+
+size_t estimateBatchJobMemory(const BatchJob& job);
+
+/**
+ * @brief The BatchScheduler class
+ * @details Runs a list of batch jobs with concurrent, independent analyzers. Jobs are started in
+ * the order they were added, as long as the number of running jobs and their estimated memory
+ * (see estimateBatchJobMemory()) stay within the configured limits. A job exceeding the memory
+ * budget on its own is run once no other job is running.
+ *
+ * The thread budget is divided between the concurrent jobs: each analyzer occupies a processing
+ * and an object finder thread, and the remaining threads are assigned to image decoding. Jobs
+ * started when fewer jobs than job slots remain (ie. at the end of a batch) are given a larger
+ * share. Jobs with an explicit BatchJob::prefetchThreads keep it.
+ */
+class BatchScheduler {
+public:
+    explicit BatchScheduler(const BatchSchedulerConfig& config = BatchSchedulerConfig());
+
+    size_t addJob(const BatchJob& job);
+    size_t jobCount() const { return m_jobs.size(); }
+
+    void setProgressCallback(std::function<void(size_t job, const BatchResult&)> callback) {
+        m_progressCallback = callback;
+    }
+
+    std::vector<BatchResult> run();
+    void cancel();
+
+    unsigned int threads() const { return m_threads; }
+    unsigned int maxConcurrentJobs() const { return m_maxConcurrentJobs; }
+    unsigned int peakConcurrentJobs() const { return m_peakConcurrentJobs; }
+    size_t peakMemory() const { return m_peakMemory; }
+
+private:
+    struct Job {
+        BatchJob job;
+        std::string experimentFolder;
+        size_t memory = 0;
+    };
+
+    void runJob(size_t index, BatchJob job);
+
+    BatchSchedulerConfig m_config;
+    unsigned int m_threads;
+    unsigned int m_maxConcurrentJobs;
+
+    std::vector<Job> m_jobs;
+    std::vector<BatchResult> m_results;
+    std::function<void(size_t, const BatchResult&)> m_progressCallback;
+
+    std::mutex m_mutex;
+    std::condition_variable m_jobFinished;
+    unsigned int m_runningJobs = 0;
+    size_t m_runningMemory = 0;
+    bool m_cancel = false;
+
+    unsigned int m_peakConcurrentJobs = 0;
+    size_t m_peakMemory = 0;
+};
+
+#endif  // RTOC_BATCHSCHEDULER_H
@@ -0,0 +1,138 @@
+#include "binaryexporter.h"
+
+#include <cstring>
+
+const uint32_t BinaryExporter::s_formatVersion;
+
+BinaryExporter::~BinaryExporter() {
+    if (isOpen()) {
+        close();
+    }
+}
+
+/**
+ * @brief Creates the output file and writes the header
+ * @param dataFlags : data flags of the containers to be exported. PixelIdxList is never exported
+ */
+bool BinaryExporter::open(const std::string& path, unsigned long dataFlags) {
+    m_out.open(path, std::ios::binary | std::ios::trunc);
+    if (!m_out.is_open()) {
+        return false;
+    }
+    m_columns.clear();
+    m_blockOffsets.clear();
+    m_trackCount = 0;
+    m_objectCount = 0;
+
+    // Columns follow the typeMap order, which is also the memory order within a DataObject
+    for (const auto& item : data::typeMap) {
+        const data::DataFlags flag = item.first;
+        if (!(flag & dataFlags) || flag == data::PixelIdxList) {
+            continue;
+        }
+        Column column;
+        column.flag = flag;
+        column.components = std::get<0>(item.second);
+        column.elementBytes = std::get<1>(item.second);
+        column.dataType = column.elementBytes / column.components == sizeof(int32_t) ? 0 : 1;
+        for (const auto& name : data::guiMap) {
+            if (std::get<1>(name.first) == flag) {
+                column.name = name.second;
+            }
+        }
+        m_columns.push_back(column);
+    }
+
+    m_out.write("RTOCBIN\0", 8);
+    writeValue<uint32_t>(s_formatVersion);
+    writeValue<uint32_t>(m_columns.size());
+    for (const auto& column : m_columns) {
+        writeValue<uint32_t>(column.name.size());
+        m_out.write(column.name.data(), column.name.size());
+        writeValue<uint32_t>(column.flag);
+        writeValue<uint32_t>(column.components);
+        writeValue<uint32_t>(column.dataType);
+    }
+    return m_out.good();
+}
+
+/**
+ * @brief Writes tracks [begin, end) as a single block. Null entries (tracks which have already
+ * been released) are skipped
+ */
+bool BinaryExporter::writeBlock(const std::vector<std::unique_ptr<DataContainer>>& tracks,
+                                size_t begin, size_t end) {
+    std::vector<DataContainer*> block;
+    for (size_t i = begin; i < end; i++) {
+        if (tracks[i]) {
+            block.push_back(tracks[i].get());
+        }
+    }
+    return writeBlock(block);
+}
+
+/**
+ * @brief Writes the given tracks as a single block
+ */
+bool BinaryExporter::writeBlock(const std::vector<DataContainer*>& tracks) {
+    if (!isOpen() || tracks.empty()) {
+        return isOpen();
+    }
+
+    std::vector<uint64_t> trackOffsets(1, 0);
+    trackOffsets.reserve(tracks.size() + 1);
+    for (const DataContainer* track : tracks) {
+        trackOffsets.push_back(trackOffsets.back() + track->size());
+    }
+    const uint64_t nObjects = trackOffsets.back();
+
+    m_blockOffsets.push_back(m_out.tellp());
+    m_out.write("BLK\0", 4);
+    writeValue<uint64_t>(tracks.size());
+    writeValue<uint64_t>(nObjects);
+    m_out.write(reinterpret_cast<const char*>(trackOffsets.data()),
+                trackOffsets.size() * sizeof(uint64_t));
+
+    // Gather each column into a contiguous buffer, and write it in one go
+    for (const auto& column : m_columns) {
+        m_buffer.resize(nObjects * column.elementBytes);
+        char* dst = m_buffer.data();
+        for (DataContainer* track : tracks) {
+            if (track->size() == 0) {
+                continue;
+            }
+            const size_t offset = track->front()->offsetOf(column.flag);
+            for (const DataObject* object : *track) {
+                std::memcpy(dst, object->raw() + offset, column.elementBytes);
+                dst += column.elementBytes;
+            }
+        }
+        m_out.write(m_buffer.data(), m_buffer.size());
+    }
+
+    m_trackCount += tracks.size();
+    m_objectCount += nObjects;
+    return m_out.good();
+}
+
+/**
+ * @brief Writes the trailer and closes the file
+ */
+bool BinaryExporter::close() {
+    if (!isOpen()) {
+        return false;
+    }
+    const uint64_t trailerOffset = m_out.tellp();
+    m_out.write("RTOCEND\0", 8);
+    writeValue<uint64_t>(m_blockOffsets.size());
+    m_out.write(reinterpret_cast<const char*>(m_blockOffsets.data()),
+                m_blockOffsets.size() * sizeof(uint64_t));
+    writeValue<uint64_t>(m_trackCount);
+    writeValue<uint64_t>(m_objectCount);
+    writeValue<uint64_t>(trailerOffset);
+    const bool good = m_out.good();
+    m_out.close();
+    m_buffer.clear();
+    m_buffer.shrink_to_fit();
+    return good;
+}
@@ -0,0 +1,83 @@
+#ifndef RTOC_BINARYEXPORTER_H
+#define RTOC_BINARYEXPORTER_H
+
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "datacontainer.h"
+
+/**
+ * @brief The BinaryExporter class
+ * @details Writes experiment data in a columnar binary format. All values are stored little-endian.
+ *
+ * File layout:
+ *  Header
+ *      char[8]     magic "RTOCBIN\0"
+ *      uint32      format version
+ *      uint32      number of columns
+ *      per column:
+ *          uint32      length of name, followed by the name (data::guiMap string, no terminator)
+ *          uint32      data flag (data::DataFlags)
+ *          uint32      number of components (eg. 2 for a point)
+ *          uint32      data type: 0 = int32, 1 = float64
+ *  Blocks, each holding a set of complete tracks
+ *      char[4]     magic "BLK\0"
+ *      uint64      number of tracks (T)
+ *      uint64      number of objects (N)
+ *      uint64[T+1] object offsets of each track within the block
+ *      per column: N * components values, object major
+ *  Trailer
+ *      char[8]     magic "RTOCEND\0"
+ *      uint64      number of blocks (B)
+ *      uint64[B]   file offset of each block
+ *      uint64      total number of tracks
+ *      uint64      total number of objects
+ *      uint64      file offset of the trailer - always the last 8 bytes of the file
+ *
+ * Components are ordered as in cv::Rect (x, y, width, height) and cv::Point (x, y).
+ */
+class BinaryExporter {
+public:
+    static const uint32_t s_formatVersion = 1;
+
+    BinaryExporter() = default;
+    ~BinaryExporter();
+
+    bool open(const std::string& path, unsigned long dataFlags);
+    bool writeBlock(const std::vector<DataContainer*>& tracks);
+    bool writeBlock(const std::vector<std::unique_ptr<DataContainer>>& tracks, size_t begin,
+                    size_t end);
+    bool close();
+    bool isOpen() const { return m_out.is_open(); }
+
+    uint64_t trackCount() const { return m_trackCount; }
+    uint64_t objectCount() const { return m_objectCount; }
+
+private:
+    struct Column {
+        std::string name;
+        data::DataFlags flag;
+        uint32_t components;
+        uint32_t dataType;
+        size_t elementBytes;  // bytes per object, ie. components * sizeof(data type)
+    };
+
+    template <typename T>
+    void writeValue(const T& value) {
+        m_out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    std::ofstream m_out;
+    std::vector<Column> m_columns;
+    std::vector<uint64_t> m_blockOffsets;
+    uint64_t m_trackCount = 0;
+    uint64_t m_objectCount = 0;
+
+    // Column staging buffer, reused between blocks
+    std::vector<char> m_buffer;
+};
+
+#endif  // RTOC_BINARYEXPORTER_H
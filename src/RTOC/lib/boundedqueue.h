@@ -0,0 +1,168 @@
+#ifndef BOUNDEDQUEUE_H
+#define BOUNDEDQUEUE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+/**
+ * @brief Policy applied by a BoundedQueue when an element is enqueued into a full queue
+ *
+ * Block:        the producer waits until the consumer has made room
+ * DropOldest:   the oldest element in the queue is discarded to make room for the new element
+ * DropNewest:   the new element is discarded
+ * DropStorage:  analysis queues block, while image writer queues drop the new element. Ie. we
+ *               never lose data for analysis, but accept holes in the stored image sequence.
+ *               Resolved into Block/DropNewest by the Analyzer when the queues are configured.
+ */
+enum class QueuePolicy { Block, DropOldest, DropNewest, DropStorage };
+
+/**
+ * @brief The BoundedQueue class
+ * @details Thread safe FIFO queue with an optional capacity limit. When the capacity is reached,
+ * the configured QueuePolicy decides whether the producer is blocked, or whether an element is
+ * dropped. All dropped elements are counted, such that the owner can report them.
+ *
+ * The interface mirrors the subset of moodycamel::BlockingReaderWriterQueue which is used
+ * throughout the analyzer, but contrary to the moodycamel queue, elements may be removed from the
+ * producer side (required by QueuePolicy::DropOldest).
+ *
+ * A capacity of 0 denotes an unbounded queue.
+ */
+template <typename T>
+class BoundedQueue {
+public:
+    BoundedQueue(size_t capacity = 0, QueuePolicy policy = QueuePolicy::Block)
+        : m_capacity(capacity), m_policy(policy) {}
+
+    void setCapacity(size_t capacity, QueuePolicy policy) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_capacity = capacity;
+        m_policy = policy;
+        m_notFull.notify_all();
+    }
+
+    /**
+     * @brief Enqueues an element according to the queue policy
+     * @return false if the element (or, for DropOldest, an older element) was dropped
+     */
+    bool enqueue(T&& element) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        bool dropped = false;
+        if (full()) {
+            switch (m_policy) {
+                case QueuePolicy::DropStorage:
+                case QueuePolicy::Block: {
+                    m_notFull.wait(lock, [this] { return !full() || m_aborted; });
+                    if (m_aborted) {
+                        m_dropped++;
+                        return false;
+                    }
+                    break;
+                }
+                case QueuePolicy::DropOldest: {
+                    m_queue.pop_front();
+                    m_dropped++;
+                    dropped = true;
+                    break;
+                }
+                case QueuePolicy::DropNewest: {
+                    m_dropped++;
+                    return false;
+                }
+            }
+        }
+        m_queue.push_back(std::move(element));
+        lock.unlock();
+        m_notEmpty.notify_one();
+        return !dropped;
+    }
+
+    bool enqueue(const T& element) { return enqueue(T(element)); }
+
+    bool try_dequeue(T& result) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_queue.empty()) {
+            return false;
+        }
+        popFront(result, lock);
+        return true;
+    }
+
+    void wait_dequeue(T& result) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_notEmpty.wait(lock, [this] { return !m_queue.empty(); });
+        popFront(result, lock);
+    }
+
+    template <typename Rep, typename Period>
+    bool wait_dequeue_timed(T& result, const std::chrono::duration<Rep, Period>& timeout) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (!m_notEmpty.wait_for(lock, timeout, [this] { return !m_queue.empty(); })) {
+            return false;
+        }
+        popFront(result, lock);
+        return true;
+    }
+
+    bool pop() {
+        T discard;
+        return try_dequeue(discard);
+    }
+
+    size_t size_approx() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_queue.size();
+    }
+
+    size_t capacity() const { return m_capacity; }
+    long droppedCount() const { return m_dropped; }
+
+    /**
+     * @brief Releases a producer blocked in enqueue(). Subsequent enqueues are dropped until
+     * clear() is called
+     */
+    void abort() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_aborted = true;
+        }
+        m_notFull.notify_all();
+    }
+
+    // Empties the queue and resets abort state. Drop counters are kept until resetDroppedCount()
+    void clear() {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_queue.clear();
+            m_aborted = false;
+        }
+        m_notFull.notify_all();
+    }
+
+    void resetDroppedCount() { m_dropped = 0; }
+
+private:
+    bool full() const { return m_capacity != 0 && m_queue.size() >= m_capacity; }
+
+    void popFront(T& result, std::unique_lock<std::mutex>& lock) {
+        result = std::move(m_queue.front());
+        m_queue.pop_front();
+        lock.unlock();
+        m_notFull.notify_one();
+    }
+
+    std::deque<T> m_queue;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_notEmpty;
+    std::condition_variable m_notFull;
+
+    size_t m_capacity;
+    QueuePolicy m_policy;
+    std::atomic<long> m_dropped{0};
+    bool m_aborted = false;
+};
+
+#endif  // BOUNDEDQUEUE_H
@@ -70,6 +70,15 @@ void DataContainer::addDataFlag(data::DataFlags flag) {
 
 std::vector<double> DataContainer::extractObjectInDoubles(int objIndex) {
     std::vector<double> returnVector;
+    extractObjectInDoubles(objIndex, returnVector);
+    return returnVector;
+}
+
+/**
+ * @brief Extracts object objIndex into returnVector, reusing its storage
+ */
+void DataContainer::extractObjectInDoubles(int objIndex, std::vector<double>& returnVector) {
+    returnVector.clear();
     if (data::Area & m_dataFlags) {
         returnVector.push_back(m_data[objIndex]->getValue<double>(data::Area));
     }
@@ -130,7 +139,6 @@ std::vector<double> DataContainer::extractObjectInDoubles(int objIndex) {
     if (data::RelativeXpos & m_dataFlags) {
         returnVector.push_back(m_data[objIndex]->getValue<double>(data::RelativeXpos));
     }
-    return returnVector;
 }
 
 std::vector<std::string> DataContainer::extractAttributeName() {
@@ -115,6 +115,11 @@ public:
     template <typename T>
     void setValue(data::DataFlags dataFlag, T value);
 
+    // Raw access for bulk export. All objects of a DataContainer share the same memory layout, so
+    // offsetOf() only needs to be looked up once per container
+    const char* raw() const { return m_memory; }
+    size_t offsetOf(data::DataFlags flag) { return getBytesToData(flag); }
+
 private:
     size_t getBytesToData(data::DataFlags flag);
 
@@ -171,6 +176,7 @@ public:
     void addDataFlag(data::DataFlags flag);  // OR's a flag onto the data collection flags
 
     std::vector<double> extractObjectInDoubles(int objIndex);
+    void extractObjectInDoubles(int objIndex, std::vector<double>& returnVector);
     std::vector<std::string> extractAttributeName();
     std::vector<int> extractAttributeLengths();
 
@@ -5,17 +5,28 @@
 #include <string>
 #include <vector>
 
+#include "binaryexporter.h"
+#include "boundedqueue.h"
 #include "datacontainer.h"
 #include "framefinder.h"
 #include "imagewriter.h"
+#include "latencyrecorder.h"
 #include "mathlab.h"
+#include "tracerecorder.h"
 
 #include "helper.h"
 
-#ifndef NDEBUG
-#define NDEBUG
-#endif
-#include "../external/readerwriterqueue/readerwriterqueue.h"
+/**
+ * @brief A raw image and its processed counterpart, as queued for the object finder. The two are
+ * queued as a single element, such that a drop policy can never separate them.
+ */
+struct AnalysisFrame {
+    cv::Mat raw;
+    cv::Mat processed;
+    LatencyRecorder::Clock::time_point acquired;  // time at which the raw image was acquired
+    LatencyRecorder::Clock::time_point enqueued;  // time at which the frame was queued for analysis
+    long index = 0;                               // acquisition index of the frame
+};
 
 /** @brief Struct for each Experiment. Used as a container for parameters.
  * More functions can be created to change those parameters
@@ -24,15 +35,21 @@
 
 class Experiment {
 public:
-    Experiment() {}
+    Experiment() {
+        writeBuffer_raw.setLatencyHistograms(&latency.stageHistogram(LatencyStage::Write),
+                                             &latency.queueHistogram(LatencyQueue::Storage));
+        writeBuffer_processed.setLatencyHistograms(&latency.stageHistogram(LatencyStage::Write),
+                                                   &latency.queueHistogram(LatencyQueue::Storage));
+        writeBuffer_raw.setTraceRecorder(&trace);
+        writeBuffer_processed.setTraceRecorder(&trace);
+    }
     ~Experiment() {}
 
     mathlab::Line inlet_line;
     mathlab::Line outlet_line;
 
-    // Queues containing processed and raw images
-    moodycamel::BlockingReaderWriterQueue<cv::Mat> processed;
-    moodycamel::BlockingReaderWriterQueue<cv::Mat> raw;
+    // Queue containing raw and processed image pairs, awaiting object finding
+    BoundedQueue<AnalysisFrame> frames;
 
     // ImageWriters are used for writing images to disk after analyzer is done with the images
     ImageWriter writeBuffer_raw;
@@ -40,30 +57,41 @@ public:
 
     long m_currentProcessingFrame = 0;
 
-    // Vector containing found objects
+    // Vector containing found objects. Entries of tracks which have been streamed to trackExporter
+    // are released (nullptr), such that track indices remain valid
     std::vector<std::unique_ptr<DataContainer>> data;
 
+    // Open while closed tracks are streamed to disk during the experiment
+    BinaryExporter trackExporter;
+
+    // Per-stage latencies and queue depths. Kept across reset(), such that they can be reported
+    // after an experiment
+    LatencyRecorder latency;
+
+    // Timeline of the pipeline, recorded if enabled in the Setup
+    TraceRecorder trace;
+
     void reset() {
-        clearCamel(processed);
-        clearCamel(raw);
+        frames.clear();
         writeBuffer_processed.clear();
         writeBuffer_raw.clear();
         data.clear();
+        if (trackExporter.isOpen()) {
+            // Aborted experiment - keep the tracks written so far readable
+            trackExporter.close();
+        }
         m_currentProcessingFrame = 0;
     }
 
+    // Drop counters are kept across reset(), such that they can be reported after an experiment
+    void resetDroppedCounts() {
+        frames.resetDroppedCount();
+        writeBuffer_processed.resetDroppedCount();
+        writeBuffer_raw.resetDroppedCount();
+    }
+
     void setInletOutletLines(std::pair<int, int>& inlet, std::pair<int, int>& outlet) {
-        if (inlet.second - outlet.second == 0) {
-            inlet_line.straight = true;
-            inlet_line.x = inlet.first;
-            outlet_line.straight = true;
-            outlet_line.x = inlet.second;
-        } else {
-            inlet_line.m = -((double) (inlet.first - outlet.first) / (inlet.second - outlet.second));
-            inlet_line.q = (-inlet_line.m) * inlet.first + inlet.second;
-            outlet_line.m = inlet_line.m;
-            outlet_line.q = (-outlet_line.m) * outlet.first + outlet.second;
-        }
+        mathlab::inletOutletLines(inlet, outlet, inlet_line, outlet_line);
     }
 };
 
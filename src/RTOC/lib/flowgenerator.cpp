@@ -0,0 +1,294 @@
+#include "flowgenerator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+
+namespace {
+// M_PI is not defined by every standard library
+constexpr double pi = 3.14159265358979323846;
+
+// Radius of an ellipse with semi-axes a and b in the direction phi from its major axis
+double ellipseRadius(double a, double b, double phi) {
+    const double c = b * std::cos(phi);
+    const double s = a * std::sin(phi);
+    return a * b / std::sqrt(c * c + s * s);
+}
+}  // namespace
+
+FlowGenerator::FlowGenerator(const FlowGeneratorConfig& config) : m_config(config) {
+    if (m_config.width <= 0 || m_config.height <= 0) {
+        throw std::runtime_error("Flow generator frame size must be positive");
+    }
+    if (m_config.speed <= 0 || m_config.density <= 0) {
+        throw std::runtime_error("Flow generator speed and density must be positive");
+    }
+    if (m_config.majorAxisMin <= 0 || m_config.majorAxisMax < m_config.majorAxisMin ||
+        m_config.aspectMin <= 0 || m_config.aspectMax < m_config.aspectMin) {
+        throw std::runtime_error("Flow generator cell size range is invalid");
+    }
+    mathlab::inletOutletLines(m_config.inlet, m_config.outlet, m_inletLine, m_outletLine);
+
+    // Cells flow in the direction in which mathlab::relativeX() increases
+    if (m_inletLine.straight) {
+        m_direction = cv::Point2d(1, 0);
+    } else {
+        const double norm = std::sqrt(m_inletLine.m * m_inletLine.m + 1);
+        m_direction = cv::Point2d(-m_inletLine.m / norm, 1 / norm);
+    }
+    m_normal = cv::Point2d(-m_direction.y, m_direction.x);
+    m_center = cv::Point2d(m_config.width / 2.0, m_config.height / 2.0);
+
+    // Extent of the frame along and across the flow
+    double sMin = 0, sMax = 0, lMax = 0;
+    for (const cv::Point2d corner : {cv::Point2d(0, 0), cv::Point2d(m_config.width, 0),
+                                     cv::Point2d(0, m_config.height),
+                                     cv::Point2d(m_config.width, m_config.height)}) {
+        const cv::Point2d p = corner - m_center;
+        sMin = std::min(sMin, p.dot(m_direction));
+        sMax = std::max(sMax, p.dot(m_direction));
+        lMax = std::max(lMax, std::abs(p.dot(m_normal)));
+    }
+    m_lateralRange = m_config.lateralSpread * lMax;
+
+    const double margin = m_config.majorAxisMax / 2 + 1;
+    m_start = sMin - margin;
+    m_travel = sMax + margin - m_start;
+    const double minSpeed = m_config.speed * (m_config.speedJitter > 0 ? 0.25 : 1.0);
+    m_maxTransit = m_travel / minSpeed;
+    m_meanGap = m_travel / m_config.speed / m_config.density;
+    m_minGap = m_config.minSpacing * m_config.majorAxisMax / m_config.speed;
+
+    // Horizontal illumination gradient, as seen in recorded frames
+    m_background = cv::Mat(m_config.height, m_config.width, CV_8UC1);
+    for (int x = 0; x < m_config.width; x++) {
+        m_background.col(x).setTo(
+            cv::Scalar(m_config.backgroundLevel + 20.0 * (x - m_center.x) / m_config.width));
+    }
+
+    m_rng.seed(m_config.seed);
+    if (m_config.period > 0) {
+        // A single period of cells, which is repeated. The last cell keeps the minimum spacing to
+        // the first cell of the next period
+        m_nextEntry = 0;
+        generateCells(std::max(0.0, m_config.period - m_minGap));
+    } else {
+        // Start early enough for the channel to be full at the first frame
+        m_nextEntry = -m_maxTransit;
+    }
+}
+
+FlowGenerator::Cell FlowGenerator::newCell(long id, double entry) {
+    std::uniform_real_distribution<double> unit(0, 1);
+    std::normal_distribution<double> normal(0, 1);
+    Cell cell;
+    cell.id = id;
+    cell.entry = entry;
+    cell.speed = m_config.speed;
+    const double speedDeviation = normal(m_rng);
+    if (m_config.speedJitter > 0) {
+        cell.speed *= std::max(0.25, 1 + m_config.speedJitter * speedDeviation);
+    }
+    cell.lateral = (2 * unit(m_rng) - 1) * m_lateralRange;
+    cell.majorAxis =
+        m_config.majorAxisMin + unit(m_rng) * (m_config.majorAxisMax - m_config.majorAxisMin);
+    cell.minorAxis = cell.majorAxis * (m_config.aspectMin +
+                                       unit(m_rng) * (m_config.aspectMax - m_config.aspectMin));
+    cell.orientation = std::atan2(m_direction.y, m_direction.x) * 180 / pi +
+                       m_config.orientationJitter * normal(m_rng);
+    cell.level = std::min(255, std::max(0, m_config.cellLevel +
+                                               static_cast<int>((unit(m_rng) - 0.5) * 40)));
+    return cell;
+}
+
+/**
+ * @brief Generates cells until a cell enters after untilFrame
+ */
+void FlowGenerator::generateCells(double untilFrame) {
+    const double exponentialMean = m_meanGap - m_minGap;
+    while (m_nextEntry <= untilFrame) {
+        m_cells.push_back(newCell(static_cast<long>(m_cells.size()), m_nextEntry));
+        double gap = m_minGap;
+        if (exponentialMean > 0) {
+            gap += std::exponential_distribution<double>(1 / exponentialMean)(m_rng);
+        }
+        m_nextEntry += gap;
+    }
+}
+
+/**
+ * @brief Returns the ground truth of all cells which are (partially) in frame frameNo, and a copy
+ * of the cells if cells is given
+ */
+std::vector<FlowObject> FlowGenerator::objectsAt(long frameNo, std::vector<Cell>* cells) {
+    // Cells which have entered, and may not have left yet
+    std::vector<Cell> candidates;
+    if (m_config.period > 0) {
+        // Cells of period k enter k periods after the cells of the first period
+        const long n = static_cast<long>(m_cells.size());
+        const long firstPeriod = static_cast<long>(std::ceil(m_maxTransit / m_config.period)) + 1;
+        for (const Cell& cell : m_cells) {
+            const long kMin = static_cast<long>(
+                std::ceil((frameNo - m_maxTransit - cell.entry) / m_config.period));
+            const long kMax =
+                static_cast<long>(std::floor((frameNo - cell.entry) / m_config.period));
+            for (long k = kMin; k <= kMax; k++) {
+                Cell copy = cell;
+                copy.id = cell.id + (k + firstPeriod) * n;
+                copy.entry = cell.entry + k * m_config.period;
+                candidates.push_back(copy);
+            }
+        }
+    } else {
+        generateCells(frameNo);
+        auto first = std::lower_bound(
+            m_cells.begin(), m_cells.end(), frameNo - m_maxTransit,
+            [](const Cell& cell, double entry) { return cell.entry < entry; });
+        for (auto it = first; it != m_cells.end() && it->entry <= frameNo; ++it) {
+            candidates.push_back(*it);
+        }
+    }
+
+    const cv::Rect frameRect(0, 0, m_config.width, m_config.height);
+    std::vector<FlowObject> objects;
+    for (const Cell& cell : candidates) {
+        const double travelled = (frameNo - cell.entry) * cell.speed;
+        if (travelled > m_travel) {
+            continue;
+        }
+        const cv::Point2d centroid =
+            m_center + m_direction * (m_start + travelled) + m_normal * cell.lateral;
+
+        const double a = cell.majorAxis / 2, b = cell.minorAxis / 2;
+        const double theta = cell.orientation * pi / 180;
+        const double halfWidth = std::sqrt(std::pow(a * std::cos(theta), 2) +
+                                           std::pow(b * std::sin(theta), 2));
+        const double halfHeight = std::sqrt(std::pow(a * std::sin(theta), 2) +
+                                            std::pow(b * std::cos(theta), 2));
+        const int x0 = static_cast<int>(std::floor(centroid.x - halfWidth));
+        const int y0 = static_cast<int>(std::floor(centroid.y - halfHeight));
+        const cv::Rect box(x0, y0, static_cast<int>(std::ceil(centroid.x + halfWidth)) - x0 + 1,
+                           static_cast<int>(std::ceil(centroid.y + halfHeight)) - y0 + 1);
+        const cv::Rect clippedBox = box & frameRect;
+        if (clippedBox.area() == 0) {
+            continue;
+        }
+
+        FlowObject object;
+        object.cell = cell.id;
+        object.centroid = centroid;
+        object.boundingBox = clippedBox;
+        object.area = pi * a * b;
+        object.majorAxis = cell.majorAxis;
+        object.minorAxis = cell.minorAxis;
+        object.orientation = cell.orientation;
+        cv::Point point(cvRound(centroid.x), cvRound(centroid.y));
+        object.inletXpos = mathlab::relativeX(point, m_inletLine);
+        object.outletXpos = mathlab::relativeX(point, m_outletLine);
+        object.clipped = clippedBox != box;
+        object.overlapping = false;
+        objects.push_back(object);
+        if (cells) {
+            cells->push_back(cell);
+        }
+    }
+
+    // Two cells overlap if their centroids are closer than the sum of their radii towards each
+    // other
+    for (size_t i = 0; i < objects.size(); i++) {
+        for (size_t j = i + 1; j < objects.size(); j++) {
+            FlowObject& p = objects[i];
+            FlowObject& q = objects[j];
+            const cv::Point2d d = q.centroid - p.centroid;
+            const double distance = std::sqrt(d.dot(d));
+            if (distance > (p.majorAxis + q.majorAxis) / 2) {
+                continue;
+            }
+            const double angle = std::atan2(d.y, d.x);
+            const double rp = ellipseRadius(p.majorAxis / 2, p.minorAxis / 2,
+                                            angle - p.orientation * pi / 180);
+            const double rq = ellipseRadius(q.majorAxis / 2, q.minorAxis / 2,
+                                            angle - q.orientation * pi / 180);
+            if (distance < rp + rq) {
+                p.overlapping = true;
+                q.overlapping = true;
+            }
+        }
+    }
+    return objects;
+}
+
+std::vector<FlowObject> FlowGenerator::groundTruth(long frameNo) {
+    return objectsAt(frameNo);
+}
+
+/**
+ * @brief Renders frame frameNo. The pixel noise is seeded by the frame number, such that rendering
+ * a frame twice gives identical frames
+ */
+void FlowGenerator::render(long frameNo, cv::Mat& frame) {
+    std::vector<Cell> cells;
+    const std::vector<FlowObject> objects = objectsAt(frameNo, &cells);
+
+    m_background.copyTo(frame);
+    // Cells are drawn with 4 bits of sub-pixel precision, such that slow cells move smoothly
+    const int shift = 4;
+    const double scale = 1 << shift;
+    for (size_t i = 0; i < cells.size(); i++) {
+        const Cell& cell = cells[i];
+        const cv::Point center(cvRound(objects[i].centroid.x * scale),
+                               cvRound(objects[i].centroid.y * scale));
+        const cv::Size axes(cvRound(cell.majorAxis / 2 * scale),
+                            cvRound(cell.minorAxis / 2 * scale));
+        cv::ellipse(frame, center, axes, cell.orientation, 0, 360, cv::Scalar(cell.level),
+                    cv::FILLED, cv::LINE_8, shift);
+    }
+
+    if (m_config.noise > 0) {
+        cv::RNG rng(static_cast<uint64_t>(m_config.seed) * 0x9E3779B97F4A7C15ULL +
+                    static_cast<uint64_t>(frameNo) + 1);
+        cv::Mat noise(frame.size(), CV_16SC1);
+        rng.fill(noise, cv::RNG::NORMAL, cv::Scalar(0), cv::Scalar(m_config.noise));
+        cv::Mat noisy;
+        frame.convertTo(noisy, CV_16SC1);
+        noisy += noise;
+        noisy.convertTo(frame, CV_8UC1);
+    }
+}
+
+/**
+ * @brief Renders frames 0 to count - 1
+ */
+std::vector<cv::Mat> FlowGenerator::renderFrames(long count) {
+    std::vector<cv::Mat> frames(static_cast<size_t>(std::max(0L, count)));
+    for (long i = 0; i < count; i++) {
+        render(i, frames[i]);
+    }
+    return frames;
+}
+
+/**
+ * @brief Writes the ground truth of frames 0 to frameCount - 1 as CSV, one row per cell and frame
+ * @return true if the file was written successfully
+ */
+bool FlowGenerator::writeGroundTruth(const std::string& path, long frameCount) {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        return false;
+    }
+    out << "frame,cell,centroid_x,centroid_y,bbox_x,bbox_y,bbox_width,bbox_height,area,"
+           "major_axis,minor_axis,orientation,inlet_xpos,outlet_xpos,clipped,overlapping\n";
+    for (long frameNo = 0; frameNo < frameCount; frameNo++) {
+        for (const FlowObject& o : objectsAt(frameNo)) {
+            out << frameNo << "," << o.cell << "," << o.centroid.x << "," << o.centroid.y << ","
+                << o.boundingBox.x << "," << o.boundingBox.y << "," << o.boundingBox.width << ","
+                << o.boundingBox.height << "," << o.area << "," << o.majorAxis << ","
+                << o.minorAxis << "," << o.orientation << "," << o.inletXpos << ","
+                << o.outletXpos << "," << o.clipped << "," << o.overlapping << "\n";
+        }
+    }
+    out.close();
+    return !out.fail();
+}
@@ -0,0 +1,123 @@
+#ifndef RTOC_FLOWGENERATOR_H
+#define RTOC_FLOWGENERATOR_H
+
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <opencv/cv.hpp>
+
+#include "mathlab.h"
+
+struct FlowGeneratorConfig {
+    int width = 1024;
+    int height = 256;
+    // Inlet and outlet as set in the Setup, see mathlab::inletOutletLines()
+    std::pair<int, int> inlet = {128, 896};
+    std::pair<int, int> outlet = {128, 896};
+
+    double density = 8;          // mean number of cells in the frame
+    double speed = 4.0;          // pixels per frame
+    double speedJitter = 0;      // relative standard deviation of the speed of each cell
+    double lateralSpread = 0.8;  // fraction of the frame across the flow over which cells spread
+    // Minimum distance between consecutive cells entering the frame, in cell lengths. At 0, cells
+    // enter independently of each other and may overlap
+    double minSpacing = 1.0;
+
+    double majorAxisMin = 12;  // pixels
+    double majorAxisMax = 18;
+    double aspectMin = 0.6;  // minor axis / major axis
+    double aspectMax = 0.9;
+    double orientationJitter = 10;  // standard deviation of the cell orientation in degrees
+
+    int backgroundLevel = 190;
+    int cellLevel = 80;  // mean gray value of cells
+    double noise = 3;    // standard deviation of the pixel noise
+
+    long period = 0;  // if > 0, the flow repeats after period frames
+    unsigned int seed = 0;
+};
+
+/**
+ * @brief Ground truth of a cell in a single frame
+ */
+struct FlowObject {
+    long cell;
+    cv::Point2d centroid;
+    cv::Rect boundingBox;  // clipped to the frame
+    double area;           // area of the full ellipse
+    double majorAxis;
+    double minorAxis;
+    double orientation;  // of the major axis, in degrees
+    double inletXpos;    // mathlab::relativeX() of the centroid to the inlet line
+    double outletXpos;   // mathlab::relativeX() of the centroid to the outlet line
+    bool clipped;        // partially outside the frame
+    bool overlapping;    // overlaps another cell
+};
+
+/**
+ * @brief The FlowGenerator class
+ * @details Generates frames of elliptic cells flowing through the channel, together with the
+ * ground truth of each cell in each frame, for measuring the throughput and accuracy of
+ * regionProps and the tracker at arbitrary cell densities.
+ *
+ * The channel is defined by the inlet and outlet of the Setup, which are converted to lines by
+ * mathlab::inletOutletLines(), exactly as Experiment::setInletOutletLines() does. Cells flow
+ * perpendicular to the lines, from the inlet towards the outlet, and enter at random times such
+ * that on average config.density cells are in the frame. The channel is full from the first frame.
+ *
+ * A frame and its ground truth only depend on the configuration and the frame number, ie. frames
+ * may be generated in any order.
+ */
+class FlowGenerator {
+public:
+    explicit FlowGenerator(const FlowGeneratorConfig& config);
+
+    const FlowGeneratorConfig& config() const { return m_config; }
+    const cv::Mat& background() const { return m_background; }
+
+    void render(long frameNo, cv::Mat& frame);
+    std::vector<cv::Mat> renderFrames(long count);
+    std::vector<FlowObject> groundTruth(long frameNo);
+    bool writeGroundTruth(const std::string& path, long frameCount);
+
+private:
+    struct Cell {
+        long id;
+        double entry;    // frame at which the cell enters
+        double speed;    // pixels per frame
+        double lateral;  // offset from the channel axis
+        double majorAxis;
+        double minorAxis;
+        double orientation;
+        int level;
+    };
+
+    void generateCells(double untilFrame);
+    std::vector<FlowObject> objectsAt(long frameNo, std::vector<Cell>* cells = nullptr);
+    Cell newCell(long id, double entry);
+
+    FlowGeneratorConfig m_config;
+    mathlab::Line m_inletLine;
+    mathlab::Line m_outletLine;
+    cv::Mat m_background;
+
+    // Flow geometry. Positions along the flow are measured from the center of the frame
+    cv::Point2d m_center;
+    cv::Point2d m_direction;  // unit vector of the flow
+    cv::Point2d m_normal;
+    double m_start;         // position at which cells enter
+    double m_travel;        // distance travelled by a cell from entering until leaving the frame
+    double m_lateralRange;  // cells are spread over [-m_lateralRange, m_lateralRange]
+    double m_maxTransit;    // upper bound of the number of frames a cell is in the frame
+    double m_meanGap;       // mean number of frames between cells entering
+    double m_minGap;
+
+    std::mt19937 m_rng;
+    // Cells ordered by entry. If the flow is periodic, the cells entering during the first period
+    std::vector<Cell> m_cells;
+    double m_nextEntry;
+};
+
+#endif  // RTOC_FLOWGENERATOR_H
@@ -0,0 +1,324 @@
+#include "framecache.h"
+
+#include <algorithm>
+
+#include <opencv2/imgcodecs.hpp>
+
+namespace {
+/**
+ * @brief Decodes an image file, and downscales it to fit the thumbnail bounds of the config. The
+ * thumbnail is the frame itself if it already fits
+ * @param bytes : memory held by the frame and thumbnail, as kept by the cache
+ */
+cv::Mat decode(const std::string& file, const FrameCacheConfig& config, cv::Mat& thumbnail,
+               size_t& bytes) {
+    cv::Mat frame = cv::imread(file, cv::IMREAD_GRAYSCALE);
+    thumbnail = frame;
+    if (frame.empty()) {
+        return frame;
+    }
+    if (config.thumbnailWidth > 0 && config.thumbnailHeight > 0) {
+        const double scale = std::min(double(config.thumbnailWidth) / frame.cols,
+                                      double(config.thumbnailHeight) / frame.rows);
+        if (scale < 1) {
+            cv::resize(frame, thumbnail, cv::Size(), scale, scale, cv::INTER_AREA);
+        }
+    }
+    bytes = 0;
+    if (config.keepFrames) {
+        bytes += frame.total() * frame.elemSize();
+    }
+    if (!config.keepFrames || thumbnail.data != frame.data) {
+        bytes += thumbnail.total() * thumbnail.elemSize();
+    }
+    return frame;
+}
+}  // namespace
+
+FrameCache::FrameCache() {}
+
+FrameCache::~FrameCache() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopThread = true;
+    }
+    m_workAvailable.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+/**
+ * @brief Sets the image files of the cache, discarding all cached frames
+ */
+void FrameCache::setFiles(const std::vector<std::string>& files) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_files = files;
+    m_position = 0;
+    clear();
+    m_epoch++;
+}
+
+/**
+ * @brief Sets the configuration of the cache. Cached frames are discarded if the thumbnail bounds
+ * are changed, and evicted as needed to fit a smaller memory budget
+ */
+void FrameCache::setConfig(const FrameCacheConfig& config) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const bool entriesChanged = config.thumbnailWidth != m_config.thumbnailWidth ||
+                                    config.thumbnailHeight != m_config.thumbnailHeight ||
+                                    config.keepFrames != m_config.keepFrames;
+        m_config = config;
+        if (entriesChanged) {
+            clear();
+            m_epoch++;
+        } else {
+            makeRoom(0, false);
+            makeRoom(0, true);
+        }
+    }
+    m_workAvailable.notify_all();
+}
+
+FrameCacheConfig FrameCache::config() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_config;
+}
+
+void FrameCache::setReadyCallback(const std::function<void(size_t)>& callback) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_readyCallback = callback;
+}
+
+/**
+ * @brief Moves the prefetch window to a frame
+ * @param direction : direction of movement, ie. -1 when moving backwards through the files
+ */
+void FrameCache::setPosition(size_t index, int direction) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_position = index;
+        m_direction = direction < 0 ? -1 : 1;
+        if (!m_thread.joinable()) {
+            // The worker is started on first use, such that an unused cache occupies no thread
+            m_thread = std::thread(&FrameCache::workerThread, this);
+        }
+    }
+    m_workAvailable.notify_all();
+}
+
+/**
+ * @brief Returns a cached frame without blocking
+ * @return false if the frame is not cached
+ */
+bool FrameCache::frame(size_t index, cv::Mat& frame) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(index);
+    if (it == m_entries.end() || it->second.frame.empty()) {
+        m_stats.misses++;
+        return false;
+    }
+    m_stats.hits++;
+    touch(it->second);
+    frame = it->second.frame;
+    return true;
+}
+
+/**
+ * @brief Returns a cached thumbnail without blocking
+ * @return false if the frame is not cached
+ */
+bool FrameCache::thumbnail(size_t index, cv::Mat& thumbnail) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_entries.find(index);
+    if (it == m_entries.end()) {
+        m_stats.misses++;
+        return false;
+    }
+    m_stats.hits++;
+    touch(it->second);
+    thumbnail = it->second.thumbnail;
+    return true;
+}
+
+/**
+ * @brief Returns a frame, decoding it on the calling thread if it is not cached
+ * @return false if the file could not be decoded
+ */
+bool FrameCache::readFrame(size_t index, cv::Mat& frame) {
+    if (this->frame(index, frame)) {
+        return true;
+    }
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (index >= m_files.size()) {
+        return false;
+    }
+    const std::string file = m_files[index];
+    const FrameCacheConfig config = m_config;
+    const unsigned long epoch = m_epoch;
+    lock.unlock();
+
+    cv::Mat thumbnail;
+    size_t bytes = 0;
+    frame = decode(file, config, thumbnail, bytes);
+
+    lock.lock();
+    if (epoch == m_epoch) {
+        m_stats.decoded++;
+        if (frame.empty()) {
+            m_failed.insert(index);
+        } else if (!m_entries.count(index)) {
+            makeRoom(bytes, true);
+            insert(index, config.keepFrames ? frame : cv::Mat(), thumbnail, bytes);
+        }
+    }
+    return !frame.empty();
+}
+
+bool FrameCache::contains(size_t index) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.count(index) > 0;
+}
+
+size_t FrameCache::size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_entries.size();
+}
+
+FrameCacheStats FrameCache::stats() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void FrameCache::workerThread() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        size_t index = 0;
+        m_workAvailable.wait(lock, [&] { return m_stopThread || nextPrefetch(index); });
+        if (m_stopThread) {
+            return;
+        }
+        const std::string file = m_files[index];
+        const FrameCacheConfig config = m_config;
+        const unsigned long epoch = m_epoch;
+        lock.unlock();
+
+        cv::Mat thumbnail;
+        size_t bytes = 0;
+        const cv::Mat frame = decode(file, config, thumbnail, bytes);
+
+        lock.lock();
+        if (epoch != m_epoch || m_entries.count(index)) {
+            continue;
+        }
+        m_stats.decoded++;
+        if (frame.empty()) {
+            m_failed.insert(index);
+            continue;
+        }
+        m_frameBytes = bytes;
+        // The frame at the position is always kept, other frames only if they fit the budget
+        // without evicting frames of the window
+        if (!makeRoom(bytes, index == m_position) && index != m_position) {
+            continue;
+        }
+        insert(index, config.keepFrames ? frame : cv::Mat(), thumbnail, bytes);
+        const auto callback = m_readyCallback;
+        lock.unlock();
+        if (callback) {
+            callback(index);
+        }
+        lock.lock();
+    }
+}
+
+/**
+ * @brief Finds the next frame to be decoded by the worker: the frame at the position, or the first
+ * frame of the window which is not cached, if it fits the memory budget
+ */
+bool FrameCache::nextPrefetch(size_t& index) const {
+    const auto needsDecoding = [this](size_t i) {
+        return i < m_files.size() && !m_entries.count(i) && !m_failed.count(i);
+    };
+    if (needsDecoding(m_position)) {
+        index = m_position;
+        return true;
+    }
+
+    // Frames outside the window may be evicted for the frames of the window
+    size_t evictable = 0;
+    for (const auto& entry : m_entries) {
+        if (!inWindow(entry.first)) {
+            evictable += entry.second.bytes;
+        }
+    }
+    if (m_stats.memory - evictable + m_frameBytes > m_config.memoryBudget) {
+        return false;
+    }
+
+    const long position = static_cast<long>(m_position);
+    for (size_t k = 1; k <= m_config.lookahead; k++) {
+        const long ahead = position + m_direction * static_cast<long>(k);
+        if (ahead >= 0 && needsDecoding(ahead)) {
+            index = static_cast<size_t>(ahead);
+            return true;
+        }
+    }
+    for (size_t k = 1; k <= m_config.lookbehind; k++) {
+        const long behind = position - m_direction * static_cast<long>(k);
+        if (behind >= 0 && needsDecoding(behind)) {
+            index = static_cast<size_t>(behind);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool FrameCache::inWindow(size_t index) const {
+    const long offset = (static_cast<long>(index) - static_cast<long>(m_position)) * m_direction;
+    return offset >= 0 ? static_cast<size_t>(offset) <= m_config.lookahead
+                       : static_cast<size_t>(-offset) <= m_config.lookbehind;
+}
+
+/**
+ * @brief Evicts least recently used frames until an entry of the given size fits the memory
+ * budget. Frames of the window are only evicted if evictWindow is set
+ * @return true if the entry fits
+ */
+bool FrameCache::makeRoom(size_t bytes, bool evictWindow) {
+    for (auto it = m_lru.end(); m_stats.memory + bytes > m_config.memoryBudget &&
+                                it != m_lru.begin();) {
+        --it;
+        if (!evictWindow && inWindow(*it)) {
+            continue;
+        }
+        m_stats.memory -= m_entries[*it].bytes;
+        m_stats.evicted++;
+        m_entries.erase(*it);
+        it = m_lru.erase(it);
+    }
+    return m_stats.memory + bytes <= m_config.memoryBudget;
+}
+
+void FrameCache::insert(size_t index, const cv::Mat& frame, const cv::Mat& thumbnail,
+                        size_t bytes) {
+    Entry& entry = m_entries[index];
+    entry.frame = frame;
+    entry.thumbnail = thumbnail;
+    entry.bytes = bytes;
+    m_lru.push_front(index);
+    entry.lru = m_lru.begin();
+    m_stats.memory += bytes;
+}
+
+void FrameCache::touch(Entry& entry) {
+    m_lru.splice(m_lru.begin(), m_lru, entry.lru);
+}
+
+void FrameCache::clear() {
+    m_entries.clear();
+    m_lru.clear();
+    m_failed.clear();
+    m_stats.memory = 0;
+}
@@ -0,0 +1,101 @@
+#ifndef RTOC_FRAMECACHE_H
+#define RTOC_FRAMECACHE_H
+
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <opencv/cv.hpp>
+
+struct FrameCacheConfig {
+    size_t memoryBudget = 256 * 1024 * 1024;  // bytes of decoded frames and thumbnails
+    size_t lookahead = 32;   // frames prefetched following the position, along the direction
+    size_t lookbehind = 8;   // frames prefetched preceding the position
+    int thumbnailWidth = 0;  // bounds of the thumbnails, 0 for no thumbnails
+    int thumbnailHeight = 0;
+    bool keepFrames = true;  // keep decoded frames, or only their thumbnails
+};
+
+struct FrameCacheStats {
+    long hits = 0;
+    long misses = 0;
+    long decoded = 0;  // by the prefetch worker and readFrame()
+    long evicted = 0;
+    size_t memory = 0;  // bytes currently held
+};
+
+/**
+ * @brief The FrameCache class
+ * @details Holds decoded frames of a list of image files, and downscaled thumbnails for display, in
+ * a least recently used cache bounded by a memory budget.
+ *
+ * A worker thread decodes the frames around the position given through setPosition(): the frame
+ * at the position first, then the frames following it along the direction of movement and then
+ * the frames preceding it. Frames within this window are only evicted to make room for the frame
+ * at the position. The ready callback is called from the worker thread for each decoded frame.
+ *
+ * Frames are decoded as grayscale, as read by the analyzer.
+ */
+class FrameCache {
+public:
+    FrameCache();
+    ~FrameCache();
+
+    void setFiles(const std::vector<std::string>& files);
+    void setConfig(const FrameCacheConfig& config);
+    FrameCacheConfig config() const;
+    void setReadyCallback(const std::function<void(size_t)>& callback);
+
+    void setPosition(size_t index, int direction = 1);
+
+    bool frame(size_t index, cv::Mat& frame);
+    bool thumbnail(size_t index, cv::Mat& thumbnail);
+    bool readFrame(size_t index, cv::Mat& frame);
+    bool contains(size_t index) const;
+    size_t size() const;
+
+    FrameCacheStats stats() const;
+
+private:
+    struct Entry {
+        cv::Mat frame;
+        cv::Mat thumbnail;
+        size_t bytes = 0;
+        std::list<size_t>::iterator lru;
+    };
+
+    void workerThread();
+    bool nextPrefetch(size_t& index) const;
+    bool inWindow(size_t index) const;
+    bool makeRoom(size_t bytes, bool evictWindow);
+    void insert(size_t index, const cv::Mat& frame, const cv::Mat& thumbnail, size_t bytes);
+    void touch(Entry& entry);
+    void clear();
+
+    FrameCacheConfig m_config;
+    std::vector<std::string> m_files;
+    std::unordered_map<size_t, Entry> m_entries;
+    std::list<size_t> m_lru;    // most recently used first
+    std::set<size_t> m_failed;  // files which could not be decoded
+    size_t m_position = 0;
+    int m_direction = 1;
+    size_t m_frameBytes = 0;  // size of the last decoded entry, used to estimate the next
+    // Incremented when the files or the configuration are changed, such that frames decoded from
+    // a previous file list or with previous thumbnail bounds are discarded
+    unsigned long m_epoch = 0;
+    FrameCacheStats m_stats;
+    std::function<void(size_t)> m_readyCallback;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_workAvailable;
+    bool m_stopThread = false;
+    std::thread m_thread;
+};
+
+#endif  // RTOC_FRAMECACHE_H
@@ -1,7 +1,18 @@
 #include "framefinder.h"
+#include "imageprefetcher.h"
 
 #include <QRegularExpression>
 
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <limits>
+#include <thread>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 bool framefinder::exists(const std::string& path) {
     struct stat buf;
     return stat(path.c_str(), &buf) == 0;
@@ -81,56 +92,293 @@ int framefinder::get_files(std::vector<Frame>& files, const std::string& folder)
     return 0;
 }
 
+namespace {
 /**
- * @brief hasChanged determines whether img2 is different from img1. Given a movement threshold the
- * two images a
- * subtracted from eachother and the largest pixel value are found. _Movement_ is then detected if
- * the max-pixel value
- * is larger than the given threshold.
+ * @brief Returns true if |a[i] - b[i]| > threshold for any i < n. Exits on the first chunk of 64
+ * pixels containing a difference above threshold
+ */
+bool rowExceeds(const uchar* a, const uchar* b, int n, uchar threshold) {
+    int i = 0;
+#ifdef __SSE2__
+    const __m128i thresh = _mm_set1_epi8(static_cast<char>(threshold));
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 64 <= n; i += 64) {
+        __m128i hit = zero;
+        for (int k = 0; k < 64; k += 16) {
+            __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i + k));
+            __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i + k));
+            // |a - b| through saturated subtraction in both directions, then subtract threshold -
+            // any non-zero byte is a pixel above threshold
+            __m128i diff = _mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va));
+            hit = _mm_or_si128(hit, _mm_subs_epu8(diff, thresh));
+        }
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(hit, zero)) != 0xFFFF) {
+            return true;
+        }
+    }
+#endif
+    for (; i < n; i++) {
+        if (std::abs(a[i] - b[i]) > threshold) {
+            return true;
+        }
+    }
+    return false;
+}
+}  // namespace
+
+/**
+ * @brief hasChanged determines whether img2 is different from img1. Movement is detected if the
+ * absolute difference of any pixel in the two images is larger than the given threshold
  * @param img1          :   cv::Mat()   :   old image
  * @param img2          :   cv::Mat()   :   new image
  * @param threshold     :   int         :   movement threshold
  * @return              :   bool        :   true if movement, otherwise false
  */
 bool framefinder::hasChanged(const cv::Mat& img1, const cv::Mat& img2, const int& threshold) {
-    double crit = 0.0;
-    cv::minMaxIdx(img1 - img2, nullptr, &crit);
-    return crit > threshold;
+    return hasChanged(img1, img2, threshold, cv::Rect(0, 0, img1.cols, img1.rows));
+}
+
+/**
+ * @brief hasChanged variant which only considers the pixels inside roi, on a grid with a spacing
+ * of step pixels in both directions. The comparison is done in a single pass without temporary
+ * images, and returns as soon as a changed pixel has been found.
+ * @param roi           :   cv::Rect    :   region of the images to compare
+ * @param step          :   int         :   grid spacing, 1 compares all pixels in roi
+ */
+bool framefinder::hasChanged(const cv::Mat& img1, const cv::Mat& img2, const int& threshold,
+                             const cv::Rect& roi, const int& step) {
+    const cv::Rect r = roi & cv::Rect(0, 0, img1.cols, img1.rows);
+    if (img1.size() != img2.size() || img1.type() != img2.type() || img1.depth() != CV_8U) {
+        // Fallback for differently sized or non 8-bit images
+        if (img1.size() != img2.size() || img1.type() != img2.type()) {
+            return true;
+        }
+        cv::Mat diff;
+        cv::absdiff(img1(r), img2(r), diff);
+        double crit = 0.0;
+        cv::minMaxIdx(diff.reshape(1), nullptr, &crit);
+        return crit > threshold;
+    }
+    if (threshold < 0) {
+        return !r.empty();
+    }
+    if (threshold >= 255) {
+        return false;
+    }
+
+    const int channels = img1.channels();
+    const int rowStep = std::max(1, step);
+    const uchar thresh = static_cast<uchar>(threshold);
+    for (int y = r.y; y < r.y + r.height; y += rowStep) {
+        const uchar* a = img1.ptr<uchar>(y) + r.x * channels;
+        const uchar* b = img2.ptr<uchar>(y) + r.x * channels;
+        if (rowStep == 1) {
+            if (rowExceeds(a, b, r.width * channels, thresh)) {
+                return true;
+            }
+        } else {
+            for (int x = 0; x < r.width * channels; x += rowStep * channels) {
+                if (std::abs(a[x] - b[x]) > threshold) {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
 }
 
 /**
  * Accept_or_reject
  *
- * @param frames        :   vector<string>  :   full list of images
+ * @param frames        :   vector<Frame>   :   full list of images, sorted by id
  * @param img_folder    :   string          :   path to image folder
- * @param path_acc      :   string          :   path to "accepted" txt-file
- * @param path_dis      :   string          :   path to "discarded" txt-file
+ * @param threshold     :   double          :   movement threshold (pixel value difference)
  */
 void framefinder::accept_or_reject(std::vector<Frame>& frames, const std::string& img_folder,
                                    const double& threshold) {
-    double crit = 0.0;
+    accept_or_reject(frames, img_folder, threshold,
+                     std::max(1u, std::thread::hardware_concurrency()));
+}
 
-    cv::Mat lastMoved = cv::imread(img_folder + "/" + frames[0].filename, cv::IMREAD_GRAYSCALE);
-    ;
+/**
+ * @brief Multithreaded accept_or_reject. Runs in two passes:
+ *
+ * 1. The frame list is split into chunks which are distributed over the worker threads. Each
+ *    worker decodes its chunk sequentially and scores each frame by the largest absolute pixel
+ *    difference to the preceding frame. Only two images per worker are held in memory.
+ * 2. A sequential pass compares frames with the last accepted frame, as the single threaded
+ *    version does. The difference of a frame to the last accepted frame is bounded by the sum of
+ *    the scores since that frame, so frames for which this sum does not exceed the threshold are
+ *    rejected without decoding them again. The remaining candidates are decoded ahead by an
+ *    ImagePrefetcher on the worker threads and compared with the last accepted frame.
+ *
+ * Frame::image is left empty.
+ */
+void framefinder::accept_or_reject(std::vector<Frame>& frames, const std::string& img_folder,
+                                   const double& threshold, unsigned int threads) {
+    if (frames.empty()) {
+        return;
+    }
 
-    // Loop through all pictures
-    for (auto& frame : frames) {
-        std::string img_path = img_folder + "/" + frame.filename;
-        frame.image = cv::imread(img_path, cv::IMREAD_GRAYSCALE);
-        cv::minMaxIdx(lastMoved - frame.image, nullptr, &crit);
+    const size_t chunkSize = 64;
+    const size_t nChunks = (frames.size() + chunkSize - 1) / chunkSize;
+    std::vector<double> scores(frames.size(), 0.0);
+    std::atomic<size_t> nextChunk{0};
 
-        int _crit = crit;
-        _crit >>= 8;  // crit /= 256
+    auto scoreChunks = [&] {
+        cv::Mat previous, current;
+        for (size_t chunk = nextChunk++; chunk < nChunks; chunk = nextChunk++) {
+            const size_t begin = chunk * chunkSize;
+            const size_t end = std::min(frames.size(), begin + chunkSize);
+            // Decode the frame preceding the chunk, to be able to score its first frame
+            previous = begin == 0
+                           ? cv::Mat()
+                           : cv::imread(img_folder + "/" + frames[begin - 1].filename,
+                                        cv::IMREAD_GRAYSCALE);
+            for (size_t i = begin; i < end; i++) {
+                current = cv::imread(img_folder + "/" + frames[i].filename, cv::IMREAD_GRAYSCALE);
+                if (previous.empty() || current.empty() || previous.size() != current.size()) {
+                    // First frame, or frames which cannot be compared, are always accepted
+                    scores[i] = std::numeric_limits<double>::max();
+                } else {
+                    scores[i] = cv::norm(previous, current, cv::NORM_INF);
+                }
+                std::swap(previous, current);
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned int i = 1; i < std::max(1u, threads); i++) {
+        workers.emplace_back(scoreChunks);
+    }
+    scoreChunks();
+    for (auto& worker : workers) {
+        worker.join();
+    }
 
-        if (_crit <= threshold) {
-            // Discard
-            frame.accepted = false;
+    // Frames identical to their predecessor never raise the bound above a non-negative threshold,
+    // so only frames with a positive score can become candidates. These are decoded ahead on the
+    // worker threads, in file order
+    std::vector<size_t> prefetched;
+    std::vector<std::string> paths;
+    for (size_t i = 0; i < frames.size(); i++) {
+        if (scores[i] > 0.0 || threshold < 0.0) {
+            prefetched.push_back(i);
+            paths.push_back(img_folder + "/" + frames[i].filename);
+        }
+    }
+    ImagePrefetcher prefetcher;
+    prefetcher.setConfig(2 * std::max(1u, threads), threads);
+    prefetcher.setFiles(paths);
+
+    // Sequential accept pass. bound is an upper bound of the difference of the current frame to
+    // the last accepted frame
+    cv::Mat lastAccepted;
+    double bound = 0.0;
+    size_t next = 0;  // Index in prefetched of the next frame which may become a candidate
+    for (size_t i = 0; i < frames.size(); i++) {
+        bound = std::min(bound + scores[i], std::numeric_limits<double>::max());
+        frames[i].image.release();
+        frames[i].accepted = false;
+        if (next < prefetched.size() && prefetched[next] == i) {
+            next++;
+        }
+        if (bound <= threshold) {
+            continue;
+        }
+
+        // Skip over prefetched frames which were rejected by their bound. When the candidate lies
+        // beyond the read-ahead window, the frames in between are not decoded at all
+        const size_t position = next - 1;
+        if (position >= prefetcher.position() + prefetcher.window()) {
+            prefetcher.seek(position);
+        }
+        cv::Mat candidate;
+        while (prefetcher.position() <= position) {
+            prefetcher.next(candidate);
+        }
+
+        if (lastAccepted.empty() || candidate.empty() || lastAccepted.size() != candidate.size()) {
+            frames[i].accepted = true;
         } else {
-            // Accept
-            frame.accepted = true;
-            lastMoved = frame.image;
+            // Frames following a rejected candidate are bounded by its exact difference
+            bound = cv::norm(lastAccepted, candidate, cv::NORM_INF);
+            frames[i].accepted = bound > threshold;
         }
+        if (frames[i].accepted) {
+            lastAccepted = candidate;
+            bound = 0.0;
+        }
+    }
+}
+
+/**
+ * @brief Writes the filenames of accepted and rejected frames to two text files, one filename per
+ * line
+ * @return false if either file could not be written
+ */
+bool framefinder::write_frame_lists(const std::vector<Frame>& frames,
+                                    const std::string& accepted_path,
+                                    const std::string& rejected_path) {
+    std::ofstream accepted(accepted_path);
+    std::ofstream rejected(rejected_path);
+    if (!accepted.is_open() || !rejected.is_open()) {
+        return false;
+    }
+    for (const Frame& f : frames) {
+        (f.accepted ? accepted : rejected) << f.filename << "\n";
+    }
+    return accepted.good() && rejected.good();
+}
+
+/**
+ * @brief Reads a frame list written by write_frame_lists
+ */
+bool framefinder::read_frame_list(const std::string& path, std::vector<std::string>& filenames) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(file, line)) {
+        if (!line.empty()) {
+            filenames.push_back(line);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Lists the .png, .jpg, .bmp and .tif images of a folder, ordered by the frame number in
+ * their filenames (eg. raw_12.png)
+ *
+ * @param folder : folder to list
+ * @param paths : paths of the images
+ * @return false if the folder could not be read or contains no images
+ */
+bool framefinder::read_image_folder(const std::string& folder, std::vector<std::string>& paths) {
+    std::vector<std::pair<long, std::string>> images;
+    boost::system::error_code ec;
+    for (boost::filesystem::directory_iterator it(folder, ec), end; !ec && it != end;
+         it.increment(ec)) {
+        std::string extension = it->path().extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+        if (extension == ".png" || extension == ".jpg" || extension == ".bmp" ||
+            extension == ".tif" || extension == ".tiff") {
+            const std::string filename = it->path().filename().string();
+            const long id = strtol(extractBetween(filename).c_str(), nullptr, 10);
+            images.emplace_back(id, it->path().string());
+        }
+    }
+    if (ec || images.empty()) {
+        return false;
+    }
+    std::sort(images.begin(), images.end());
+    for (const auto& image : images) {
+        paths.push_back(image.second);
     }
+    return true;
 }
 
 void framefinder::get_accepted(const std::vector<Frame>& frames, std::vector<Frame>& output) {
@@ -37,8 +37,16 @@ std::string extractBetween(const std::string& src, const std::string& first = "_
 int get_files(std::vector<Frame>& files, const std::string& folder);
 void accept_or_reject(std::vector<Frame>& frames, const std::string& img_folder,
                       const double& threshold);
+void accept_or_reject(std::vector<Frame>& frames, const std::string& img_folder,
+                      const double& threshold, unsigned int threads);
+bool write_frame_lists(const std::vector<Frame>& frames, const std::string& accepted_path,
+                       const std::string& rejected_path);
+bool read_frame_list(const std::string& path, std::vector<std::string>& filenames);
+bool read_image_folder(const std::string& folder, std::vector<std::string>& paths);
 
 bool hasChanged(const cv::Mat& img1, const cv::Mat& img2, const int& threshold);
+bool hasChanged(const cv::Mat& img1, const cv::Mat& img2, const int& threshold,
+                const cv::Rect& roi, const int& step = 1);
 void get_accepted(const std::vector<Frame>& frames, std::vector<Frame>& output);
 void get_rejected(const std::vector<Frame>& frames, std::vector<Frame>& output);
 
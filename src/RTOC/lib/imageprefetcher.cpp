@@ -0,0 +1,184 @@
+#include "imageprefetcher.h"
+
+#include <algorithm>
+
+namespace {
+typedef std::chrono::steady_clock Clock;
+
+long elapsedNs(const Clock::time_point& t0, const Clock::time_point& t1) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+}
+}  // namespace
+
+ImagePrefetcher::ImagePrefetcher()
+    : m_window(16), m_threadCount(std::max(1u, std::thread::hardware_concurrency() / 2)) {
+    m_slots.resize(m_window);
+}
+
+ImagePrefetcher::~ImagePrefetcher() {
+    stopThreads();
+}
+
+void ImagePrefetcher::setFiles(const std::vector<std::string>& files) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_files = files;
+    restart(0);
+}
+
+/**
+ * @brief Sets the read-ahead window and the number of decoder threads. Must not be called while
+ * the consumer may be inside next()
+ */
+void ImagePrefetcher::setConfig(size_t window, unsigned int threads) {
+    window = std::max<size_t>(1, window);
+    threads = std::max(1u, threads);
+    if (window == m_window && threads == m_threadCount) {
+        return;
+    }
+
+    // Decoder threads are restarted on the next call to next()
+    stopThreads();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_window = window;
+    m_threadCount = threads;
+    restart(m_consumeIndex);
+}
+
+/**
+ * @brief Discards all prefetched images and restarts reading at index
+ */
+void ImagePrefetcher::seek(size_t index) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    restart(index);
+    m_hasReturned = false;
+}
+
+/**
+ * @brief Returns the next image in file list order, blocking until it has been decoded
+ * @param image : set to the decoded image. Empty if the file could not be decoded
+ * @return false if the end of the file list has been reached
+ */
+bool ImagePrefetcher::next(cv::Mat& image) {
+    const auto t0 = Clock::now();
+    if (m_hasReturned) {
+        m_consumerNs += elapsedNs(m_lastReturn, t0);
+    }
+    if (m_threads.empty()) {
+        startThreads();
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_consumeIndex >= m_files.size()) {
+        m_hasReturned = false;
+        return false;
+    }
+    Slot& slot = m_slots[m_consumeIndex % m_window];
+    const long index = m_consumeIndex;
+    m_imageReady.wait(lock, [&] { return slot.index == index; });
+    image = slot.image;
+    slot.image.release();
+    slot.index = -1;
+    m_consumeIndex++;
+    lock.unlock();
+
+    // A slot has been freed for the next file in line
+    m_workAvailable.notify_one();
+
+    m_lastReturn = Clock::now();
+    m_hasReturned = true;
+    m_waitNs += elapsedNs(t0, m_lastReturn);
+    m_consumedImages++;
+    return true;
+}
+
+size_t ImagePrefetcher::position() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_consumeIndex;
+}
+
+size_t ImagePrefetcher::size() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_files.size();
+}
+
+PrefetchStats ImagePrefetcher::stats() const {
+    PrefetchStats stats;
+    stats.decodedImages = m_decodedImages;
+    stats.decodeMs = m_decodeNs / 1e6;
+    stats.consumedImages = m_consumedImages;
+    stats.waitMs = m_waitNs / 1e6;
+    stats.consumerMs = m_consumerNs / 1e6;
+    return stats;
+}
+
+void ImagePrefetcher::resetStats() {
+    m_decodedImages = 0;
+    m_decodeNs = 0;
+    m_consumedImages = 0;
+    m_waitNs = 0;
+    m_consumerNs = 0;
+}
+
+void ImagePrefetcher::startThreads() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopThreads = false;
+    }
+    for (unsigned int i = 0; i < m_threadCount; i++) {
+        m_threads.emplace_back(&ImagePrefetcher::decodeThreaded, this);
+    }
+}
+
+void ImagePrefetcher::stopThreads() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopThreads = true;
+    }
+    m_workAvailable.notify_all();
+    for (auto& t : m_threads) {
+        t.join();
+    }
+    m_threads.clear();
+}
+
+// Must be called with m_mutex held
+void ImagePrefetcher::restart(size_t index) {
+    m_epoch++;
+    m_consumeIndex = index;
+    m_decodeIndex = index;
+    m_slots.assign(m_window, Slot());
+    m_workAvailable.notify_all();
+}
+
+void ImagePrefetcher::decodeThreaded() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_workAvailable.wait(lock, [this] {
+            return m_stopThreads || (m_decodeIndex < m_files.size() &&
+                                     m_decodeIndex < m_consumeIndex + m_window);
+        });
+        if (m_stopThreads) {
+            return;
+        }
+
+        // Claim the next file in line and decode it without holding the lock
+        const size_t index = m_decodeIndex++;
+        const unsigned long epoch = m_epoch;
+        const std::string file = m_files[index];
+        lock.unlock();
+
+        const auto t0 = Clock::now();
+        cv::Mat image = cv::imread(file, cv::IMREAD_GRAYSCALE);
+        m_decodeNs += elapsedNs(t0, Clock::now());
+        m_decodedImages++;
+
+        lock.lock();
+        if (epoch == m_epoch) {
+            // Image still belongs to the current read pass
+            Slot& slot = m_slots[index % m_window];
+            slot.index = index;
+            slot.image = image;
+            m_imageReady.notify_all();
+        }
+    }
+}
@@ -0,0 +1,87 @@
+#ifndef RTOC_IMAGEPREFETCHER_H
+#define RTOC_IMAGEPREFETCHER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv/cv.hpp>
+
+struct PrefetchStats {
+    long decodedImages = 0;
+    double decodeMs = 0;  // summed over all decoder threads
+    long consumedImages = 0;
+    double waitMs = 0;      // time the consumer was blocked waiting for a decoded image
+    double consumerMs = 0;  // time spent by the consumer between requests, ie. analysis time
+};
+
+/**
+ * @brief The ImagePrefetcher class
+ * @details Decodes a list of image files ahead of the consumer on a pool of decoder threads.
+ * Up to window images following the current read position are decoded concurrently, and are
+ * delivered through next() in file list order.
+ *
+ * A single consumer thread is assumed. Decoder threads are started on the first call to next(),
+ * such that an unused prefetcher does not occupy any threads.
+ */
+class ImagePrefetcher {
+public:
+    ImagePrefetcher();
+    ~ImagePrefetcher();
+
+    void setFiles(const std::vector<std::string>& files);
+    void setConfig(size_t window, unsigned int threads);
+    size_t window() const { return m_window; }
+    unsigned int threads() const { return m_threadCount; }
+
+    void seek(size_t index);
+    bool next(cv::Mat& image);
+    size_t position() const;
+    size_t size() const;
+
+    PrefetchStats stats() const;
+    void resetStats();
+
+private:
+    void startThreads();
+    void stopThreads();
+    void decodeThreaded();
+    void restart(size_t index);
+
+    struct Slot {
+        long index = -1;  // file index of the decoded image held in the slot, -1 if empty
+        cv::Mat image;
+    };
+
+    std::vector<std::string> m_files;
+    std::vector<Slot> m_slots;
+    size_t m_window;
+    unsigned int m_threadCount;
+
+    // Read position of the consumer and the next file to be handed to a decoder thread. Files
+    // [m_consumeIndex, m_decodeIndex) are being decoded or are ready in m_slots
+    size_t m_consumeIndex = 0;
+    size_t m_decodeIndex = 0;
+    // Incremented on each restart, such that decoders can discard images of a previous read pass
+    unsigned long m_epoch = 0;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_workAvailable;
+    std::condition_variable m_imageReady;
+    std::vector<std::thread> m_threads;
+    bool m_stopThreads = false;
+
+    std::atomic<long> m_decodedImages{0};
+    std::atomic<long> m_decodeNs{0};
+    std::atomic<long> m_consumedImages{0};
+    std::atomic<long> m_waitNs{0};
+    std::atomic<long> m_consumerNs{0};
+    std::chrono::steady_clock::time_point m_lastReturn;
+    bool m_hasReturned = false;
+};
+
+#endif  // RTOC_IMAGEPREFETCHER_H
@@ -10,14 +10,12 @@
 
 #include "external/timer/timer.h"
 
+#include "boundedqueue.h"
 #include "helper.h"
+#include "latencyrecorder.h"
+#include "tracerecorder.h"
 #include "setup.h"
 
-#ifndef NDEBUG
-#define NDEBUG
-#endif
-#include "../external/readerwriterqueue/readerwriterqueue.h"
-
 namespace {
 namespace fs = boost::filesystem;
 }
@@ -26,10 +24,28 @@ class ImageWriter {
 public:
     ImageWriter() = default;
 
-    void push(const cv::Mat& img) { m_queue.enqueue(img.clone()); }
+    void push(const cv::Mat& img) {
+        if (m_queueDepth) {
+            m_queueDepth->record(m_queue.size_approx());
+        }
+        if (m_trace && m_trace->enabled()) {
+            m_trace->counter(m_traceDepthName, static_cast<double>(m_queue.size_approx()));
+        }
+        m_queue.enqueue(img.clone());
+    }
+    void setCapacity(size_t capacity, QueuePolicy policy) { m_queue.setCapacity(capacity, policy); }
+    long droppedCount() const { return m_queue.droppedCount(); }
+    void resetDroppedCount() { m_queue.resetDroppedCount(); }
+    size_t queueSize() const { return m_queue.size_approx(); }
+    // Histograms receiving the duration of each image write, and the queue depth at each push
+    void setLatencyHistograms(LatencyHistogram* writeTime, LatencyHistogram* queueDepth) {
+        m_writeTime = writeTime;
+        m_queueDepth = queueDepth;
+    }
+    void setTraceRecorder(TraceRecorder* trace) { m_trace = trace; }
     void clear() {
         // clear queue
-        clearCamel(m_queue);
+        m_queue.clear();
         m_running = false;
         m_finishedWriting = false;
         m_targetImageCount = -1;
@@ -42,6 +58,9 @@ public:
             m_path = path;
             m_prefix = prefix;
             m_index = 0;
+            if (m_trace) {
+                m_traceDepthName = m_trace->internName(prefix + " queue depth");
+            }
             std::thread t(&ImageWriter::writeThreaded, this);
             t.detach();
         }
@@ -55,14 +74,18 @@ public:
         }
     }
 
-    void forceStop() { m_forceStop = true; }
+    void forceStop() {
+        m_forceStop = true;
+        // release producers which are blocked on a full queue
+        m_queue.abort();
+    }
 
 private:
     volatile bool m_finishedWriting = false;  // avoid optimizing finishWriting() while loop
     bool m_running = false;
     bool m_forceStop = false;
 
-    moodycamel::BlockingReaderWriterQueue<cv::Mat> m_queue;
+    BoundedQueue<cv::Mat> m_queue;
 
     Setup m_setup;
 
@@ -72,21 +95,31 @@ private:
     int m_index = 0;
     int m_targetImageCount = -1;
 
+    LatencyHistogram* m_writeTime = nullptr;
+    LatencyHistogram* m_queueDepth = nullptr;
+    TraceRecorder* m_trace = nullptr;
+    const char* m_traceDepthName = "Storage queue depth";
+
     void writeThreaded() {
         // Will monitor m_queue until m_run is deasserted
         // When deasserted, m_queue will be emptied
         cv::Mat front;
         bool queueHasValue = false;
+        if (m_trace) {
+            m_trace->setThreadName("Image writer (" + m_prefix + ")");
+        }
 
         // Monitor queue until
         //  1. targetImageCount has been set (this will be set when the imageWriter is told to stop
         //  executing
         //  and
-        //  2. our index (image count) is equals to the target image count
-        while (!(m_targetImageCount >= 0 && m_targetImageCount <= m_index)) {
+        //  2. our index (image count) plus the images dropped by the queue policy equals the
+        //  target image count
+        while (!(m_targetImageCount >= 0 &&
+                 m_targetImageCount <= m_index + m_queue.droppedCount())) {
             if (m_forceStop) {
                 // Halt image writer
-                clearCamel(m_queue);
+                m_queue.clear();
                 goto finish;
             }
             // To not create a high-priority thread, we do small thread sleeps to enable OS to
@@ -97,7 +130,15 @@ private:
             if (queueHasValue) {
                 std::string filepath =
                     (m_path / fs::path(m_prefix + "_" + std::to_string(m_index) + ".png")).string();
+                const auto start = LatencyRecorder::now();
                 cv::imwrite(filepath, front);
+                const auto end = LatencyRecorder::now();
+                if (m_writeTime) {
+                    m_writeTime->record(LatencyRecorder::toNs(end - start));
+                }
+                if (m_trace) {
+                    m_trace->span("Write image", m_index, start, end);
+                }
                 m_index++;
             } else {
                 // error in writing images - did not find the expected amt of images in the queue,
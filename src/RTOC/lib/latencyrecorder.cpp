@@ -0,0 +1,217 @@
+#include "latencyrecorder.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+// --------------------- LatencyHistogram ---------------------
+LatencyHistogram::LatencyHistogram() {
+    reset();
+}
+
+void LatencyHistogram::reset() {
+    for (auto& count : m_counts) {
+        count.store(0, std::memory_order_relaxed);
+    }
+    m_total.store(0, std::memory_order_relaxed);
+    m_sum.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+int LatencyHistogram::bucketIndex(uint64_t value) {
+    if (value < static_cast<uint64_t>(s_subBuckets)) {
+        return static_cast<int>(value);
+    }
+#ifdef __GNUC__
+    const int msb = 63 - __builtin_clzll(value);
+#else
+    int msb = 0;
+    for (uint64_t v = value; v > 1; v >>= 1) {
+        msb++;
+    }
+#endif
+    // value is in [16, 32) << shift, and the bits below the 4 most significant bits are dropped
+    const int shift = msb - s_subBucketBits;
+    const int subBucket = static_cast<int>((value >> shift) & (s_subBuckets - 1));
+    return (shift + 1) * s_subBuckets + subBucket;
+}
+
+/**
+ * @brief Returns the largest value which is counted in the bucket at index
+ */
+uint64_t LatencyHistogram::bucketUpperValue(int index) {
+    if (index < s_subBuckets) {
+        return static_cast<uint64_t>(index);
+    }
+    const int shift = index / s_subBuckets - 1;
+    const uint64_t subBucket = static_cast<uint64_t>(index % s_subBuckets);
+    const uint64_t lower = (static_cast<uint64_t>(s_subBuckets) + subBucket) << shift;
+    return lower + ((uint64_t(1) << shift) - 1);
+}
+
+void LatencyHistogram::record(uint64_t value) {
+    m_counts[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    m_total.fetch_add(1, std::memory_order_relaxed);
+    m_sum.fetch_add(value, std::memory_order_relaxed);
+
+    uint64_t currentMax = m_max.load(std::memory_order_relaxed);
+    while (value > currentMax &&
+           !m_max.compare_exchange_weak(currentMax, value, std::memory_order_relaxed)) {
+    }
+}
+
+uint64_t LatencyHistogram::count() const {
+    return m_total.load(std::memory_order_relaxed);
+}
+
+double LatencyHistogram::mean() const {
+    const uint64_t total = count();
+    return total == 0 ? 0 : static_cast<double>(m_sum.load(std::memory_order_relaxed)) / total;
+}
+
+/**
+ * @brief Returns the value below or at which p percent of the recorded values lie. The value is
+ * rounded up to the largest value of its bucket, but never reported above the recorded maximum
+ * @param p : percentile in [0, 100]
+ */
+uint64_t LatencyHistogram::percentile(double p) const {
+    const uint64_t total = count();
+    if (total == 0) {
+        return 0;
+    }
+    p = std::min(100.0, std::max(0.0, p));
+    // Rank of the requested value, 1-based
+    const uint64_t rank =
+        std::max<uint64_t>(1, static_cast<uint64_t>(p / 100.0 * static_cast<double>(total) + 0.5));
+
+    uint64_t seen = 0;
+    for (int i = 0; i < s_bucketCount; i++) {
+        seen += m_counts[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            return std::min(bucketUpperValue(i), max());
+        }
+    }
+    // Counts were recorded after total was read
+    return max();
+}
+
+// --------------------- LatencyRecorder ---------------------
+LatencyRecorder::LatencyRecorder() {}
+
+/**
+ * @brief Sets the processes of the process chain, in chain order, and resets their histograms
+ */
+void LatencyRecorder::setProcessNames(const std::vector<std::string>& names) {
+    std::lock_guard<std::mutex> lock(m_processMutex);
+    m_processNames = names;
+    m_processes.clear();
+    for (size_t i = 0; i < names.size(); i++) {
+        m_processes.emplace_back(new LatencyHistogram());
+    }
+}
+
+void LatencyRecorder::reset() {
+    for (auto& histogram : m_stages) {
+        histogram.reset();
+    }
+    for (auto& histogram : m_queues) {
+        histogram.reset();
+    }
+    std::lock_guard<std::mutex> lock(m_processMutex);
+    for (auto& histogram : m_processes) {
+        histogram->reset();
+    }
+}
+
+const char* LatencyRecorder::stageName(LatencyStage stage) {
+    switch (stage) {
+        case LatencyStage::Acquire:
+            return "Acquire";
+        case LatencyStage::Processing:
+            return "Processing";
+        case LatencyStage::AnalysisQueue:
+            return "Analysis queue wait";
+        case LatencyStage::ObjectFinding:
+            return "Object finding";
+        case LatencyStage::Classification:
+            return "Classification";
+        case LatencyStage::Write:
+            return "Write image";
+        case LatencyStage::EndToEnd:
+            return "End to end";
+        case LatencyStage::Count:
+            break;
+    }
+    return "";
+}
+
+const char* LatencyRecorder::queueName(LatencyQueue queue) {
+    switch (queue) {
+        case LatencyQueue::Analysis:
+            return "Analysis queue";
+        case LatencyQueue::Storage:
+            return "Storage queue";
+        case LatencyQueue::Count:
+            break;
+    }
+    return "";
+}
+
+namespace {
+void appendRow(std::string& out, const std::string& name, const LatencyHistogram& histogram,
+               double scale, int precision) {
+    char row[160];
+    std::snprintf(row, sizeof(row), "%-32.32s %10llu %10.*f %10.*f %10.*f\n", name.c_str(),
+                  static_cast<unsigned long long>(histogram.count()), precision,
+                  histogram.percentile(50) * scale, precision, histogram.percentile(99) * scale,
+                  precision, histogram.max() * scale);
+    out += row;
+}
+}  // namespace
+
+/**
+ * @brief Returns a table of the sample count, p50, p99 and max of each stage and process in
+ * milliseconds, and of the depth of each queue in elements
+ */
+std::string LatencyRecorder::report() const {
+    const double nsToMs = 1e-6;
+    char header[160];
+    std::string out;
+
+    std::snprintf(header, sizeof(header), "%-32s %10s %10s %10s %10s\n", "Stage [ms]", "count",
+                  "p50", "p99", "max");
+    out += header;
+    for (size_t i = 0; i < m_stages.size(); i++) {
+        appendRow(out, stageName(static_cast<LatencyStage>(i)), m_stages[i], nsToMs, 3);
+        if (static_cast<LatencyStage>(i) == LatencyStage::Processing) {
+            // Break processing down into the processes of the chain
+            std::lock_guard<std::mutex> lock(m_processMutex);
+            for (size_t p = 0; p < m_processes.size(); p++) {
+                appendRow(out, "  " + std::to_string(p + 1) + ". " + m_processNames[p],
+                          *m_processes[p], nsToMs, 3);
+            }
+        }
+    }
+
+    std::snprintf(header, sizeof(header), "\n%-32s %10s %10s %10s %10s\n", "Queue depth [frames]",
+                  "count", "p50", "p99", "max");
+    out += header;
+    for (size_t i = 0; i < m_queues.size(); i++) {
+        appendRow(out, queueName(static_cast<LatencyQueue>(i)), m_queues[i], 1, 0);
+    }
+    return out;
+}
+
+/**
+ * @brief Writes report() to path
+ * @return true if the file was written successfully
+ */
+bool LatencyRecorder::writeReport(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        return false;
+    }
+    out << report();
+    out.close();
+    return !out.fail();
+}
@@ -0,0 +1,127 @@
+#ifndef RTOC_LATENCYRECORDER_H
+#define RTOC_LATENCYRECORDER_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * @brief The LatencyHistogram class
+ * @details Lock-free histogram of non-negative integer samples with bounded relative error, in the
+ * style of HdrHistogram. Values below 16 are counted exactly. Larger values are counted in 16
+ * linear sub-buckets per power of two, such that a reported percentile is never more than 1/16th
+ * (6.25%) above the recorded value.
+ *
+ * record() may be called concurrently from any number of threads. Readers may query the histogram
+ * while it is being recorded to, in which case the result reflects some recent state.
+ */
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    void record(uint64_t value);
+    void reset();
+
+    uint64_t count() const;
+    uint64_t max() const { return m_max.load(std::memory_order_relaxed); }
+    double mean() const;
+    uint64_t percentile(double p) const;
+
+private:
+    static const int s_subBucketBits = 4;
+    static const int s_subBuckets = 1 << s_subBucketBits;
+    static const int s_bucketCount = (64 - s_subBucketBits + 1) * s_subBuckets;
+
+    static int bucketIndex(uint64_t value);
+    static uint64_t bucketUpperValue(int index);
+
+    std::array<std::atomic<uint64_t>, s_bucketCount> m_counts;
+    std::atomic<uint64_t> m_total{0};
+    std::atomic<uint64_t> m_sum{0};
+    std::atomic<uint64_t> m_max{0};
+};
+
+// Pipeline stages timed for each frame. The order is the order of the latency report
+enum class LatencyStage {
+    Acquire,         // retrieving an image from the acquisition source
+    Processing,      // all processes of the process chain
+    AnalysisQueue,   // waiting in the analysis queue for the object finder
+    ObjectFinding,   // region properties and tracking
+    Classification,  // early decisions and classification of closed tracks
+    Write,           // writing a single image to disk
+    EndToEnd,        // from acquisition until the object finder is done with the frame
+    Count
+};
+
+// Queues for which the depth is sampled each time an element is enqueued
+enum class LatencyQueue { Analysis, Storage, Count };
+
+/**
+ * @brief The LatencyRecorder class
+ * @details Collects a LatencyHistogram of durations for each LatencyStage and for each process of
+ * the process chain, and a histogram of the depth of each LatencyQueue. Durations are recorded in
+ * nanoseconds from a monotonic clock.
+ *
+ * Recording is lock-free. setProcessNames() and reset() must not be called while recording, but
+ * may be called while another thread creates a report.
+ */
+class LatencyRecorder {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    LatencyRecorder();
+
+    static Clock::time_point now() { return Clock::now(); }
+    static uint64_t toNs(Clock::duration duration) {
+        const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+        return ns > 0 ? static_cast<uint64_t>(ns) : 0;
+    }
+
+    void setProcessNames(const std::vector<std::string>& names);
+    void reset();
+
+    void record(LatencyStage stage, Clock::duration duration) {
+        stageHistogram(stage).record(toNs(duration));
+    }
+    void recordProcess(size_t index, Clock::duration duration) {
+        if (index < m_processes.size()) {
+            m_processes[index]->record(toNs(duration));
+        }
+    }
+    void recordQueueDepth(LatencyQueue queue, size_t depth) { queueHistogram(queue).record(depth); }
+
+    LatencyHistogram& stageHistogram(LatencyStage stage) {
+        return m_stages[static_cast<size_t>(stage)];
+    }
+    const LatencyHistogram& stageHistogram(LatencyStage stage) const {
+        return m_stages[static_cast<size_t>(stage)];
+    }
+    LatencyHistogram& queueHistogram(LatencyQueue queue) {
+        return m_queues[static_cast<size_t>(queue)];
+    }
+    const LatencyHistogram& queueHistogram(LatencyQueue queue) const {
+        return m_queues[static_cast<size_t>(queue)];
+    }
+
+    std::string report() const;
+    bool writeReport(const std::string& path) const;
+
+    static const char* stageName(LatencyStage stage);
+    static const char* queueName(LatencyQueue queue);
+
+private:
+    std::array<LatencyHistogram, static_cast<size_t>(LatencyStage::Count)> m_stages;
+    std::array<LatencyHistogram, static_cast<size_t>(LatencyQueue::Count)> m_queues;
+
+    // Histograms are not movable, and are thus held by pointer
+    std::vector<std::unique_ptr<LatencyHistogram>> m_processes;
+    std::vector<std::string> m_processNames;
+    mutable std::mutex m_processMutex;  // guards resizing of m_processes against report()
+};
+
+#endif  // RTOC_LATENCYRECORDER_H
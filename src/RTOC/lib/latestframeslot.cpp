@@ -0,0 +1,73 @@
+#include "latestframeslot.h"
+
+#include <algorithm>
+
+/**
+ * @brief Called by the producer for every frame. The frame is copied into the slot if the consumer
+ * has asked for a frame, and skipped otherwise
+ * @return true if the frame was published
+ */
+bool LatestFrameSlot::publish(const cv::Mat& frame) {
+    if (!(m_shared.load(std::memory_order_relaxed) & requestedBit)) {
+        return false;
+    }
+    // Reuses the allocation of the buffer for frames of the same size
+    frame.copyTo(m_buffers[m_producer]);
+    // Clears the request, such that a single frame is copied for each request
+    const unsigned int previous =
+        m_shared.exchange(m_producer | freshBit, std::memory_order_acq_rel);
+    m_producer = previous & indexMask;
+    m_published.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+/**
+ * @brief Called by the consumer to take the latest published frame, and to ask for the next
+ * @param frame : refers to the buffer of the consumer, and is valid until the next call to take()
+ * @return false if no frame was published since the last call
+ */
+bool LatestFrameSlot::take(cv::Mat& frame) {
+    unsigned int previous = m_shared.load(std::memory_order_acquire);
+    do {
+        if (!(previous & freshBit)) {
+            m_shared.fetch_or(requestedBit, std::memory_order_release);
+            return false;
+        }
+        // The swap fails if the frame was discarded by reset() in the meantime
+    } while (!m_shared.compare_exchange_weak(previous, m_consumer | requestedBit,
+                                             std::memory_order_acq_rel,
+                                             std::memory_order_acquire));
+    m_consumer = previous & indexMask;
+    frame = m_buffers[m_consumer];
+    return true;
+}
+
+/**
+ * @brief Discards the published frame, eg. when a new acquisition is started. Called by the
+ * producer, while the consumer may be active
+ */
+void LatestFrameSlot::reset() {
+    m_shared.fetch_and(~freshBit, std::memory_order_acq_rel);
+    m_shared.fetch_or(requestedBit, std::memory_order_release);
+    m_buffers[m_producer].release();
+    m_published = 0;
+}
+
+/**
+ * @brief Downscales an image to fit within width x height, averaging the pixels of each area. dst
+ * refers to src if it already fits
+ */
+void downscaleToFit(const cv::Mat& src, int width, int height, cv::Mat& dst) {
+    if (src.empty() || width <= 0 || height <= 0) {
+        dst = src;
+        return;
+    }
+    const double scale = std::min(double(width) / src.cols, double(height) / src.rows);
+    if (scale >= 1) {
+        dst = src;
+        return;
+    }
+    const cv::Size size(std::max(1, static_cast<int>(src.cols * scale)),
+                        std::max(1, static_cast<int>(src.rows * scale)));
+    cv::resize(src, dst, size, 0, 0, cv::INTER_AREA);
+}
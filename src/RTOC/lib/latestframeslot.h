@@ -0,0 +1,42 @@
+#ifndef RTOC_LATESTFRAMESLOT_H
+#define RTOC_LATESTFRAMESLOT_H
+
+#include <atomic>
+
+#include <opencv/cv.hpp>
+
+/**
+ * @brief The LatestFrameSlot class
+ * @details Hands the latest acquired frame from the acquisition thread to a display, without
+ * blocking acquisition. The slot is a lock-free triple buffer: the producer writes into its own
+ * buffer and swaps it with the shared buffer, from which the consumer swaps the latest frame into
+ * its own buffer.
+ *
+ * Frames are only copied when the consumer has asked for one, ie. once per take(), such that the
+ * cost to acquisition is bounded by the display rate rather than the acquisition rate. A single
+ * producer and a single consumer thread are assumed.
+ */
+class LatestFrameSlot {
+public:
+    bool publish(const cv::Mat& frame);
+    bool take(cv::Mat& frame);
+    void reset();
+
+    long publishedFrames() const { return m_published; }
+
+private:
+    static constexpr unsigned int indexMask = 0x3;
+    static constexpr unsigned int freshBit = 0x4;      // the shared buffer holds an untaken frame
+    static constexpr unsigned int requestedBit = 0x8;  // the consumer asks for a frame
+
+    cv::Mat m_buffers[3];
+    // Index of the shared buffer, and the fresh and requested flags
+    std::atomic<unsigned int> m_shared{1 | requestedBit};
+    unsigned int m_producer = 0;  // owned by the producer
+    unsigned int m_consumer = 2;  // owned by the consumer
+    std::atomic<long> m_published{0};
+};
+
+void downscaleToFit(const cv::Mat& src, int width, int height, cv::Mat& dst);
+
+#endif  // RTOC_LATESTFRAMESLOT_H
@@ -1,10 +1,20 @@
 #include "machinelearning.h"
 
+#include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <fstream>
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <queue>
+#include <stdexcept>
 #include <string>
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
 std::unique_ptr<Machinelearning> identifyModel(const std::string& path) {
     std::string line;
     std::ifstream file(path);
@@ -12,6 +22,12 @@ std::unique_ptr<Machinelearning> identifyModel(const std::string& path) {
         if (line == "LR") {
             return std::make_unique<LogisticRegression>();
         }
+        if (line == "RF" || line == "GBT") {
+            return std::make_unique<TreeEnsemble>();
+        }
+        if (line == "ANN") {
+            return std::make_unique<ArtificialNeuralNetwork>();
+        }
     }
     return nullptr;
 }
@@ -36,12 +52,52 @@ int Machinelearning::predictObject(DataContainer& dataContainer) {
     return 0;
 }
 
+/**
+ * @brief Classifies a batch of tracks, eg. all tracks closed in a frame
+ * @return predicted label of each track
+ */
+std::vector<int> Machinelearning::predictObjects(
+    const std::vector<DataContainer*>& dataContainers) {
+    std::vector<int> labels;
+    labels.reserve(dataContainers.size());
+    results.reserve(results.size() + dataContainers.size());
+    for (DataContainer* dataContainer : dataContainers) {
+        labels.push_back(predictObject(*dataContainer));
+    }
+    return labels;
+}
+
+/**
+ * @brief Updates the classification of a track which is still being observed. Models without
+ * support for early decisions never commit, and are evaluated once the track has closed
+ * @return committed label, or -1 while undecided
+ */
+int Machinelearning::updateObject(DataContainer& dataContainer, StreamingState& state,
+                                  double margin) {
+    return state.label;
+}
+
+/**
+ * @brief Removes the most recent result of an object, eg. when a committed early decision is
+ * withdrawn because the object was rejected
+ */
+void Machinelearning::withdrawResult(const DataContainer& dataContainer) {
+    const int label = dataContainer.front()->getValue<int>(data::Label);
+    for (auto it = results.rbegin(); it != results.rend(); ++it) {
+        if (it->label == label) {
+            results.erase(std::next(it).base());
+            return;
+        }
+    }
+}
+
 int Machinelearning::get_XBoundary() const {
     return _XBoundary;
 }
 
 void Machinelearning::set_XBoundary(int m_XBoundary) {
     Machinelearning::_XBoundary = m_XBoundary;
+    resampler.setXBoundary(m_XBoundary);
 }
 
 void Machinelearning::outputToFile(const std::string& path) {
@@ -52,69 +108,287 @@ void Machinelearning::outputToFile(const std::string& path) {
     out.close();
 }
 
-int Machinelearning::findClosestXpos(const int& pos, DataContainer& dataContainer) {
-    for (int i = 0; i < _XBoundary; i++) {
-        int index = 0;
-        for (const auto& object : dataContainer) {
-            auto rel_xpos = object->getValue<double>(data::RelativeXpos);
-            if ((rel_xpos > (pos - i)) && (rel_xpos < (pos + i))) {
-                return index;
-            }
-            index++;
-        }
-    }
-    return -1;
-}
-
-double
-Machinelearning::interpolation_inverseDistance(const int& pos, DataContainer& dataContainer,
-                                               data::DataFlags& attribute) {  // Shepards method
-    double numerator = 0;
-    double denominator = 0;
-    for (const auto& item : dataContainer) {
-        numerator += (item->getValue<double>(attribute) * 1 /
-                      pow((0.01 + abs(pos - item->getValue<double>(data::RelativeXpos))), 2));
-        denominator += 1 / pow((0.01 + abs(pos - item->getValue<double>(data::RelativeXpos))), 2);
-    }
-    return (numerator / denominator);  // Returns interpolated value
-}
-
-double Machinelearning::interpolation_average(const int& pos, DataContainer& dataContainer,
-                                              data::DataFlags attribute) {
-    int lowIndex = 0;
-    int lowDistance = 0;
-    int highIndex = 0;
-    int highDistance = 0;
-    // First we look for a centroid below the given x-position
-    for (int i = 0; i < _XBoundary; i++) {
-        int index = 0;
-        for (const auto& object : dataContainer) {
-            auto rel_xpos = object->getValue<double>(data::RelativeXpos);
-            if ((rel_xpos > (pos - i)) && (rel_xpos < (pos))) {
-                lowIndex = index;
-                lowDistance = i;
-            }
-            index++;
+namespace {
+/**
+ * @brief Shepard weights w[i] = 1 / (0.01 + |pos - x[i]|)^2
+ * @return sum of the weights
+ */
+double inverseDistanceWeights(const double* x, size_t n, double pos, double* w) {
+    size_t i = 0;
+    double sum = 0;
+#ifdef __SSE2__
+    const __m128d vpos = _mm_set1_pd(pos);
+    const __m128d offset = _mm_set1_pd(0.01);
+    const __m128d one = _mm_set1_pd(1.0);
+    const __m128d signBit = _mm_set1_pd(-0.0);
+    __m128d vsum = _mm_setzero_pd();
+    for (; i + 2 <= n; i += 2) {
+        __m128d d = _mm_andnot_pd(signBit, _mm_sub_pd(vpos, _mm_loadu_pd(x + i)));
+        d = _mm_add_pd(d, offset);
+        const __m128d vw = _mm_div_pd(one, _mm_mul_pd(d, d));
+        _mm_storeu_pd(w + i, vw);
+        vsum = _mm_add_pd(vsum, vw);
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, vsum);
+    sum = lanes[0] + lanes[1];
+#endif
+    for (; i < n; i++) {
+        const double d = 0.01 + std::fabs(pos - x[i]);
+        w[i] = 1 / (d * d);
+        sum += w[i];
+    }
+    return sum;
+}
+
+double dot(const double* a, const double* b, size_t n) {
+    size_t i = 0;
+    double sum = 0;
+#ifdef __SSE2__
+    __m128d vsum = _mm_setzero_pd();
+    for (; i + 2 <= n; i += 2) {
+        vsum = _mm_add_pd(vsum, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, vsum);
+    sum = lanes[0] + lanes[1];
+#endif
+    for (; i < n; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+std::string attributeName(data::DataFlags flag) {
+    for (const auto& item : data::guiMap) {
+        if (std::get<1>(item.first) == flag) {
+            return item.second;
         }
     }
-    for (int j = 0; j < _XBoundary; j++) {
-        int index = 0;
-        for (const auto& object : dataContainer) {
-            auto rel_xpos = object->getValue<double>(data::RelativeXpos);
-            if ((rel_xpos > (pos)) && (rel_xpos < (pos + j))) {
-                highIndex = index;
-                highDistance = j;
+    return std::to_string(flag);
+}
+
+}  // namespace
+
+// --------------------- TrackResampler ---------------------
+/**
+ * @brief Sets the grid positions and the attributes resampled at each position. Attributes are
+ * copied as doubles, so other attributes (eg. Frame or Centroid) are rejected
+ */
+void TrackResampler::setGrid(const std::vector<int>& positions,
+                             const std::vector<data::DataFlags>& columns) {
+    unsigned long requiredFlags = data::RelativeXpos;
+    for (const auto& column : columns) {
+        const auto type = data::typeMap.find(column);
+        if (type == data::typeMap.end() || type->second.first != 1 ||
+            type->second.second != sizeof(double)) {
+            throw std::runtime_error("model attribute is not a scalar value: " +
+                                     attributeName(column));
+        }
+        requiredFlags |= column;
+    }
+    m_positions = positions;
+    m_columns = columns;
+    m_requiredFlags = requiredFlags;
+}
+
+void TrackResampler::checkFlags(DataContainer& dataContainer) const {
+    if ((dataContainer.getDataFlags() & m_requiredFlags) != m_requiredFlags) {
+        throw std::runtime_error("attribute of the model is not extracted for the object");
+    }
+}
+
+/**
+ * @brief Copies the relative x-positions and the grid attributes of all objects of dataContainer
+ * into contiguous columns, sorted by relative x-position
+ */
+void TrackResampler::sortTrack(DataContainer& dataContainer) {
+    const size_t n = dataContainer.size();
+    m_track.order.resize(n);
+    m_track.xpos.resize(n);
+    m_track.values.resize(m_columns.size());
+    for (auto& column : m_track.values) {
+        column.resize(n);
+    }
+    if (n == 0) {
+        return;
+    }
+    checkFlags(dataContainer);
+
+    // All objects of a container share the same memory layout and flags
+    const size_t xposOffset = dataContainer.front()->offsetOf(data::RelativeXpos);
+    std::vector<size_t> offsets;
+    for (const auto& column : m_columns) {
+        offsets.push_back(dataContainer.front()->offsetOf(column));
+    }
+    std::vector<size_t>& order = m_track.order;
+    std::vector<double>& xpos = m_track.xpos;
+    for (size_t k = 0; k < n; k++) {
+        order[k] = k;
+        std::memcpy(&xpos[k], dataContainer[k]->raw() + xposOffset, sizeof(double));
+    }
+    // Objects travel through the channel, so tracks are usually sorted already
+    if (!std::is_sorted(xpos.begin(), xpos.end())) {
+        std::stable_sort(order.begin(), order.end(),
+                         [&](size_t a, size_t b) { return xpos[a] < xpos[b]; });
+        for (size_t k = 0; k < n; k++) {
+            std::memcpy(&xpos[k], dataContainer[order[k]]->raw() + xposOffset, sizeof(double));
+        }
+    }
+    for (size_t k = 0; k < n; k++) {
+        const char* object = dataContainer[order[k]]->raw();
+        for (size_t c = 0; c < offsets.size(); c++) {
+            std::memcpy(&m_track.values[c][k], object + offsets[c], sizeof(double));
+        }
+    }
+}
+
+/**
+ * @brief Inserts the objects of dataContainer which are not yet in track, ie. those appended to
+ * the container since the last call, at their sorted positions. Objects with equal x-positions
+ * keep their container order, as in sortTrack()
+ */
+void TrackResampler::appendTrack(DataContainer& dataContainer, SortedTrack& track) const {
+    const size_t n = dataContainer.size();
+    if (track.size() >= n) {
+        return;
+    }
+    checkFlags(dataContainer);
+    track.values.resize(m_columns.size());
+
+    const size_t xposOffset = dataContainer.front()->offsetOf(data::RelativeXpos);
+    std::vector<size_t> offsets;
+    for (const auto& column : m_columns) {
+        offsets.push_back(dataContainer.front()->offsetOf(column));
+    }
+    for (size_t k = track.size(); k < n; k++) {
+        const char* object = dataContainer[k]->raw();
+        double x;
+        std::memcpy(&x, object + xposOffset, sizeof(double));
+        // Objects travel through the channel, so this is usually the end of the track
+        const size_t at = std::upper_bound(track.xpos.begin(), track.xpos.end(), x) -
+                          track.xpos.begin();
+        track.order.insert(track.order.begin() + at, k);
+        track.xpos.insert(track.xpos.begin() + at, x);
+        for (size_t c = 0; c < offsets.size(); c++) {
+            double value;
+            std::memcpy(&value, object + offsets[c], sizeof(double));
+            track.values[c].insert(track.values[c].begin() + at, value);
+        }
+    }
+}
+
+/**
+ * @brief Resamples dataContainer onto the grid
+ * @return grid values, position major. Positions without any observation within the x-boundary
+ * are 0 for the closest-point and average interpolations
+ */
+const std::vector<double>& TrackResampler::resample(DataContainer& dataContainer) {
+    return resample(dataContainer, 0, m_positions.size());
+}
+
+/**
+ * @brief Resamples dataContainer onto grid positions [begin, end) only. Other positions are 0
+ */
+const std::vector<double>& TrackResampler::resample(DataContainer& dataContainer, size_t begin,
+                                                    size_t end) {
+    sortTrack(dataContainer);
+    return resampleSorted(m_track, begin, end);
+}
+
+/**
+ * @brief Resamples a track which is still being observed onto grid positions [begin, end) only.
+ * track holds the observations of previous calls, to which only the new observations of
+ * dataContainer are added
+ */
+const std::vector<double>& TrackResampler::resample(DataContainer& dataContainer,
+                                                    SortedTrack& track, size_t begin,
+                                                    size_t end) {
+    appendTrack(dataContainer, track);
+    return resampleSorted(track, begin, end);
+}
+
+const std::vector<double>& TrackResampler::resampleSorted(const SortedTrack& track, size_t begin,
+                                                          size_t end) {
+    const std::vector<size_t>& order = track.order;
+    const std::vector<double>& xpos = track.xpos;
+    const size_t n = xpos.size();
+    const size_t nColumns = m_columns.size();
+    m_grid.assign(m_positions.size() * nColumns, 0.0);
+    if (n == 0) {
+        return m_grid;
+    }
+    m_weights.resize(n);
+
+    for (size_t p = begin; p < std::min(end, m_positions.size()); p++) {
+        const double pos = m_positions[p];
+        double* grid = &m_grid[p * nColumns];
+        switch (m_interpolation) {
+            case Interpolation::InverseDistance: {
+                const double weightSum =
+                    inverseDistanceWeights(xpos.data(), n, pos, m_weights.data());
+                for (size_t c = 0; c < nColumns; c++) {
+                    grid[c] = dot(m_weights.data(), track.values[c].data(), n) / weightSum;
+                }
+                break;
+            }
+            case Interpolation::ClosestDataPoint: {
+                // The observation within the smallest integer window around pos, and among those
+                // the first one of the track
+                const auto upper = std::lower_bound(xpos.begin(), xpos.end(), pos);
+                double distance = std::numeric_limits<double>::infinity();
+                if (upper != xpos.end()) {
+                    distance = *upper - pos;
+                }
+                if (upper != xpos.begin()) {
+                    distance = std::min(distance, pos - *(upper - 1));
+                }
+                const double window = std::floor(distance) + 1;
+                if (window >= m_XBoundary) {
+                    break;
+                }
+                const size_t begin =
+                    std::upper_bound(xpos.begin(), xpos.end(), pos - window) - xpos.begin();
+                const size_t end =
+                    std::lower_bound(xpos.begin(), xpos.end(), pos + window) - xpos.begin();
+                size_t closest = begin;
+                for (size_t k = begin + 1; k < end; k++) {
+                    if (order[k] < order[closest]) {
+                        closest = k;
+                    }
+                }
+                for (size_t c = 0; c < nColumns; c++) {
+                    grid[c] = track.values[c][closest];
+                }
+                break;
+            }
+            case Interpolation::AverageOfClosest: {
+                // Linear interpolation between the closest observations on either side of pos
+                const size_t upper =
+                    std::lower_bound(xpos.begin(), xpos.end(), pos) - xpos.begin();
+                const bool hasUpper = upper < n && xpos[upper] - pos < m_XBoundary;
+                const bool hasLower = upper > 0 && pos - xpos[upper - 1] < m_XBoundary;
+                for (size_t c = 0; c < nColumns; c++) {
+                    const double* values = track.values[c].data();
+                    if (hasUpper && (xpos[upper] == pos || !hasLower)) {
+                        grid[c] = values[upper];
+                    } else if (hasLower && !hasUpper) {
+                        grid[c] = values[upper - 1];
+                    } else if (hasLower && hasUpper) {
+                        const double span = xpos[upper] - xpos[upper - 1];
+                        grid[c] = (values[upper - 1] * (xpos[upper] - pos) +
+                                   values[upper] * (pos - xpos[upper - 1])) /
+                                  span;
+                    }
+                }
+                break;
             }
-            index++;
         }
     }
-    int sumDistance = lowDistance + highDistance;
-    return ((((sumDistance - lowDistance) / (sumDistance)) *
-             dataContainer[lowIndex]->getValue<double>(attribute)) +
-            (((sumDistance - highDistance) / (sumDistance)) *
-             dataContainer[highIndex]->getValue<double>(attribute)));
+    return m_grid;
 }
 
+// ------------------- LogisticRegression -------------------
 LogisticRegression::LogisticRegression() {
     // These values should be set some other place,
     // would be "nice to have" in the GUI
@@ -147,36 +421,98 @@ void LogisticRegression::loadModel(const std::string& path) {
         }
         counter += 1;
     }
+    compile();
 }
 
-int LogisticRegression::predictObject(DataContainer& dataContainer) {
-    // customParameter defines the decision boundary between the binary classification.
-    // By default this should be set to 0.5.
+/**
+ * @brief Sets the interpolation style by its GUI name. Unknown names select inverse distance
+ * weighting
+ */
+void LogisticRegression::setInterpolation_style(std::string style) {
+    interpolation_style = style;
+    if (style == "Closest data point") {
+        resampler.setInterpolation(TrackResampler::Interpolation::ClosestDataPoint);
+    } else if (style == "Average of closest data points") {
+        resampler.setInterpolation(TrackResampler::Interpolation::AverageOfClosest);
+    } else {
+        resampler.setInterpolation(TrackResampler::Interpolation::InverseDistance);
+    }
+}
 
-    double possibility = 0;
-    for (int i = 0; i < relativeXpos.size(); i++) {
-        if (interpolation_style == "Closest data point") {
-            // First, find the object with the given x-position
-            int index = findClosestXpos(relativeXpos[i], dataContainer);
+/**
+ * @brief Groups the loaded terms by relative x-position and attribute, and sets up the resampler
+ * grid accordingly
+ */
+void LogisticRegression::compile() {
+    const size_t terms =
+        std::min(relativeXpos.size(), std::min(attributes.size(), coefficients.size()));
+    relativeXpos.resize(terms);
+    attributes.resize(terms);
+    const std::vector<int32_t> gridIndex = compileFeatures();
 
-            // Next, extract the right attribute and multiply its coefficient onto the model
-            // Make arguement change with attribute-type
-            auto attributeValue = dataContainer[index]->getValue<double>(attributes[i]);
-            possibility += (attributeValue * coefficients[i]);
+    m_termWeights.assign(resampler.positions().size() * resampler.columns().size(), 0.0);
+    for (size_t i = 0; i < terms; i++) {
+        m_termWeights[gridIndex[i]] += coefficients[i];
+    }
+}
 
-        } else if (interpolation_style == "Average of closest data points") {
-            auto attributeValue =
-                interpolation_average(relativeXpos[i], dataContainer, attributes[i]);
-            possibility += (attributeValue * coefficients[i]);
+/**
+ * @brief Computes the linear part of the model, ie. the sum of all terms
+ */
+double LogisticRegression::score(DataContainer& dataContainer) {
+    const std::vector<double>& grid = resampler.resample(dataContainer);
+    return dot(m_termWeights.data(), grid.data(), grid.size());
+}
 
-        } else if (interpolation_style == "Inverse distance weighting") {
-            auto attributeValue =
-                interpolation_inverseDistance(relativeXpos[i], dataContainer, attributes[i]);
-            possibility += (attributeValue * coefficients[i]);
-        }
+/**
+ * @brief Adds the terms of all grid positions which the track has passed since the last update to
+ * the provisional score. The label is committed once the provisional probability is at least
+ * margin from the decision boundary, or once all positions have been passed.
+ *
+ * Closest-point and average interpolations only depend on observations up to the first
+ * observation past a position, so their terms are final once passed. Inverse distance weighting
+ * terms are approximated from the observations seen so far.
+ * @return committed label, or -1 while undecided
+ */
+int LogisticRegression::updateObject(DataContainer& dataContainer, StreamingState& state,
+                                     double margin) {
+    if (state.label >= 0 || dataContainer.size() == 0) {
+        return state.label;
+    }
+    const std::vector<int>& positions = resampler.positions();
+    const double xpos = dataContainer.back()->getValue<double>(data::RelativeXpos);
+    size_t passed = state.passedPositions;
+    while (passed < positions.size() && xpos > positions[passed]) {
+        passed++;
     }
+    if (passed == state.passedPositions) {
+        return state.label;
+    }
+
+    const size_t nColumns = resampler.columns().size();
+    const size_t first = state.passedPositions * nColumns;
+    const std::vector<double>& grid =
+        resampler.resample(dataContainer, state.track, state.passedPositions, passed);
+    state.score +=
+        dot(&m_termWeights[first], &grid[first], (passed - state.passedPositions) * nColumns);
+    state.passedPositions = passed;
+
+    const double possibility = 1 / (1 + exp(-(state.score + intercept)));
+    if (std::fabs(possibility - decisionBoundary) >= margin || passed == positions.size()) {
+        state.label = possibility >= decisionBoundary ? 1 : 0;
+        results.emplace_back(state.label, possibility,
+                             dataContainer[0]->getValue<int>(data::Label));
+        state.track = SortedTrack();
+    }
+    return state.label;
+}
+
+int LogisticRegression::predictObject(DataContainer& dataContainer) {
+    // customParameter defines the decision boundary between the binary classification.
+    // By default this should be set to 0.5.
+
     // Add intercept
-    possibility = exp(possibility + intercept);
+    double possibility = exp(score(dataContainer) + intercept);
 
     // Compute possibility
     possibility = possibility / (1 + possibility);
@@ -191,8 +527,387 @@ int LogisticRegression::predictObject(DataContainer& dataContainer) {
     }
 }
 
+// --------------------- TreeEnsemble ---------------------
+TreeEnsemble::TreeEnsemble() {}
+
+namespace {
+/**
+ * @brief Sequential reader of the comma separated tokens of a model file, ignoring surrounding
+ * whitespace
+ */
+class ModelReader {
+public:
+    explicit ModelReader(const std::string& path) {
+        std::ifstream file(path);
+        std::string token;
+        while (std::getline(file, token, ',')) {
+            const size_t begin = token.find_first_not_of(" \t\r\n");
+            if (begin != std::string::npos) {
+                const size_t end = token.find_last_not_of(" \t\r\n");
+                m_tokens.push_back(token.substr(begin, end - begin + 1));
+            }
+        }
+    }
+
+    const std::string& next() {
+        if (m_index >= m_tokens.size()) {
+            throw std::runtime_error("model file ended unexpectedly");
+        }
+        return m_tokens[m_index++];
+    }
+    int nextInt() { return std::stoi(next()); }
+    double nextDouble() { return std::stod(next()); }
+
+    /**
+     * @brief Reads a feature count followed by (relative x-position, attribute name) pairs
+     */
+    void readFeatures(std::vector<int>& positions, std::vector<data::DataFlags>& attributes) {
+        positions.clear();
+        attributes.clear();
+        const int nFeatures = nextInt();
+        for (int f = 0; f < nFeatures; f++) {
+            positions.push_back(nextInt());
+            const std::string& name = next();
+            auto item = std::find_if(data::guiMap.begin(), data::guiMap.end(),
+                                     [&](const auto& item) { return item.second == name; });
+            if (item == data::guiMap.end()) {
+                throw std::runtime_error("unknown attribute in model: " + name);
+            }
+            attributes.push_back(std::get<1>(item->first));
+        }
+    }
+
+private:
+    std::vector<std::string> m_tokens;
+    size_t m_index = 0;
+};
+}  // namespace
+
+/**
+ * @brief Sets up the resampler grid for the features given by relativeXpos and attributes
+ * @return index of each feature into the resampled grid
+ */
+std::vector<int32_t> Machinelearning::compileFeatures() {
+    std::vector<int> positions;
+    std::vector<data::DataFlags> columns;
+    for (size_t f = 0; f < relativeXpos.size(); f++) {
+        if (std::find(positions.begin(), positions.end(), relativeXpos[f]) == positions.end()) {
+            positions.push_back(relativeXpos[f]);
+        }
+        if (std::find(columns.begin(), columns.end(), attributes[f]) == columns.end()) {
+            columns.push_back(attributes[f]);
+        }
+    }
+    // Ascending positions, in the order they are passed by a track
+    std::sort(positions.begin(), positions.end());
+    std::vector<int32_t> gridIndex;
+    for (size_t f = 0; f < relativeXpos.size(); f++) {
+        const size_t p =
+            std::find(positions.begin(), positions.end(), relativeXpos[f]) - positions.begin();
+        const size_t c =
+            std::find(columns.begin(), columns.end(), attributes[f]) - columns.begin();
+        gridIndex.push_back(static_cast<int32_t>(p * columns.size() + c));
+    }
+    resampler.setGrid(positions, columns);
+    return gridIndex;
+}
+
+void TreeEnsemble::loadModel(const std::string& path) {
+    ModelReader reader(path);
+    const std::string& type = reader.next();
+    if (type != "RF" && type != "GBT") {
+        throw std::runtime_error("not a tree ensemble model");
+    }
+    m_boosted = type == "GBT";
+    m_baseScore = reader.nextDouble();
+
+    reader.readFeatures(relativeXpos, attributes);
+    const int nFeatures = static_cast<int>(relativeXpos.size());
+    const std::vector<int32_t> gridIndex = compileFeatures();
+
+    // Trees, flattened breadth first such that siblings are adjacent
+    m_nodes.clear();
+    m_roots.clear();
+    const int nTrees = reader.nextInt();
+    for (int tree = 0; tree < nTrees; tree++) {
+        struct TreeNode {
+            int feature;
+            double threshold;
+            int left;
+            int right;
+            double value;
+        };
+        std::vector<TreeNode> nodes(reader.nextInt());
+        for (auto& node : nodes) {
+            node.feature = reader.nextInt();
+            node.threshold = reader.nextDouble();
+            node.left = reader.nextInt();
+            node.right = reader.nextInt();
+            node.value = reader.nextDouble();
+        }
+        if (nodes.empty()) {
+            continue;
+        }
+
+        m_roots.push_back(static_cast<int32_t>(m_nodes.size()));
+        m_nodes.emplace_back();
+        std::queue<std::pair<int, size_t>> pending;  // <tree node, flattened index>
+        pending.emplace(0, m_nodes.size() - 1);
+        size_t visited = 0;
+        while (!pending.empty()) {
+            const TreeNode& node = nodes[pending.front().first];
+            const size_t index = pending.front().second;
+            pending.pop();
+            if (++visited > nodes.size()) {
+                throw std::runtime_error("tree ensemble model contains a cycle");
+            }
+            if (node.feature < 0) {
+                m_nodes[index] = Node{-1, 0, node.value};
+                continue;
+            }
+            if (node.feature >= nFeatures || node.left < 0 || node.right < 0 ||
+                node.left >= static_cast<int>(nodes.size()) ||
+                node.right >= static_cast<int>(nodes.size())) {
+                throw std::runtime_error("invalid node in tree ensemble model");
+            }
+            const size_t child = m_nodes.size();
+            m_nodes[index] =
+                Node{gridIndex[node.feature], static_cast<int32_t>(child), node.threshold};
+            m_nodes.emplace_back();
+            m_nodes.emplace_back();
+            pending.emplace(node.left, child);
+            pending.emplace(node.right, child + 1);
+        }
+    }
+}
+
+/**
+ * @brief Sum of the leaf values reached in all trees
+ */
+double TreeEnsemble::evaluate(const double* features) const {
+    double sum = 0;
+    const Node* nodes = m_nodes.data();
+    for (const int32_t root : m_roots) {
+        const Node* node = nodes + root;
+        while (node->feature >= 0) {
+            node = nodes + node->child + (features[node->feature] > node->threshold);
+        }
+        sum += node->threshold;
+    }
+    return sum;
+}
+
+double TreeEnsemble::probability(double sum) const {
+    if (m_boosted) {
+        return 1 / (1 + std::exp(-(m_baseScore + sum)));
+    }
+    return m_baseScore + (m_roots.empty() ? 0 : sum / m_roots.size());
+}
+
+int TreeEnsemble::classify(double possibility, DataContainer& dataContainer) {
+    const int label = possibility >= decisionBoundary ? 1 : 0;
+    results.emplace_back(label, possibility, dataContainer[0]->getValue<int>(data::Label));
+    return label;
+}
+
+int TreeEnsemble::predictObject(DataContainer& dataContainer) {
+    const std::vector<double>& features = resampler.resample(dataContainer);
+    return classify(probability(evaluate(features.data())), dataContainer);
+}
+
+/**
+ * @brief Classifies a batch of tracks. Trees are evaluated one at a time over all tracks, such that
+ * each tree stays in cache while in use
+ */
+std::vector<int> TreeEnsemble::predictObjects(const std::vector<DataContainer*>& dataContainers) {
+    std::vector<double> features;
+    size_t nFeatures = 0;
+    for (DataContainer* dataContainer : dataContainers) {
+        const std::vector<double>& grid = resampler.resample(*dataContainer);
+        nFeatures = grid.size();
+        features.insert(features.end(), grid.begin(), grid.end());
+    }
+
+    std::vector<double> sums(dataContainers.size(), 0.0);
+    const Node* nodes = m_nodes.data();
+    for (const int32_t root : m_roots) {
+        for (size_t i = 0; i < dataContainers.size(); i++) {
+            const double* trackFeatures = features.data() + i * nFeatures;
+            const Node* node = nodes + root;
+            while (node->feature >= 0) {
+                node = nodes + node->child + (trackFeatures[node->feature] > node->threshold);
+            }
+            sums[i] += node->threshold;
+        }
+    }
+
+    std::vector<int> labels;
+    labels.reserve(dataContainers.size());
+    for (size_t i = 0; i < dataContainers.size(); i++) {
+        labels.push_back(classify(probability(sums[i]), *dataContainers[i]));
+    }
+    return labels;
+}
+
+// ----------------- ArtificialNeuralNetwork -----------------
 ArtificialNeuralNetwork::ArtificialNeuralNetwork() {}
 
-DecisionTree::DecisionTree() {}
+void ArtificialNeuralNetwork::AlignedBuffer::resize(size_t size) {
+    storage.assign(size + 3, 0.0f);
+    const size_t misalignment = reinterpret_cast<uintptr_t>(storage.data()) % 16;
+    data = storage.data() + (misalignment == 0 ? 0 : (16 - misalignment) / sizeof(float));
+}
+
+namespace {
+size_t paddedLength(size_t n) {
+    return (n + 3) & ~size_t(3);
+}
+
+/**
+ * @brief Dot product of two 16-byte aligned float rows of length n, a multiple of four
+ */
+float dotAligned(const float* a, const float* b, size_t n) {
+#ifdef __SSE2__
+    __m128 sum = _mm_setzero_ps();
+    for (size_t i = 0; i < n; i += 4) {
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_load_ps(a + i), _mm_load_ps(b + i)));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, sum);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#else
+    float sum = 0;
+    for (size_t i = 0; i < n; i++) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+#endif
+}
+}  // namespace
+
+void ArtificialNeuralNetwork::loadModel(const std::string& path) {
+    ModelReader reader(path);
+    if (reader.next() != "ANN") {
+        throw std::runtime_error("not a neural network model");
+    }
+    reader.readFeatures(relativeXpos, attributes);
+    m_gridIndex = compileFeatures();
+
+    m_layers.clear();
+    std::vector<float> weights;
+    const int nLayers = reader.nextInt();
+    size_t inputs = m_gridIndex.size();
+    for (int l = 0; l < nLayers; l++) {
+        Layer layer;
+        layer.inputs = reader.nextInt();
+        layer.outputs = reader.nextInt();
+        if (layer.inputs != inputs || layer.outputs == 0) {
+            throw std::runtime_error("neural network layer sizes do not match");
+        }
+        const std::string& activation = reader.next();
+        if (activation == "linear") {
+            layer.activation = Activation::Linear;
+        } else if (activation == "relu") {
+            layer.activation = Activation::Relu;
+        } else if (activation == "sigmoid") {
+            layer.activation = Activation::Sigmoid;
+        } else if (activation == "tanh") {
+            layer.activation = Activation::Tanh;
+        } else {
+            throw std::runtime_error("unknown activation in neural network model: " + activation);
+        }
+
+        layer.stride = paddedLength(layer.inputs);
+        layer.offset = weights.size();
+        weights.resize(weights.size() + layer.outputs * layer.stride, 0.0f);
+        for (size_t o = 0; o < layer.outputs; o++) {
+            for (size_t i = 0; i < layer.inputs; i++) {
+                weights[layer.offset + o * layer.stride + i] =
+                    static_cast<float>(reader.nextDouble());
+            }
+        }
+        for (size_t o = 0; o < layer.outputs; o++) {
+            layer.biases.push_back(static_cast<float>(reader.nextDouble()));
+        }
+        inputs = layer.outputs;
+        m_layers.push_back(std::move(layer));
+    }
+    if (m_layers.empty() || m_layers.back().outputs != 1) {
+        throw std::runtime_error("neural network must end in a single output");
+    }
+
+    m_weights.resize(weights.size());
+    std::copy(weights.begin(), weights.end(), m_weights.data);
+}
+
+/**
+ * @brief Propagates the batch held in m_input through all layers. The output of the network is
+ * left in the first column of m_input
+ */
+void ArtificialNeuralNetwork::forward(size_t batch) {
+    for (size_t l = 0; l < m_layers.size(); l++) {
+        const Layer& layer = m_layers[l];
+        const size_t outStride = l + 1 < m_layers.size() ? m_layers[l + 1].stride
+                                                         : paddedLength(layer.outputs);
+        m_output.resize(batch * outStride);
+        // Output major, such that each weight row stays in cache for the whole batch
+        for (size_t o = 0; o < layer.outputs; o++) {
+            const float* row = m_weights.data + layer.offset + o * layer.stride;
+            for (size_t b = 0; b < batch; b++) {
+                float value = dotAligned(row, m_input.data + b * layer.stride, layer.stride) +
+                              layer.biases[o];
+                switch (layer.activation) {
+                    case Activation::Linear:
+                        break;
+                    case Activation::Relu:
+                        value = std::max(value, 0.0f);
+                        break;
+                    case Activation::Sigmoid:
+                        value = 1 / (1 + std::exp(-value));
+                        break;
+                    case Activation::Tanh:
+                        value = std::tanh(value);
+                        break;
+                }
+                m_output.data[b * outStride + o] = value;
+            }
+        }
+        std::swap(m_input, m_output);
+    }
+}
+
+int ArtificialNeuralNetwork::predictObject(DataContainer& dataContainer) {
+    std::vector<int> labels = predictObjects({&dataContainer});
+    return labels.empty() ? 0 : labels.front();
+}
+
+std::vector<int> ArtificialNeuralNetwork::predictObjects(
+    const std::vector<DataContainer*>& dataContainers) {
+    std::vector<int> labels;
+    if (m_layers.empty()) {
+        return labels;
+    }
+    const size_t stride = m_layers.front().stride;
+    m_input.resize(dataContainers.size() * stride);
+    for (size_t b = 0; b < dataContainers.size(); b++) {
+        const std::vector<double>& grid = resampler.resample(*dataContainers[b]);
+        for (size_t f = 0; f < m_gridIndex.size(); f++) {
+            m_input.data[b * stride + f] = static_cast<float>(grid[m_gridIndex[f]]);
+        }
+    }
+
+    forward(dataContainers.size());
+
+    const size_t outStride = paddedLength(1);
+    labels.reserve(dataContainers.size());
+    for (size_t b = 0; b < dataContainers.size(); b++) {
+        const double possibility = m_input.data[b * outStride];
+        const int label = possibility >= decisionBoundary ? 1 : 0;
+        results.emplace_back(label, possibility,
+                             (*dataContainers[b])[0]->getValue<int>(data::Label));
+        labels.push_back(label);
+    }
+    return labels;
+}
 
 NaiveBayes::NaiveBayes() {}
@@ -1,16 +1,88 @@
 #ifndef RTOC_MACHINELEARNING_H
 #define RTOC_MACHINELEARNING_H
 
+#include <cstdint>
 #include <memory>
+#include <string>
 #include <vector>
 #include "datacontainer.h"
 
+/**
+ * @brief Observations of a track sorted by relative x-position: the container index and
+ * x-position of each observation, and one column per model attribute
+ */
+struct SortedTrack {
+    std::vector<size_t> order;
+    std::vector<double> xpos;
+    std::vector<std::vector<double>> values;
+
+    size_t size() const { return xpos.size(); }
+};
+
+/**
+ * @brief The TrackResampler class
+ * @details Resamples the attributes of a track onto the grid of relative x-positions used by a
+ * model. The track is sorted by relative x-position once, after which each grid position is
+ * located through binary search, such that the cost per track is linear in the number of
+ * observations (inverse distance weighting, which weighs all observations, is linear per grid
+ * position). Tracks which are still being observed are kept sorted by the caller, and only their
+ * new observations are added on each update.
+ */
+class TrackResampler {
+public:
+    enum class Interpolation { ClosestDataPoint, AverageOfClosest, InverseDistance };
+
+    void setGrid(const std::vector<int>& positions, const std::vector<data::DataFlags>& columns);
+    void setInterpolation(Interpolation interpolation) { m_interpolation = interpolation; }
+    void setXBoundary(int boundary) { m_XBoundary = boundary; }
+
+    const std::vector<int>& positions() const { return m_positions; }
+    const std::vector<data::DataFlags>& columns() const { return m_columns; }
+
+    const std::vector<double>& resample(DataContainer& dataContainer);
+    const std::vector<double>& resample(DataContainer& dataContainer, size_t begin, size_t end);
+    const std::vector<double>& resample(DataContainer& dataContainer, SortedTrack& track,
+                                        size_t begin, size_t end);
+
+private:
+    void checkFlags(DataContainer& dataContainer) const;
+    void sortTrack(DataContainer& dataContainer);
+    void appendTrack(DataContainer& dataContainer, SortedTrack& track) const;
+    const std::vector<double>& resampleSorted(const SortedTrack& track, size_t begin, size_t end);
+
+    std::vector<int> m_positions;
+    std::vector<data::DataFlags> m_columns;
+    unsigned long m_requiredFlags = data::RelativeXpos;  // flags of the x-position and columns
+    Interpolation m_interpolation = Interpolation::InverseDistance;
+    int m_XBoundary = 250;
+
+    // Sorted copy of the track being resampled, reused between tracks
+    SortedTrack m_track;
+    std::vector<double> m_weights;
+    // Resampled values, position major
+    std::vector<double> m_grid;
+};
+
+/**
+ * @brief Incremental classification state of a track which is still being observed
+ */
+struct StreamingState {
+    size_t passedPositions = 0;  // model grid positions passed by the track so far
+    double score = 0;            // provisional model output over the passed positions
+    int label = -1;              // committed label, -1 while undecided
+    SortedTrack track;           // observations so far, released once the label is committed
+};
+
 class Machinelearning {
 public:
     Machinelearning();
+    virtual ~Machinelearning() = default;
     virtual void loadModel(const std::string& path);
 
     virtual int predictObject(DataContainer& dataContainer);
+    virtual std::vector<int> predictObjects(const std::vector<DataContainer*>& dataContainers);
+    virtual int updateObject(DataContainer& dataContainer, StreamingState& state, double margin);
+    void withdrawResult(const DataContainer& dataContainer);
 
     int get_XBoundary() const;
     void set_XBoundary(int m_XBoundary);
@@ -32,9 +104,8 @@ protected:
     std::vector<int> relativeXpos;
     std::vector<data::DataFlags> attributes;
     std::vector<outputData> results;
-    int findClosestXpos(const int& pos, DataContainer& dataContainer);
-    double interpolation_average(const int& pos, DataContainer& dataContainer, data::DataFlags attribute);
-    double interpolation_inverseDistance(const int &pos, DataContainer &dataContainer, data::DataFlags &attribute);
+    TrackResampler resampler;
+    std::vector<int32_t> compileFeatures();
 
 private:
     int _XBoundary = 250;
@@ -46,31 +117,138 @@ public:
     void loadModel(const std::string& path) override;
 
     int predictObject(DataContainer& dataContainer) override;
+    int updateObject(DataContainer& dataContainer, StreamingState& state, double margin) override;
     double getDecisionBoundary() {return decisionBoundary;};
     void setDecisionBoundary(int value) {decisionBoundary = value;};
     std::string getInterpolation_style() {return interpolation_style;};
-    void setInterpolation_style(std::string style) {interpolation_style = style;};
+    void setInterpolation_style(std::string style);
 
 private:
+    void compile();
+    double score(DataContainer& dataContainer);
+
     double decisionBoundary = 0.5;
     std::string interpolation_style = "Inverse distance weighting";
     std::vector<double> coefficients;
     double intercept;
+
+    // Summed coefficients of each (position, attribute) pair of the resampler grid, position major
+    std::vector<double> m_termWeights;
 };
 
+/**
+ * @brief The ArtificialNeuralNetwork class
+ * @details Dense multilayer perceptron binary classifier over attributes resampled at fixed
+ * relative x-positions. Text format, comma separated:
+ *
+ *      ANN,
+ *      number of features,
+ *      per feature: relative x-position, attribute name (as in data::guiMap),
+ *      number of layers,
+ *      per layer: inputs, outputs, activation (linear, relu, sigmoid or tanh),
+ *          outputs x inputs weights, row major,
+ *          outputs biases,
+ *
+ * The first layer takes the features in the listed order, and the last layer has a single output
+ * which is the probability of class 1 - typically with a sigmoid activation. Feature scaling is
+ * expected to be folded into the first layer.
+ *
+ * Weights are kept as single precision, row major matrices with rows padded to a multiple of four
+ * values and aligned to 16 bytes, such that a batch of tracks is propagated through each layer as
+ * SSE matrix-vector products.
+ */
 class ArtificialNeuralNetwork : public Machinelearning {
 public:
     ArtificialNeuralNetwork();
+    void loadModel(const std::string& path) override;
+
+    int predictObject(DataContainer& dataContainer) override;
+    std::vector<int> predictObjects(const std::vector<DataContainer*>& dataContainers) override;
+    double getDecisionBoundary() { return decisionBoundary; }
+    void setDecisionBoundary(double value) { decisionBoundary = value; }
+
+    size_t layerCount() const { return m_layers.size(); }
 
 private:
-    std::vector<int> weights;
+    enum class Activation { Linear, Relu, Sigmoid, Tanh };
+
+    struct Layer {
+        size_t inputs;
+        size_t outputs;
+        size_t stride;  // padded row length of the weights, and of the layer input
+        size_t offset;  // of the weights in m_weights
+        Activation activation;
+        std::vector<float> biases;
+    };
+
+    // Zero initialized float buffer aligned to 16 bytes
+    struct AlignedBuffer {
+        std::vector<float> storage;
+        float* data = nullptr;
+        void resize(size_t size);
+    };
+
+    void forward(size_t batch);
+
+    double decisionBoundary = 0.5;
+    std::vector<int32_t> m_gridIndex;
+    std::vector<Layer> m_layers;
+    AlignedBuffer m_weights;
+    // Layer inputs and outputs of a batch, one padded row per track
+    AlignedBuffer m_input, m_output;
 };
 
-class DecisionTree : public Machinelearning {
+/**
+ * @brief The TreeEnsemble class
+ * @details Random forest ("RF") or gradient boosted ("GBT") binary classifier over attributes
+ * resampled at fixed relative x-positions. Text format, comma separated:
+ *
+ *      RF or GBT,
+ *      base score,
+ *      number of features,
+ *      per feature: relative x-position, attribute name (as in data::guiMap),
+ *      number of trees,
+ *      per tree: number of nodes,
+ *          per node: feature index, threshold, left child, right child, leaf value,
+ *
+ * Node indices are local to their tree, node 0 being the root. Leaves have feature index -1. An
+ * object descends to the right child if its feature value is greater than the threshold.
+ * A random forest outputs base score + mean leaf value as the probability of class 1, a
+ * gradient boosted ensemble outputs the logistic function of base score + sum of leaf values.
+ *
+ * Trees are flattened into a single contiguous node array in which the children of a node are
+ * adjacent, such that a node is evaluated without branching on the comparison result.
+ */
+class TreeEnsemble : public Machinelearning {
 public:
-    DecisionTree();
+    TreeEnsemble();
+    void loadModel(const std::string& path) override;
+
+    int predictObject(DataContainer& dataContainer) override;
+    std::vector<int> predictObjects(const std::vector<DataContainer*>& dataContainers) override;
+    double getDecisionBoundary() { return decisionBoundary; }
+    void setDecisionBoundary(double value) { decisionBoundary = value; }
+
+    size_t treeCount() const { return m_roots.size(); }
 
 private:
+    // 16 bytes, such that four nodes share a cache line. Leaves have feature -1 and hold their
+    // value in threshold
+    struct Node {
+        int32_t feature;  // index into the resampler grid
+        int32_t child;    // index of the left child, the right child follows it
+        double threshold;
+    };
+
+    double evaluate(const double* features) const;
+    double probability(double sum) const;
+    int classify(double possibility, DataContainer& dataContainer);
+
+    bool m_boosted = false;
+    double m_baseScore = 0;
+    double decisionBoundary = 0.5;
+    std::vector<Node> m_nodes;
+    std::vector<int32_t> m_roots;
 };
 
 class NaiveBayes : public Machinelearning {
@@ -257,4 +257,25 @@ double relativeX(cv::Point &point, mathlab::Line &line) {
     }
 }
 
+/**
+ * @brief Calculates the inlet and outlet lines of the channel from the inlet and outlet set in the
+ * Setup. Objects flow in the direction in which relativeX() increases
+ */
+void inletOutletLines(const std::pair<int, int>& inlet, const std::pair<int, int>& outlet,
+                      Line& inletLine, Line& outletLine) {
+    if (inlet.second - outlet.second == 0) {
+        inletLine.straight = true;
+        inletLine.x = inlet.first;
+        outletLine.straight = true;
+        outletLine.x = inlet.second;
+    } else {
+        inletLine.straight = false;
+        outletLine.straight = false;
+        inletLine.m = -((double) (inlet.first - outlet.first) / (inlet.second - outlet.second));
+        inletLine.q = (-inletLine.m) * inlet.first + inlet.second;
+        outletLine.m = inletLine.m;
+        outletLine.q = (-outletLine.m) * outlet.first + outlet.second;
+    }
+}
+
 }  // namespace mathlab
\ No newline at end of file
@@ -7,6 +7,7 @@
 #include <math.h>
 #include <algorithm>
 #include <iostream>
+#include <utility>
 
 #include "datacontainer.h"
 
@@ -55,6 +56,8 @@ void floodFill(cv::Mat& img, const cv::Point& p);
 
 double dist(const cv::Point& p0, const cv::Point& p1);
 double relativeX(cv::Point &point, mathlab::Line &line);
+void inletOutletLines(const std::pair<int, int>& inlet, const std::pair<int, int>& outlet,
+                      Line& inletLine, Line& outletLine);
 
 template <typename T>
 std::pair<T, unsigned long> min(const std::vector<T>& v) {
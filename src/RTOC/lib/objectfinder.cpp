@@ -38,11 +38,39 @@ ObjectFinder::ObjectFinder(Experiment* experiment, Setup* setup)
  * @return Count of found objects
  */
 int ObjectFinder::findObjects() {
+    const auto findStart = LatencyRecorder::now();
+    m_numObjects = mathlab::regionProps(m_processedImg, mathlab::WithoutPixelIdxList, m_cc);
+    return trackObjects(m_cc, findStart);
+}
+
+/**
+ * @brief Finds objects in a frame of which the connected components have already been computed,
+ * eg. when the components of a processed image are shared by several object finders
+ * @param raw : raw image
+ * @param processed : processed image
+ * @param components : connected components of processed, as found by mathlab::regionProps
+ * @return Count of found objects
+ */
+int ObjectFinder::findObjects(const cv::Mat& raw, const cv::Mat& processed,
+                              DataContainer& components) {
+    m_rawImg = raw;
+    m_processedImg = processed;
+    m_numObjects = static_cast<int>(components.size());
+    return trackObjects(components, LatencyRecorder::now());
+}
+
+/**
+ * @brief Matches the m_numObjects first entries of components to the objects of the previous
+ * frame, and classifies the tracks which were closed
+ * @return Count of found objects
+ */
+int ObjectFinder::trackObjects(DataContainer& components,
+                               LatencyRecorder::Clock::time_point findStart) {
     if (m_dataFlags != m_setup->dataFlags) {
         m_dataFlags = m_setup->dataFlags;
     }
 
-    m_numObjects = mathlab::regionProps(m_processedImg, mathlab::WithoutPixelIdxList, m_cc);
+    LatencyRecorder& latency = m_experiment->latency;
 
     Tracker term(m_frameNum - 1);
     m_frameTracker = mathlab::find<Tracker>(m_trackerList, term);
@@ -56,7 +84,7 @@ int ObjectFinder::findObjects() {
                 m_newObject = true;
             } else {
                 // Find relative xpos and nearest object from previous frame
-                m_centroid = m_cc[i]->getValue<cv::Point>(data::Centroid);
+                m_centroid = components[i]->getValue<cv::Point>(data::Centroid);
                 m_xpos = mathlab::relativeX(m_centroid, m_experiment->inlet_line);
                 auto res = findNearestObject(m_centroid, m_frameTracker);
                 m_dist = res.first;
@@ -71,21 +99,47 @@ int ObjectFinder::findObjects() {
             }
         }
 
-        writeToDataVector(i, *m_experiment);
+        writeToDataVector(i, components, *m_experiment);
     }
 
+    const auto findEnd = LatencyRecorder::now();
+    latency.record(LatencyStage::ObjectFinding, findEnd - findStart);
+    m_experiment->trace.span("Object finding", m_frameIndex, findStart, findEnd);
+
     // Classify objects
     if (m_setup->classifyObjects) {
-        // Go thru objects not found in this frame
+        if (m_setup->earlyDecisionMargin > 0) {
+            updateEarlyDecisions();
+        }
+
+        // Go thru objects not found in this frame, and classify them as a batch. Tracks with an
+        // early decision keep their committed label, unless they are rejected now that they have
+        // closed
+        std::vector<DataContainer*> closedTracks;
         for (Tracker& t : m_frameTracker) {
             if (!t.found) {
-                if (!handler->invoke_all(m_experiment->data[t.cell_no].get())) {
-                    int type = ml_model->predictObject(*m_experiment->data[t.cell_no].get());
-                    m_experiment->data[t.cell_no]->front()->setValue(data::OutputValue, (double) type);
-                    //std::cout << "Cell classified as: " << type << "\n";
+                const bool rejected = handler->invoke_all(m_experiment->data[t.cell_no].get());
+                if (hasEarlyDecision(t.cell_no)) {
+                    if (rejected) {
+                        withdrawEarlyDecision(t.cell_no);
+                    }
+                } else if (!rejected) {
+                    closedTracks.push_back(m_experiment->data[t.cell_no].get());
                 }
             }
         }
+        std::vector<int> types = ml_model->predictObjects(closedTracks);
+        for (size_t i = 0; i < closedTracks.size(); i++) {
+            closedTracks[i]->front()->setValue(data::OutputValue, (double) types[i]);
+        }
+        const auto classifyEnd = LatencyRecorder::now();
+        latency.record(LatencyStage::Classification, classifyEnd - findEnd);
+        m_experiment->trace.span("Classification", m_frameIndex, findEnd, classifyEnd);
+    }
+
+    if (m_experiment->trackExporter.isOpen()) {
+        TraceSpan span(m_experiment->trace, "Stream closed tracks", m_frameIndex);
+        streamClosedTracks();
     }
 
     m_frameNum++;
@@ -109,24 +163,28 @@ void ObjectFinder::waitForThreadToFinish(int targetImageCount) {
  *
  */
 void ObjectFinder::findObjectsThreaded() {
-    auto waitTime = std::chrono::microseconds(1);
-    bool pImg_ready;
-    bool rImg_ready;
+    auto waitTime = std::chrono::milliseconds(1);
+    AnalysisFrame frame;
+    m_experiment->trace.setThreadName("Object finder");
 
+    // Frames dropped by the analysis queue policy will never arrive, and are counted as handled
     while (!(m_targetImageCount >= 0 &&
-             m_targetImageCount <= m_experiment->m_currentProcessingFrame)) {
+             m_targetImageCount <=
+                 m_experiment->m_currentProcessingFrame + m_experiment->frames.droppedCount())) {
         if (m_forceStop) {
             goto asyncStop;
         }
-        pImg_ready = m_experiment->processed.peek() != nullptr;
-        rImg_ready = m_experiment->raw.peek() != nullptr;
 
-        if (pImg_ready && rImg_ready) {
-            // Images are ready, blocking-wait for load
-            m_experiment->processed.wait_dequeue(m_processedImg);
-            m_experiment->raw.wait_dequeue(m_rawImg);
+        if (m_experiment->frames.wait_dequeue_timed(frame, waitTime)) {
+            m_processedImg = frame.processed;
+            m_rawImg = frame.raw;
 
             // Extract data if set
+            LatencyRecorder& latency = m_experiment->latency;
+            const auto dequeued = LatencyRecorder::now();
+            latency.record(LatencyStage::AnalysisQueue, dequeued - frame.enqueued);
+            m_experiment->trace.wait("Analysis queue", frame.index, frame.enqueued, dequeued);
+            m_frameIndex = frame.index;
             if (m_setup->extractData) {
                 findObjects();
             }
@@ -138,6 +196,7 @@ void ObjectFinder::findObjectsThreaded() {
             if (m_setup->storeRaw) {
                 m_experiment->writeBuffer_raw.push(m_rawImg);
             }
+            latency.record(LatencyStage::EndToEnd, LatencyRecorder::now() - frame.acquired);
             m_experiment->m_currentProcessingFrame++;
         } else {
             // A set of raw and processed images are not yet ready, so we wait
@@ -184,15 +243,117 @@ unsigned long ObjectFinder::cleanObjects() {
 
     unsigned long length = data->size();  // Get initial count of objects
 
-    // Use erase, remove-if
-    data->erase(
-        std::remove_if(data->begin(), data->end(),
-                       [&](const auto& dc) -> bool { return handler->invoke_all(dc.get()); }),
-        data->end());
+    // Tracks which were still open hold early decisions which must be withdrawn if rejected
+    for (size_t i = 0; i < m_streamingStates.size(); i++) {
+        if ((*data)[i] && hasEarlyDecision(i) && handler->invoke_all((*data)[i].get())) {
+            withdrawEarlyDecision(i);
+        }
+    }
+
+    // Use erase, remove-if. Tracks released by streaming export are removed as well
+    data->erase(std::remove_if(data->begin(), data->end(),
+                               [&](const auto& dc) -> bool {
+                                   return !dc || handler->invoke_all(dc.get());
+                               }),
+                data->end());
+    // Tracks are no longer indexed by cell number
+    m_streamingStates.clear();
 
     return length - data->size();  // Return new count of objects
 }
 
+/**
+ * @brief Updates the provisional classification of all tracks which were observed in the current
+ * frame. A committed label is written to the track immediately, such that it is available while
+ * the object is still in the channel. Tracks are not classified while the ObjectHandler may still
+ * reject them from the frames observed so far
+ */
+void ObjectFinder::updateEarlyDecisions() {
+    m_streamingStates.resize(m_cellNum);
+    for (const Tracker& t : m_trackerList) {
+        StreamingState& state = m_streamingStates[t.cell_no];
+        if (t.frame_no != m_frameNum || state.label >= 0) {
+            continue;
+        }
+        DataContainer& dc = *m_experiment->data[t.cell_no];
+        if (handler->invoke_tracked(&dc)) {
+            continue;
+        }
+        if (ml_model->updateObject(dc, state, m_setup->earlyDecisionMargin) >= 0) {
+            dc.front()->setValue(data::OutputValue, (double) state.label);
+        }
+    }
+}
+
+bool ObjectFinder::hasEarlyDecision(int cellNo) const {
+    return static_cast<size_t>(cellNo) < m_streamingStates.size() &&
+           m_streamingStates[cellNo].label >= 0;
+}
+
+/**
+ * @brief Withdraws the committed label of a track which was rejected by the ObjectHandler after
+ * its early decision, such that it has neither an output value nor a classification result
+ */
+void ObjectFinder::withdrawEarlyDecision(int cellNo) {
+    DataContainer& dc = *m_experiment->data[cellNo];
+    dc.front()->setValue(data::OutputValue, 0.0);
+    ml_model->withdrawResult(dc);
+    m_streamingStates[cellNo] = StreamingState();
+}
+
+/**
+ * @brief Hands tracks which were not continued in the current frame to the streaming exporter.
+ * Trackers only look one frame back, so such tracks can never be appended to again. Tracks
+ * rejected by the ObjectHandler are released immediately, valid tracks once their block has been
+ * written.
+ */
+void ObjectFinder::streamClosedTracks() {
+    // A track may hold several trackers if multiple objects were matched to it - it is only closed
+    // if none of them were continued
+    std::vector<int> continued;
+    for (const Tracker& t : m_frameTracker) {
+        if (t.found) {
+            continued.push_back(t.cell_no);
+        }
+    }
+
+    for (const Tracker& t : m_frameTracker) {
+        auto& dc = m_experiment->data[t.cell_no];
+        if (t.found || !dc ||
+            std::find(continued.begin(), continued.end(), t.cell_no) != continued.end() ||
+            std::find(m_closedTracks.begin(), m_closedTracks.end(), t.cell_no) !=
+                m_closedTracks.end()) {
+            continue;
+        }
+        if (handler->invoke_all(dc.get())) {
+            dc.reset();
+        } else {
+            m_closedTracks.push_back(t.cell_no);
+            m_closedObjects += dc->size();
+        }
+    }
+
+    if (m_closedObjects >= s_streamBlockObjects) {
+        flushClosedTracks();
+    }
+}
+
+/**
+ * @brief Writes all pending closed tracks as a single block, and releases them
+ */
+void ObjectFinder::flushClosedTracks() {
+    std::vector<DataContainer*> tracks;
+    for (int i : m_closedTracks) {
+        tracks.push_back(m_experiment->data[i].get());
+    }
+    m_experiment->trackExporter.writeBlock(tracks);
+    for (int i : m_closedTracks) {
+        m_experiment->data[i].reset();
+    }
+    m_closedTracks.clear();
+    m_closedObjects = 0;
+}
+
 /**
  * @brief
  * @param objects
@@ -217,9 +378,11 @@ ObjectFinder::findNearestObject(const cv::Point& object,
  * @brief
  * @param newObject
  * @param cc_i
+ * @param components
  * @param experiment
  */
-void ObjectFinder::writeToDataVector(const int& cc_i, Experiment& experiment) {
+void ObjectFinder::writeToDataVector(const int& cc_i, DataContainer& components,
+                                     Experiment& experiment) {
     int i;
     if (m_newObject) {
         experiment.data.emplace_back(new DataContainer(data::AllFlags));
@@ -233,29 +396,29 @@ void ObjectFinder::writeToDataVector(const int& cc_i, Experiment& experiment) {
     experiment.data[i]->appendNew();
 
     // Get some data (should be moved)
-    double gradientScore =
-        mathlab::gradientScore(m_rawImg, m_cc[cc_i]->getValue<cv::Rect>(data::BoundingBox));
-    double symmetry =
-        mathlab::verticalSymmetry(m_rawImg, m_cc[cc_i]->getValue<cv::Rect>(data::BoundingBox),
-                                  m_cc[cc_i]->getValue<double>(data::Major_axis));
+    const cv::Rect boundingBox = components[cc_i]->getValue<cv::Rect>(data::BoundingBox);
+    double gradientScore = mathlab::gradientScore(m_rawImg, boundingBox);
+    double symmetry = mathlab::verticalSymmetry(
+        m_rawImg, boundingBox, components[cc_i]->getValue<double>(data::Major_axis));
 
     auto dc_ptr = (*experiment.data[i]).back();
-    dc_ptr->setValue(data::Area, m_cc[cc_i]->getValue<double>(data::Area));
-    dc_ptr->setValue(data::BoundingBox, m_cc[cc_i]->getValue<cv::Rect>(data::BoundingBox));
+    dc_ptr->setValue(data::Area, components[cc_i]->getValue<double>(data::Area));
+    dc_ptr->setValue(data::BoundingBox, boundingBox);
     dc_ptr->setValue(data::Centroid, m_centroid);
-    dc_ptr->setValue(data::Circularity, m_cc[cc_i]->getValue<double>(data::Circularity));
-    dc_ptr->setValue(data::ConvexArea, m_cc[cc_i]->getValue<double>(data::ConvexArea));
-    dc_ptr->setValue(data::Eccentricity, m_cc[cc_i]->getValue<double>(data::Eccentricity));
+    dc_ptr->setValue(data::Circularity, components[cc_i]->getValue<double>(data::Circularity));
+    dc_ptr->setValue(data::ConvexArea, components[cc_i]->getValue<double>(data::ConvexArea));
+    dc_ptr->setValue(data::Eccentricity,
+                     components[cc_i]->getValue<double>(data::Eccentricity));
     dc_ptr->setValue(data::Frame, m_frameNum);
     dc_ptr->setValue(data::GradientScore, gradientScore);
     dc_ptr->setValue(data::Inlet, m_setup->inlet);
     dc_ptr->setValue(data::Outlet, m_setup->outlet);
     dc_ptr->setValue(data::Label, m_cellNum);
-    dc_ptr->setValue(data::Major_axis, m_cc[cc_i]->getValue<double>(data::Major_axis));
-    dc_ptr->setValue(data::Minor_axis, m_cc[cc_i]->getValue<double>(data::Minor_axis));
-    dc_ptr->setValue(data::Solidity, m_cc[cc_i]->getValue<double>(data::Solidity));
+    dc_ptr->setValue(data::Major_axis, components[cc_i]->getValue<double>(data::Major_axis));
+    dc_ptr->setValue(data::Minor_axis, components[cc_i]->getValue<double>(data::Minor_axis));
+    dc_ptr->setValue(data::Solidity, components[cc_i]->getValue<double>(data::Solidity));
     dc_ptr->setValue(data::Symmetry, symmetry);
-    dc_ptr->setValue(data::Perimeter, m_cc[cc_i]->getValue<double>(data::Perimeter));
+    dc_ptr->setValue(data::Perimeter, components[cc_i]->getValue<double>(data::Perimeter));
     double outputValue = 0.0;
     dc_ptr->setValue(data::OutputValue, outputValue);
     dc_ptr->setValue(data::RelativeXpos, m_xpos);
@@ -272,6 +435,9 @@ void ObjectFinder::writeToDataVector(const int& cc_i, Experiment& experiment) {
 void ObjectFinder::reset() {
     m_trackerList.clear();
     m_frameTracker.clear();
+    m_closedTracks.clear();
+    m_closedObjects = 0;
+    m_streamingStates.clear();
 
     m_cellNum = 0;
     m_frameNum = 0;
@@ -91,6 +91,17 @@ public:
         return false;
     }
 
+    /**
+     * Conditions which can be decided while the object is still being tracked. The first frame of
+     * an object is final and its frame count only grows, whereas FrameAfterOutlet depends on the
+     * last frame and is only decided once the object has left
+     * @return true if the object is, or may still be, rejected by these conditions
+     */
+    bool invoke_tracked(const DataContainer* dc) {
+        return ((FrameCount & m_conditionFlags) && frameCount(this, dc)) ||
+               ((FrameBeforeInlet & m_conditionFlags) && frameBeforeInlet(this, dc));
+    }
+
 private:
     // Class members
     Experiment* m_experiment;
@@ -115,6 +126,7 @@ public:
     ObjectFinder(Experiment* experiment, Setup* setup);
 
     int findObjects();
+    int findObjects(const cv::Mat& raw, const cv::Mat& processed, DataContainer& components);
 
     void startThread();
     void waitForThreadToFinish(int targetImageCount);
@@ -133,10 +145,17 @@ public:
 
 private:
     void findObjectsThreaded();
+    int trackObjects(DataContainer& components, LatencyRecorder::Clock::time_point findStart);
 
     ObjectHandler* handler;
     std::unique_ptr<Machinelearning> ml_model;
 
+    // Early classification state of each track, indexed by cell number
+    std::vector<StreamingState> m_streamingStates;
+    void updateEarlyDecisions();
+    bool hasEarlyDecision(int cellNo) const;
+    void withdrawEarlyDecision(int cellNo);
+
     Tracker m_track;
     std::vector<Tracker> m_trackerList, m_frameTracker;
 
@@ -144,6 +163,7 @@ private:
     cv::Mat m_rawImg;
     int m_cellNum = 0;
     int m_frameNum = 0;
+    long m_frameIndex = 0;  // acquisition index of the frame being analyzed, for tracing
     bool m_newObject = false;
     int m_numObjects = 0;
     unsigned long m_dataFlags = 0;
@@ -155,7 +175,14 @@ private:
 
     std::pair<double, unsigned long> findNearestObject(const cv::Point& object,
                                                  std::vector<Tracker>& objects);
-    void writeToDataVector(const int& index, Experiment& experiment);
+    void writeToDataVector(const int& index, DataContainer& components, Experiment& experiment);
+    void streamClosedTracks();
+    void flushClosedTracks();
+
+    // Streaming export: valid closed tracks awaiting to be written as a single block
+    static const size_t s_streamBlockObjects = 1 << 16;
+    std::vector<int> m_closedTracks;
+    size_t m_closedObjects = 0;
 
     // Concurrency
     long m_targetImageCount;
@@ -48,6 +48,7 @@ class ParameterBase {
 public:
     ParameterBase(string name) : m_name(name) {}
     void setModifiable(bool val) { m_isModifiable = val; }
+    const string& getName() const { return m_name; }
     stringstream getOptions() const {
         stringstream s;
         for (const auto& i : m_options) {
@@ -0,0 +1,341 @@
+#include "parametersweep.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+
+#include "imageprefetcher.h"
+#include "objectfinder.h"
+
+namespace {
+const std::vector<std::string> setupParameters = {"countThreshold", "distanceThresholdInlet",
+                                                  "distanceThresholdPath"};
+
+ParameterBase* findParameter(ProcessBase& process, const std::string& name) {
+    for (ParameterBase* parameter : process.getParameters()) {
+        if (parameter->getName() == name) {
+            return parameter;
+        }
+    }
+    return nullptr;
+}
+
+void setSetupParameter(Setup& setup, const std::string& name, const std::string& value) {
+    if (name == "countThreshold") {
+        setup.countThreshold = std::stoi(value);
+    } else if (name == "distanceThresholdInlet") {
+        setup.distanceThresholdInlet = std::stod(value);
+    } else if (name == "distanceThresholdPath") {
+        setup.distanceThresholdPath = std::stod(value);
+    }
+}
+
+// Separates values in prefix tree keys
+const char keySeparator = '\x1f';
+}  // namespace
+
+ParameterSweep::ParameterSweep(const std::vector<std::unique_ptr<ProcessBase>>& processes,
+                               const Setup& setup)
+    : m_setup(setup) {
+    for (const auto& process : processes) {
+        m_processes.push_back(cloneProcess(*process));
+    }
+}
+
+ParameterSweep::~ParameterSweep() {}
+
+/**
+ * @brief Adds a swept parameter. Combinations are enumerated with the values of the last added
+ * axis varying fastest
+ * @throws std::runtime_error if the parameter does not exist or no values are given
+ */
+void ParameterSweep::addAxis(const SweepAxis& axis) {
+    if (axis.values.empty()) {
+        throw std::runtime_error("No values given for parameter " + axis.parameter);
+    }
+    if (axis.process < 0) {
+        if (std::find(setupParameters.begin(), setupParameters.end(), axis.parameter) ==
+            setupParameters.end()) {
+            throw std::runtime_error("Unknown setup parameter " + axis.parameter);
+        }
+    } else if (static_cast<size_t>(axis.process) >= m_processes.size()) {
+        throw std::runtime_error("No process " + std::to_string(axis.process) + " in the chain");
+    } else if (!findParameter(*m_processes[axis.process], axis.parameter)) {
+        throw std::runtime_error("Process " + std::to_string(axis.process) + " has no parameter " +
+                                 axis.parameter);
+    }
+    m_axes.push_back(axis);
+}
+
+size_t ParameterSweep::combinationCount() const {
+    size_t count = 1;
+    for (const auto& axis : m_axes) {
+        count *= axis.values.size();
+    }
+    return count;
+}
+
+/**
+ * @brief Builds the prefix tree of the process chains of all combinations, and sets up an object
+ * finder for each combination
+ */
+void ParameterSweep::build() {
+    m_nodes.clear();
+    m_combinations.clear();
+    m_nodes.emplace_back();  // root
+
+    const size_t chainLength = m_processes.size();
+    // Prefix tree nodes by their key: the parent node, the values of the process and, for
+    // processes before the last process modifying the background, the values up to that process
+    std::map<std::string, size_t> nodeIndex;
+    // Whether a process modifies the background, by its index and values
+    std::map<std::string, bool> modifiesBackground;
+
+    const size_t combinationCount = this->combinationCount();
+    for (size_t c = 0; c < combinationCount; c++) {
+        auto combination = std::make_unique<Combination>();
+        combination->setup = m_setup;
+
+        // Values of each process, and of the setup
+        std::vector<std::vector<std::pair<std::string, std::string>>> processValues(chainLength);
+        size_t remainder = c;
+        combination->values.resize(m_axes.size());
+        for (size_t a = m_axes.size(); a-- > 0;) {
+            const SweepAxis& axis = m_axes[a];
+            const std::string& value = axis.values[remainder % axis.values.size()];
+            remainder /= axis.values.size();
+            combination->values[a] = value;
+            if (axis.process < 0) {
+                setSetupParameter(combination->setup, axis.parameter, value);
+            } else {
+                processValues[axis.process].emplace_back(axis.parameter, value);
+            }
+        }
+        std::vector<std::string> valueKeys(chainLength);
+        for (size_t k = 0; k < chainLength; k++) {
+            for (auto it = processValues[k].rbegin(); it != processValues[k].rend(); ++it) {
+                valueKeys[k] += it->first + keySeparator + it->second + keySeparator;
+            }
+        }
+
+        // The last process of the chain which modifies the background
+        long lastModifier = -1;
+        for (size_t k = 0; k < chainLength; k++) {
+            const std::string key = std::to_string(k) + keySeparator + valueKeys[k];
+            auto it = modifiesBackground.find(key);
+            if (it == modifiesBackground.end()) {
+                std::unique_ptr<ProcessBase> process = cloneProcess(*m_processes[k]);
+                for (const auto& value : processValues[k]) {
+                    findParameter(*process, value.first)->setValueStr(value.second);
+                }
+                it = modifiesBackground.emplace(key, process->modifiesBackground()).first;
+            }
+            if (it->second) {
+                lastModifier = static_cast<long>(k);
+            }
+        }
+
+        size_t parent = 0;
+        std::vector<size_t> path;
+        for (size_t k = 0; k < chainLength; k++) {
+            std::string key = std::to_string(parent) + keySeparator + valueKeys[k];
+            if (static_cast<long>(k) < lastModifier) {
+                key += std::to_string(lastModifier) + keySeparator;
+                for (long j = k + 1; j <= lastModifier; j++) {
+                    key += valueKeys[j] + keySeparator;
+                }
+            }
+            auto it = nodeIndex.find(key);
+            if (it == nodeIndex.end()) {
+                Node node;
+                node.process = cloneProcess(*m_processes[k]);
+                for (const auto& value : processValues[k]) {
+                    findParameter(*node.process, value.first)->setValueStr(value.second);
+                }
+                m_nodes.push_back(std::move(node));
+                m_nodes[parent].children.push_back(m_nodes.size() - 1);
+                it = nodeIndex.emplace(key, m_nodes.size() - 1).first;
+            }
+            parent = it->second;
+            path.push_back(parent);
+        }
+        // The processes up to the last background modifier are specific to this chain, and the
+        // processes following it are only shared by chains with the same modifier. They all use
+        // the background held by the modifier
+        if (lastModifier >= 0) {
+            for (size_t node : path) {
+                m_nodes[node].bgOwner = static_cast<long>(path[lastModifier]);
+            }
+        }
+        m_nodes[parent].combinations.push_back(c);
+
+        combination->experiment.setInletOutletLines(combination->setup.inlet,
+                                                    combination->setup.outlet);
+        combination->finder =
+            std::make_unique<ObjectFinder>(&combination->experiment, &combination->setup);
+        m_combinations.push_back(std::move(combination));
+    }
+}
+
+/**
+ * @brief Processes a frame through a node and its subtree, and finds the objects of all
+ * combinations of which the chain ends in the node
+ */
+void ParameterSweep::evaluate(size_t index, const cv::Mat& input, const cv::Mat& raw) {
+    Node& node = m_nodes[index];
+    cv::Mat output = input;
+    if (node.process) {
+        output = input.clone();
+        cv::Mat& bg = node.bgOwner >= 0 ? m_nodes[node.bgOwner].bg : m_bg;
+        node.process->doProcessing(output, bg, m_experiment);
+    }
+
+    if (!node.combinations.empty()) {
+        DataContainer components(data::AllFlags);
+        mathlab::regionProps(output, mathlab::WithoutPixelIdxList, components);
+        for (size_t c : node.combinations) {
+            m_combinations[c]->finder->findObjects(raw, output, components);
+        }
+    }
+
+    for (size_t child : node.children) {
+        evaluate(child, output, raw);
+    }
+}
+
+/**
+ * @brief Runs all combinations on the frames returned by nextFrame, until it returns false
+ * @return results of the combinations, in the order described in addAxis()
+ */
+std::vector<SweepResult> ParameterSweep::run(const std::function<bool(cv::Mat&)>& nextFrame) {
+    build();
+    m_frames = 0;
+    m_bg.release();
+
+    cv::Mat frame;
+    while (nextFrame(frame) && !frame.empty()) {
+        // As in Analyzer::runAnalyzer(), the first frame is used as the background
+        if (m_bg.cols != frame.cols || m_bg.rows != frame.rows) {
+            m_bg = frame.clone();
+            for (size_t i = 0; i < m_nodes.size(); i++) {
+                if (m_nodes[i].bgOwner == static_cast<long>(i)) {
+                    m_nodes[i].bg = frame.clone();
+                }
+            }
+        }
+        // The frame must not be modified, as it is the raw image of all combinations
+        evaluate(0, frame.clone(), frame);
+        m_frames++;
+    }
+    return collectResults();
+}
+
+/**
+ * @brief Overload: Runs all combinations on a list of image files, which are decoded ahead of the
+ * sweep
+ */
+std::vector<SweepResult> ParameterSweep::run(const std::vector<std::string>& files,
+                                             size_t prefetchWindow, unsigned int prefetchThreads) {
+    ImagePrefetcher prefetcher;
+    prefetcher.setConfig(prefetchWindow, prefetchThreads);
+    prefetcher.setFiles(files);
+    return run([&prefetcher](cv::Mat& image) { return prefetcher.next(image); });
+}
+
+std::vector<SweepResult> ParameterSweep::collectResults() {
+    std::vector<SweepResult> results;
+    for (const auto& combination : m_combinations) {
+        combination->finder->cleanObjects();
+
+        SweepResult result;
+        result.values = combination->values;
+        long frames = 0;
+        for (const auto& track : combination->experiment.data) {
+            result.objects++;
+            frames += static_cast<long>(track->size());
+            if (combination->setup.classifyObjects) {
+                const double label = track->front()->getValue<double>(data::OutputValue);
+                result.classes[static_cast<int>(std::lround(label))]++;
+            }
+        }
+        result.meanTrackLength =
+            result.objects > 0 ? static_cast<double>(frames) / result.objects : 0;
+        results.push_back(result);
+    }
+    return results;
+}
+
+size_t ParameterSweep::processEvaluations() const {
+    return m_nodes.empty() ? 0 : m_nodes.size() - 1;
+}
+
+size_t ParameterSweep::chainEvaluations() const {
+    size_t count = 0;
+    for (const Node& node : m_nodes) {
+        count += node.combinations.empty() ? 0 : 1;
+    }
+    return count;
+}
+
+/**
+ * @brief Writes the results of a sweep as CSV, with a column for each axis, the object count, the
+ * mean track length and the object count of each class
+ */
+bool ParameterSweep::writeResults(const std::string& path,
+                                  const std::vector<SweepResult>& results) const {
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::set<int> classes;
+    for (const auto& result : results) {
+        for (const auto& count : result.classes) {
+            classes.insert(count.first);
+        }
+    }
+
+    for (const auto& axis : m_axes) {
+        file << (axis.process < 0 ? std::string("setup")
+                                  : "process" + std::to_string(axis.process))
+             << "." << axis.parameter << ",";
+    }
+    file << "objects,mean_track_length";
+    for (int label : classes) {
+        file << ",class_" << label;
+    }
+    file << "\n";
+
+    for (const auto& result : results) {
+        for (const auto& value : result.values) {
+            file << value << ",";
+        }
+        file << result.objects << "," << result.meanTrackLength;
+        for (int label : classes) {
+            const auto it = result.classes.find(label);
+            file << "," << (it == result.classes.end() ? 0 : it->second);
+        }
+        file << "\n";
+    }
+    return file.good();
+}
+
+/**
+ * @brief Returns the values first, first + step, ... up to and including last
+ * @throws std::runtime_error if step is not positive
+ */
+std::vector<std::string> ParameterSweep::range(double first, double last, double step) {
+    if (!(step > 0)) {
+        throw std::runtime_error("Sweep range step must be positive");
+    }
+    std::vector<std::string> values;
+    const long count = static_cast<long>(std::floor((last - first) / step + 1e-9)) + 1;
+    for (long i = 0; i < count; i++) {
+        std::ostringstream value;
+        value << first + i * step;
+        values.push_back(value.str());
+    }
+    return values;
+}
@@ -0,0 +1,109 @@
+#ifndef RTOC_PARAMETERSWEEP_H
+#define RTOC_PARAMETERSWEEP_H
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <opencv/cv.hpp>
+
+#include "experiment.h"
+#include "process.h"
+#include "setup.h"
+
+class ObjectFinder;
+
+/**
+ * @brief A swept parameter and the values it takes
+ */
+struct SweepAxis {
+    // Index of the process in the process chain, or -1 for a parameter of the experiment setup
+    int process = -1;
+    // Parameter name as shown in the process configurator (eg. Edge_threshold). Setup parameters
+    // are countThreshold, distanceThresholdInlet and distanceThresholdPath
+    std::string parameter;
+    // Values as set through ParameterBase::setValueStr(), ie. enum values are given by name
+    std::vector<std::string> values;
+};
+
+struct SweepResult {
+    std::vector<std::string> values;  // value of each axis
+    long objects = 0;                 // tracks accepted by the object handler conditions
+    double meanTrackLength = 0;       // frames per accepted track
+    std::map<int, long> classes;      // accepted tracks per class, if the setup classifies objects
+};
+
+/**
+ * @brief The ParameterSweep class
+ * @details Evaluates every combination of a set of parameter values for a process chain and an
+ * experiment setup, in a single pass over the frames of a recorded experiment.
+ *
+ * Each frame is decoded once. The process chains of all combinations are arranged as a prefix
+ * tree, such that a process is evaluated once per frame for all combinations which share its
+ * configuration and the configuration of the processes before it. The connected components of a
+ * processed image are found once, and are shared by all combinations which only differ by setup
+ * parameters, each of which tracks the objects with its own ObjectFinder.
+ *
+ * Processes which modify the background (see ProcessBase::modifiesBackground()) feed it back into
+ * the following frames of their chain, so the processes before them are only shared between
+ * chains which are identical up to the last such process.
+ */
+class ParameterSweep {
+public:
+    ParameterSweep(const std::vector<std::unique_ptr<ProcessBase>>& processes, const Setup& setup);
+    ~ParameterSweep();
+
+    void addAxis(const SweepAxis& axis);
+    const std::vector<SweepAxis>& axes() const { return m_axes; }
+    size_t combinationCount() const;
+
+    std::vector<SweepResult> run(const std::function<bool(cv::Mat&)>& nextFrame);
+    std::vector<SweepResult> run(const std::vector<std::string>& files, size_t prefetchWindow = 16,
+                                 unsigned int prefetchThreads = 2);
+
+    // Statistics of the last run
+    long frames() const { return m_frames; }
+    size_t processEvaluations() const;  // process invocations per frame
+    size_t chainEvaluations() const;    // distinct processed images per frame
+
+    bool writeResults(const std::string& path, const std::vector<SweepResult>& results) const;
+
+    static std::vector<std::string> range(double first, double last, double step);
+
+private:
+    struct Node {
+        std::unique_ptr<ProcessBase> process;  // nullptr for the root, ie. the raw frame
+        std::vector<size_t> children;
+        // Node holding the background of this node's chain, or -1 for the shared background
+        long bgOwner = -1;
+        cv::Mat bg;                        // background of the chains of which this is the owner
+        std::vector<size_t> combinations;  // combinations of which this node ends the chain
+    };
+
+    // Combinations are held by pointer, as their object finder refers to their setup and
+    // experiment
+    struct Combination {
+        std::vector<std::string> values;
+        Setup setup;
+        Experiment experiment;
+        std::unique_ptr<ObjectFinder> finder;
+    };
+
+    void build();
+    void evaluate(size_t index, const cv::Mat& input, const cv::Mat& raw);
+    std::vector<SweepResult> collectResults();
+
+    std::vector<std::unique_ptr<ProcessBase>> m_processes;  // copy of the swept process chain
+    Setup m_setup;
+    std::vector<SweepAxis> m_axes;
+
+    std::vector<Node> m_nodes;
+    std::vector<std::unique_ptr<Combination>> m_combinations;
+    Experiment m_experiment;  // passed to the processes
+    cv::Mat m_bg;             // background of chains which do not modify it
+    long m_frames = 0;
+};
+
+#endif  // RTOC_PARAMETERSWEEP_H
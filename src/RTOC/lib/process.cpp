@@ -1,5 +1,7 @@
 #include "process.h"
 
+#include <sstream>
+
 void ProcessNameGenerator::add_process(const std::string& name) {
     ProcessBase::get_processes().push_back(name);
 }
@@ -168,6 +170,26 @@ void PropFilter::doProcessing(cv::Mat& img, cv::Mat&, const Experiment& props) c
 
 }
 
+/**
+ * @brief Creates an independent copy of a process, with the same parameter values and no state
+ * of previous frames. The copy is made through serialization, such that it is exact for all
+ * parameter types
+ */
+std::unique_ptr<ProcessBase> cloneProcess(const ProcessBase& process) {
+    std::stringstream stream;
+    {
+        boost::archive::xml_oarchive oa(stream);
+        const ProcessBase* source = &process;
+        oa << boost::serialization::make_nvp("process", source);
+    }
+    ProcessBase* copy = nullptr;
+    {
+        boost::archive::xml_iarchive ia(stream);
+        ia >> boost::serialization::make_nvp("process", copy);
+    }
+    return std::unique_ptr<ProcessBase>(copy);
+}
+
 // Export all process types for serialization
 BOOST_CLASS_EXPORT_GUID(Morph, "Morph")
 BOOST_CLASS_EXPORT_GUID(Binarize, "Binarize")
@@ -80,6 +80,9 @@ public:
     doProcessing(cv::Mat& img, cv::Mat& bg,
                  const Experiment& props) const = 0;  // General function for doing processing.
     const std::vector<ParameterBase*>& getParameters() { return PARAMETER_CONTAINER; }
+    // True if doProcessing() may modify the background, which is then carried over to the
+    // following processes and frames
+    virtual bool modifiesBackground() const { return false; }
     static std::vector<std::string>& get_processes();
 
     template <typename Archive>
@@ -188,6 +191,9 @@ public:
         dynamicBackground = 1 << 1
     };
     SETUP_PROCESS(SubtractBG, "Subtract background")
+    bool modifiesBackground() const override {
+        return m_subtractMethod.getValue() == dynamicBackground;
+    }
 
     CREATE_ENUM_PARM_DEFAULT(SubtractMethod, m_subtractMethod, "Subtract_method", SubtractMethod::staticBackground);
     CREATE_VALUE_PARM(double, m_alpha, "Alpha");
@@ -265,6 +271,8 @@ public:
     }
 };
 
+std::unique_ptr<ProcessBase> cloneProcess(const ProcessBase& process);
+
 /** Process meta-functions ---------------------------------
  *  Used for type-resolving the type data provided by a process stream
  * */
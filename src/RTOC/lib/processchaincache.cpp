@@ -0,0 +1,124 @@
+#include "processchaincache.h"
+
+#include <opencv2/imgcodecs.hpp>
+
+namespace {
+std::string signature(ProcessBase& process) {
+    std::string signature = process.getTypeName();
+    for (const ParameterBase* parameter : process.getParameters()) {
+        signature += ' ' + parameter->getValueStr();
+    }
+    return signature;
+}
+}  // namespace
+
+/**
+ * @brief Updates the cached chain to a process chain. Processes which differ from the cached
+ * process at the same position are copied, and the outputs from the first of them onwards are
+ * invalidated
+ */
+void ProcessChainCache::setChain(const std::vector<std::unique_ptr<ProcessBase>>& processes) {
+    size_t firstChange = processes.size();
+    for (size_t i = processes.size(); i-- > 0;) {
+        const std::string processSignature = signature(*processes[i]);
+        if (i < m_stages.size() && m_stages[i].signature == processSignature) {
+            continue;
+        }
+        if (i >= m_stages.size()) {
+            m_stages.resize(i + 1);
+        }
+        m_stages[i].process = cloneProcess(*processes[i]);
+        m_stages[i].signature = processSignature;
+        firstChange = i;
+    }
+    if (m_stages.size() > processes.size()) {
+        m_stages.resize(processes.size());
+    }
+    invalidate(firstChange);
+}
+
+/**
+ * @brief Sets the frame to be processed, invalidating all cached outputs. As in
+ * Analyzer::processSingleFrame(), the first frame of a given size is used as the background
+ * @param key : identifies the frame, such that the caller can tell whether it is current
+ */
+void ProcessChainCache::setFrame(const cv::Mat& frame, const std::string& key) {
+    m_frameKey = key;
+    m_frame = frame.clone();
+    if (m_bg.rows != m_frame.rows || m_bg.cols != m_frame.cols) {
+        m_bg = m_frame.clone();
+    }
+    invalidate(0);
+}
+
+/**
+ * @brief Reads the frame to be processed from an image file, unless it is the current frame
+ * @return false if the image could not be read
+ */
+bool ProcessChainCache::loadFrame(const std::string& path) {
+    if (path == m_frameKey && !m_frame.empty()) {
+        return true;
+    }
+    const cv::Mat frame = cv::imread(path, cv::IMREAD_GRAYSCALE);
+    if (frame.empty()) {
+        return false;
+    }
+    setFrame(frame, path);
+    return true;
+}
+
+void ProcessChainCache::clear() {
+    m_stages.clear();
+    m_frameKey.clear();
+    m_frame.release();
+    m_bg.release();
+}
+
+/**
+ * @brief Processes the current frame through the processes of which the output is not cached
+ * @details cancelled is polled before each process. When it returns true, the outputs of the
+ * processes run so far are kept, and the next call continues from there.
+ *
+ * @param output : output of the last process of the chain, or the frame for an empty chain. The
+ * image is shared with the cache, and must not be modified
+ * @return false if no frame is set or processing was cancelled
+ */
+bool ProcessChainCache::process(cv::Mat& output, const std::function<bool()>& cancelled) {
+    m_evaluations = 0;
+    if (m_frame.empty()) {
+        return false;
+    }
+    for (size_t i = cachedStages(); i < m_stages.size(); i++) {
+        if (cancelled && cancelled()) {
+            return false;
+        }
+        Stage& stage = m_stages[i];
+        const cv::Mat& input = i == 0 ? m_frame : m_stages[i - 1].output;
+        const cv::Mat& bg = i == 0 ? m_bg : m_stages[i - 1].bg;
+        stage.output = input.clone();
+        // The background is only copied for processes which may modify it, as the cached
+        // backgrounds must be left intact
+        stage.bg = stage.process->modifiesBackground() ? bg.clone() : bg;
+        stage.process->doProcessing(stage.output, stage.bg, m_experiment);
+        stage.valid = true;
+        m_evaluations++;
+    }
+    output = m_stages.empty() ? m_frame : m_stages.back().output;
+    return true;
+}
+
+size_t ProcessChainCache::cachedStages() const {
+    size_t count = 0;
+    while (count < m_stages.size() && m_stages[count].valid) {
+        count++;
+    }
+    return count;
+}
+
+void ProcessChainCache::invalidate(size_t first) {
+    for (size_t i = first; i < m_stages.size(); i++) {
+        m_stages[i].valid = false;
+        m_stages[i].output.release();
+        m_stages[i].bg.release();
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef RTOC_PROCESSCHAINCACHE_H
+#define RTOC_PROCESSCHAINCACHE_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <opencv/cv.hpp>
+
+#include "experiment.h"
+#include "process.h"
+
+/**
+ * @brief The ProcessChainCache class
+ * @details Processes a single frame through a process chain, keeping the output of each process.
+ * When the chain is changed, only the processes from the first changed process onwards are
+ * rerun, starting from the cached output of the process before it. Processes are compared by
+ * type and parameter values.
+ *
+ * The cache processes copies of the processes of the chain, such that the frame can be processed
+ * on a worker thread while the chain is edited. setChain(), setFrame() and loadFrame() must not
+ * be called while process() is running.
+ */
+class ProcessChainCache {
+public:
+    void setChain(const std::vector<std::unique_ptr<ProcessBase>>& processes);
+    void setFrame(const cv::Mat& frame, const std::string& key = std::string());
+    bool loadFrame(const std::string& path);
+    void clear();
+
+    bool process(cv::Mat& output, const std::function<bool()>& cancelled = nullptr);
+
+    const cv::Mat& frame() const { return m_frame; }
+    const std::string& frameKey() const { return m_frameKey; }
+    size_t chainLength() const { return m_stages.size(); }
+    size_t cachedStages() const;                            // processes with a valid output
+    size_t lastEvaluations() const { return m_evaluations; }  // processes run by process()
+
+private:
+    struct Stage {
+        std::unique_ptr<ProcessBase> process;
+        std::string signature;  // type and parameter values of the process
+        bool valid = false;
+        cv::Mat output;
+        cv::Mat bg;  // background following the process
+    };
+
+    void invalidate(size_t first);
+
+    std::vector<Stage> m_stages;
+    std::string m_frameKey;  // identifies the current frame, ie. its file
+    cv::Mat m_frame;
+    cv::Mat m_bg;
+    Experiment m_experiment;  // passed to the processes
+    size_t m_evaluations = 0;
+};
+
+#endif  // RTOC_PROCESSCHAINCACHE_H
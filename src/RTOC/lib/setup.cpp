@@ -0,0 +1,46 @@
+#include "setup.h"
+
+#include <fstream>
+
+/**
+ * @brief Serializes setup to an .xml file, eg. for running the experiment with the batch runner
+ * @return true if the setup was stored successfully
+ */
+bool storeExperimentSetup(const Setup& setup, const std::string& path) {
+    try {
+        std::ofstream ofs(path);
+        if (!ofs.is_open()) {
+            return false;
+        }
+        {
+            boost::archive::xml_oarchive oa(ofs);
+            oa << boost::serialization::make_nvp("setup", setup);
+        }
+        ofs.close();
+        return !ofs.fail();
+    } catch (...) {
+        return false;
+    }
+}
+
+/**
+ * @brief Loads a setup stored by storeExperimentSetup()
+ * @return true if the setup was loaded successfully. setup is left unchanged otherwise
+ */
+bool loadExperimentSetup(const std::string& path, Setup& setup) {
+    try {
+        std::ifstream ifs(path);
+        if (!ifs.is_open()) {
+            return false;
+        }
+        Setup loaded = setup;
+        {
+            boost::archive::xml_iarchive ia(ifs);
+            ia >> boost::serialization::make_nvp("setup", loaded);
+        }
+        setup = loaded;
+    } catch (...) {
+        return false;
+    }
+    return true;
+}
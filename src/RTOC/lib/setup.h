@@ -7,10 +7,18 @@
 
 #include <boost/serialization/serialization.hpp>
 #include "boost/serialization/nvp.hpp"
+#include <boost/serialization/string.hpp>
+#include <boost/serialization/utility.hpp>
+#include <boost/serialization/version.hpp>
 
 #include <boost/archive/xml_iarchive.hpp>
 #include <boost/archive/xml_oarchive.hpp>
 
+#include "boundedqueue.h"
+
+// File format of exported experiment data
+enum class ExportFormat { Text, Binary };
+
 class Setup {
 public:
     Setup() {}
@@ -34,6 +42,21 @@ public:
     std::string modelPath;
     std::string experimentName;
 
+    // Queue limits. A capacity of 0 leaves the queue unbounded
+    unsigned int analysisQueueCapacity = 0;  // raw/processed image pairs awaiting object finding
+    unsigned int storageQueueCapacity = 0;   // images awaiting disk writing (per image writer)
+    QueuePolicy analysisQueuePolicy = QueuePolicy::Block;
+    QueuePolicy storageQueuePolicy = QueuePolicy::Block;
+
+    ExportFormat exportFormat = ExportFormat::Text;
+
+    // Commit a classification before the object has left the channel, once the provisional
+    // probability is at least this far from the decision boundary. 0 disables early decisions
+    double earlyDecisionMargin = 0;
+
+    // Record a timeline of the analyzer pipeline, written as <experimentName>_trace.json
+    bool traceTimeline = false;
+
     friend class boost::serialization::access;
     template <class Archive>
     void serialize(Archive& ar, const unsigned int version) {
@@ -55,7 +78,33 @@ public:
         ar& BOOST_SERIALIZATION_NVP(processedPrefix);
         ar& BOOST_SERIALIZATION_NVP(outputPath);
         ar& BOOST_SERIALIZATION_NVP(experimentName);
+
+        if (version > 0) {
+            ar& BOOST_SERIALIZATION_NVP(analysisQueueCapacity);
+            ar& BOOST_SERIALIZATION_NVP(storageQueueCapacity);
+            ar& BOOST_SERIALIZATION_NVP(analysisQueuePolicy);
+            ar& BOOST_SERIALIZATION_NVP(storageQueuePolicy);
+        }
+        if (version > 1) {
+            ar& BOOST_SERIALIZATION_NVP(exportFormat);
+        }
+        if (version > 2) {
+            ar& BOOST_SERIALIZATION_NVP(earlyDecisionMargin);
+        }
+        if (version > 3) {
+            ar& BOOST_SERIALIZATION_NVP(traceTimeline);
+        }
+        if (version > 4) {
+            ar& BOOST_SERIALIZATION_NVP(classifyObjects);
+            ar& BOOST_SERIALIZATION_NVP(modelPath);
+            ar& BOOST_SERIALIZATION_NVP(recordingTime);
+        }
     }
 };
 
+BOOST_CLASS_VERSION(Setup, 5)
+
+bool storeExperimentSetup(const Setup& setup, const std::string& path);
+bool loadExperimentSetup(const std::string& path, Setup& setup);
+
 #endif  // RTOC_SETUP_H
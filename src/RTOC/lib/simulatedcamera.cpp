@@ -0,0 +1,173 @@
+#include "simulatedcamera.h"
+
+#include <chrono>
+#include <random>
+
+namespace {
+typedef std::chrono::steady_clock Clock;
+}
+
+SimulatedCamera::~SimulatedCamera() {
+    stop();
+}
+
+/**
+ * @brief Sets the camera configuration. Changes are ignored while the camera is running
+ */
+void SimulatedCamera::setConfig(const SimulatedCameraConfig& config) {
+    std::lock_guard<std::mutex> lock(m_configMutex);
+    if (!m_running) {
+        m_config = config;
+    }
+}
+
+SimulatedCameraConfig SimulatedCamera::getConfig() const {
+    std::lock_guard<std::mutex> lock(m_configMutex);
+    return m_config;
+}
+
+/**
+ * @brief Sets a sequence of frames which are replayed cyclically instead of generated frames. The
+ * camera resolution is set to the resolution of the first frame. An empty vector reverts to
+ * generated frames.
+ */
+void SimulatedCamera::setReplayFrames(const std::vector<cv::Mat>& frames) {
+    std::lock_guard<std::mutex> lock(m_configMutex);
+    if (m_running) {
+        return;
+    }
+    m_replayFrames = frames;
+    if (!m_replayFrames.empty()) {
+        m_config.width = m_replayFrames[0].cols;
+        m_config.height = m_replayFrames[0].rows;
+    }
+}
+
+void SimulatedCamera::start() {
+    std::lock_guard<std::mutex> lock(m_configMutex);
+    if (m_running) {
+        return;
+    }
+    // (Re)allocate the buffer ring
+    m_buffers.clear();
+    for (size_t i = 0; i < m_config.bufferCount; i++) {
+        m_buffers.emplace_back(m_config.height, m_config.width, CV_8UC1);
+    }
+
+    // Drain rings from a previous run. The consumer must have released all frames before start()
+    Published p;
+    while (m_published.try_dequeue(p))
+        ;
+    size_t b;
+    while (m_released.try_dequeue(b))
+        ;
+
+    m_generatedFrames = 0;
+    m_missedFrames = 0;
+    m_overrunFrames = 0;
+
+    m_running = true;
+    m_thread = std::thread(&SimulatedCamera::acquisitionThreaded, this);
+}
+
+void SimulatedCamera::stop() {
+    m_running = false;
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+/**
+ * @brief Waits for the next frame
+ * @param frame : set to the next frame on success. Valid until handed back through releaseFrame()
+ * @param timeoutMs : maximum time to wait for a frame
+ * @return true if a frame was acquired
+ */
+bool SimulatedCamera::acquireFrame(SimulatedFrame& frame, int timeoutMs) {
+    Published p;
+    if (!m_published.wait_dequeue_timed(p, std::chrono::milliseconds(timeoutMs))) {
+        return false;
+    }
+    frame.bufNr = p.bufNr;
+    frame.frameNo = p.frameNo;
+    frame.image = m_buffers[p.bufNr];
+    return true;
+}
+
+void SimulatedCamera::releaseFrame(const SimulatedFrame& frame) {
+    m_released.enqueue(frame.bufNr);
+}
+
+void SimulatedCamera::acquisitionThreaded() {
+    std::mt19937 rng(m_config.seed);
+    // The distribution requires a positive standard deviation, and is only sampled with jitter set
+    std::normal_distribution<double> jitter(0.0, m_config.jitterUs > 0 ? m_config.jitterUs : 1.0);
+
+    // Buffers not currently lent to the consumer. Only accessed by this thread
+    std::vector<size_t> freeBuffers;
+    for (size_t i = m_buffers.size(); i > 0; i--) {
+        freeBuffers.push_back(i - 1);
+    }
+
+    const auto period = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(1.0 / m_config.fps));
+    const auto start = Clock::now();
+
+    long tick = 0;
+    while (m_running) {
+        // Frame is due at its nominal time plus jitter
+        auto due = start + period * tick;
+        if (m_config.jitterUs > 0) {
+            due += std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double, std::micro>(jitter(rng)));
+        }
+        std::this_thread::sleep_until(due);
+
+        // Detect if we have fallen behind by more than a frame period
+        long lateTicks = (Clock::now() - (start + period * tick)) / period;
+        if (lateTicks > 0) {
+            m_overrunFrames += lateTicks;
+            tick += lateTicks;
+        }
+
+        // Reclaim buffers released by the consumer
+        size_t bufNr;
+        while (m_released.try_dequeue(bufNr)) {
+            freeBuffers.push_back(bufNr);
+        }
+
+        if (freeBuffers.empty()) {
+            // All buffers are blocked by the consumer - the frame is lost
+            m_missedFrames++;
+        } else {
+            bufNr = freeBuffers.back();
+            freeBuffers.pop_back();
+            renderFrame(m_buffers[bufNr], tick);
+            m_published.enqueue(Published{bufNr, tick});
+            m_generatedFrames++;
+        }
+        tick++;
+    }
+}
+
+void SimulatedCamera::renderFrame(cv::Mat& buffer, long frameNo) const {
+    if (!m_replayFrames.empty()) {
+        const cv::Mat& src = m_replayFrames[frameNo % m_replayFrames.size()];
+        src.copyTo(buffer);
+        return;
+    }
+
+    // Dark elliptical objects moving left to right over a bright background, evenly spaced
+    // vertically, with a phase offset such that they do not cross the frame in unison
+    buffer.setTo(cv::Scalar(200));
+    const int rx = std::max(4, m_config.height / 16);
+    const int ry = std::max(3, rx * 2 / 3);
+    const int track = m_config.width + 2 * rx;
+    for (int i = 0; i < m_config.objectCount; i++) {
+        int offset = (i * track) / std::max(1, m_config.objectCount);
+        int x = static_cast<int>(offset + frameNo * m_config.objectSpeed) % track - rx;
+        int y = ((i + 1) * m_config.height) / (m_config.objectCount + 1);
+        cv::ellipse(buffer, cv::Point(x, y), cv::Size(rx, ry), 0, 0, 360, cv::Scalar(60),
+                    cv::FILLED);
+    }
+}
@@ -0,0 +1,96 @@
+#ifndef RTOC_SIMULATEDCAMERA_H
+#define RTOC_SIMULATEDCAMERA_H
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <opencv/cv.hpp>
+
+#ifndef NDEBUG
+#define NDEBUG
+#endif
+#include "../external/readerwriterqueue/readerwriterqueue.h"
+
+struct SimulatedCameraConfig {
+    int width = 1024;
+    int height = 256;
+    double fps = 500;
+    double jitterUs = 0;  // standard deviation of the frame timing jitter
+    size_t bufferCount = 16;
+    int objectCount = 4;       // number of objects in generated frames
+    double objectSpeed = 4.0;  // pixels per frame
+    unsigned int seed = 0;
+};
+
+// A frame lent to the consumer. image is a header into the simulated DMA buffer bufNr
+struct SimulatedFrame {
+    size_t bufNr;
+    long frameNo;
+    cv::Mat image;
+};
+
+/**
+ * @brief The SimulatedCamera class
+ * @details Software replacement for the framegrabber, used for load testing the acquisition ->
+ * analyzer -> writer pipeline without camera hardware.
+ *
+ * Frames are generated (or replayed, see setReplayFrames) at the configured rate into a fixed ring
+ * of preallocated buffers, mirroring the ACQ_BLOCK DMA scheme used by the Acquisitor: a buffer is
+ * published to the consumer through acquireFrame(), and is not written to again until it has been
+ * returned through releaseFrame().
+ *
+ * Two kinds of frame loss are reported:
+ *  - missed frames: a frame was due, but all buffers were held by the consumer
+ *  - overrun frames: the generator thread itself fell more than one frame period behind
+ */
+class SimulatedCamera {
+public:
+    SimulatedCamera() = default;
+    ~SimulatedCamera();
+
+    void setConfig(const SimulatedCameraConfig& config);
+    SimulatedCameraConfig getConfig() const;
+    void setReplayFrames(const std::vector<cv::Mat>& frames);
+
+    void start();
+    void stop();
+    bool isRunning() const { return m_running; }
+
+    bool acquireFrame(SimulatedFrame& frame, int timeoutMs);
+    void releaseFrame(const SimulatedFrame& frame);
+
+    long generatedFrames() const { return m_generatedFrames; }
+    long missedFrames() const { return m_missedFrames; }
+    long overrunFrames() const { return m_overrunFrames; }
+
+private:
+    void acquisitionThreaded();
+    void renderFrame(cv::Mat& buffer, long frameNo) const;
+
+    struct Published {
+        size_t bufNr;
+        long frameNo;
+    };
+
+    // Configuration is set from the GUI thread while the camera is started from the acquisition
+    // thread
+    mutable std::mutex m_configMutex;
+    SimulatedCameraConfig m_config;
+    std::vector<cv::Mat> m_replayFrames;
+    std::vector<cv::Mat> m_buffers;
+
+    // Generator -> consumer and consumer -> generator rings (single producer, single consumer)
+    moodycamel::BlockingReaderWriterQueue<Published> m_published;
+    moodycamel::ReaderWriterQueue<size_t> m_released;
+
+    std::thread m_thread;
+    std::atomic<bool> m_running{false};
+
+    std::atomic<long> m_generatedFrames{0};
+    std::atomic<long> m_missedFrames{0};
+    std::atomic<long> m_overrunFrames{0};
+};
+
+#endif  // RTOC_SIMULATEDCAMERA_H
@@ -0,0 +1,134 @@
+#include "textexporter.h"
+
+#include <algorithm>
+#include <clocale>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+
+namespace {
+// Largest integral magnitude which %g prints without an exponent
+const double s_maxPlainInteger = 999999.0;
+
+char* formatUnsigned(unsigned long value, char* dst) {
+    char digits[20];
+    int n = 0;
+    do {
+        digits[n++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    while (n > 0) {
+        *dst++ = digits[--n];
+    }
+    return dst;
+}
+}  // namespace
+
+TextExporter::TextExporter(unsigned int threads, size_t chunkTracks)
+    : m_threads(std::max(1u, threads)), m_chunkTracks(std::max<size_t>(1, chunkTracks)) {}
+
+/**
+ * @brief Formats value as std::ostream does by default, ie. printf("%g"), using '.' as the decimal
+ * point regardless of the C locale
+ * @param dst : buffer with room for at least 32 characters
+ * @param decimalPoint : decimal point of the current C locale, which is replaced by '.'
+ * @return end of the formatted value
+ */
+char* TextExporter::formatDouble(double value, char* dst, char decimalPoint) {
+    // Most exported values (coordinates, frame numbers, labels, pixel areas) are small integers,
+    // which %g prints as plain integers
+    const double magnitude = std::fabs(value);
+    if (magnitude <= s_maxPlainInteger && magnitude == std::floor(magnitude)) {
+        if (std::signbit(value)) {
+            *dst++ = '-';
+        }
+        return formatUnsigned(static_cast<unsigned long>(magnitude), dst);
+    }
+
+    char* end = dst + std::snprintf(dst, 32, "%g", value);
+    if (decimalPoint != '.') {
+        std::replace(dst, end, decimalPoint, '.');
+    }
+    return end;
+}
+
+/**
+ * @brief Writes tracks to path
+ * @return true if the file was written successfully
+ */
+bool TextExporter::write(const std::string& path,
+                         const std::vector<std::unique_ptr<DataContainer>>& tracks) const {
+    if (tracks.empty()) {
+        return false;
+    }
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        return false;
+    }
+
+    // Add list of attributes
+    for (const auto& attribute : tracks[0]->extractAttributeName()) {
+        out << attribute << "'";
+    }
+    out << "\n";
+
+    // Add number number of values for chosen attributes
+    for (const auto& value : tracks[0]->extractAttributeLengths()) {
+        out << value << " ";
+    }
+
+    // Add number of containers
+    out << "\n" << tracks.size() << "\n";
+
+    const char decimalPoint = std::localeconv()->decimal_point[0];
+
+    // Chunks are formatted in waves of m_threads chunks, and written in order once a wave is done,
+    // such that at most one wave of formatted text is held in memory
+    std::vector<std::string> chunks(m_threads);
+    for (size_t wave = 0; wave < tracks.size(); wave += m_chunkTracks * m_threads) {
+        std::vector<std::thread> workers;
+        for (unsigned int t = 0; t < m_threads; t++) {
+            const size_t begin = std::min(tracks.size(), wave + t * m_chunkTracks);
+            const size_t end = std::min(tracks.size(), begin + m_chunkTracks);
+            chunks[t].clear();
+            if (begin == end) {
+                break;
+            }
+            workers.emplace_back(&TextExporter::formatTracks, this, std::cref(tracks), begin, end,
+                                 std::ref(chunks[t]), decimalPoint);
+        }
+        for (size_t t = 0; t < workers.size(); t++) {
+            workers[t].join();
+            out.write(chunks[t].data(), chunks[t].size());
+        }
+    }
+    out.close();
+    return !out.fail();
+}
+
+void TextExporter::formatTracks(const std::vector<std::unique_ptr<DataContainer>>& tracks,
+                                size_t begin, size_t end, std::string& out,
+                                char decimalPoint) const {
+    std::vector<double> values;
+    char buffer[64];
+    for (size_t i = begin; i < end; i++) {
+        DataContainer& track = *tracks[i];
+        out.append("Observation");
+        char* p = formatUnsigned(i + 1, buffer);
+        *p++ = ' ';
+        p = formatUnsigned(track.size(), p);
+        *p++ = '\n';
+        out.append(buffer, p);
+
+        for (size_t j = 0; j < track.size(); j++) {
+            track.extractObjectInDoubles(static_cast<int>(j), values);
+            for (const double value : values) {
+                p = formatDouble(value, buffer, decimalPoint);
+                *p++ = ' ';
+                out.append(buffer, p);
+            }
+            out.push_back('\n');
+        }
+    }
+}
@@ -0,0 +1,42 @@
+#ifndef RTOC_TEXTEXPORTER_H
+#define RTOC_TEXTEXPORTER_H
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "datacontainer.h"
+
+/**
+ * @brief The TextExporter class
+ * @details Writes experiment data in the text format read by the parsers in /parsers:
+ *
+ *      attribute names, each terminated by '
+ *      number of values of each attribute, space separated
+ *      number of tracks
+ *      per track:
+ *          Observation<n> <number of objects>
+ *          per object: all values, each followed by a space
+ *
+ * Values are formatted as by std::ostream with default settings (printf %g), such that files are
+ * identical to those of previous versions. Tracks are split into chunks which are formatted
+ * concurrently, and written in order.
+ */
+class TextExporter {
+public:
+    explicit TextExporter(unsigned int threads, size_t chunkTracks = 256);
+
+    bool write(const std::string& path,
+               const std::vector<std::unique_ptr<DataContainer>>& tracks) const;
+
+    static char* formatDouble(double value, char* dst, char decimalPoint = '.');
+
+private:
+    void formatTracks(const std::vector<std::unique_ptr<DataContainer>>& tracks, size_t begin,
+                      size_t end, std::string& out, char decimalPoint) const;
+
+    unsigned int m_threads;
+    size_t m_chunkTracks;
+};
+
+#endif  // RTOC_TEXTEXPORTER_H
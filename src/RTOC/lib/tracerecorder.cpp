@@ -0,0 +1,205 @@
+#include "tracerecorder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+namespace {
+// Buffer of the calling thread, cached for the recorder and recording session it belongs to
+struct ThreadBufferCache {
+    const void* recorder = nullptr;
+    unsigned long session = 0;
+    void* buffer = nullptr;
+};
+thread_local ThreadBufferCache t_cache;
+
+std::string escapeJson(const std::string& s) {
+    std::string out;
+    out.reserve(s.size());
+    for (const char c : s) {
+        switch (c) {
+            case '"':
+                out += "\\\"";
+                break;
+            case '\\':
+                out += "\\\\";
+                break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char escaped[8];
+                    std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+                    out += escaped;
+                } else {
+                    out += c;
+                }
+        }
+    }
+    return out;
+}
+
+// Formats a value with three decimals, independent of the C locale
+std::string formatFixed(double value) {
+    const long long thousandths = std::llround(value * 1000.0);
+    const unsigned long long magnitude =
+        static_cast<unsigned long long>(thousandths < 0 ? -thousandths : thousandths);
+    char buffer[32];
+    std::snprintf(buffer, sizeof(buffer), "%s%llu.%03llu", thousandths < 0 ? "-" : "",
+                  magnitude / 1000, magnitude % 1000);
+    return buffer;
+}
+}  // namespace
+
+std::atomic<unsigned long> TraceRecorder::s_nextSession{1};
+
+TraceRecorder::TraceRecorder(size_t eventsPerThread)
+    : m_eventsPerThread(std::max<size_t>(1, eventsPerThread)), m_origin(Clock::now()) {}
+
+/**
+ * @brief Discards all recorded events and starts recording. Timestamps are relative to this call
+ */
+void TraceRecorder::start() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_buffers.clear();
+    m_origin = Clock::now();
+    m_session = s_nextSession++;
+    m_enabled.store(true, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Returns a copy of name which is valid for the lifetime of the recorder
+ */
+const char* TraceRecorder::internName(const std::string& name) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& interned : m_names) {
+        if (interned == name) {
+            return interned.c_str();
+        }
+    }
+    m_names.push_back(name);
+    return m_names.back().c_str();
+}
+
+/**
+ * @brief Names the timeline of the calling thread. Has no effect if the recorder is disabled
+ */
+void TraceRecorder::setThreadName(const std::string& name) {
+    if (!enabled()) {
+        return;
+    }
+    ThreadBuffer& buffer = threadBuffer();
+    std::lock_guard<std::mutex> lock(m_mutex);
+    buffer.name = name;
+}
+
+TraceRecorder::ThreadBuffer& TraceRecorder::threadBuffer() {
+    const unsigned long session = m_session.load(std::memory_order_relaxed);
+    if (t_cache.recorder == this && t_cache.session == session) {
+        return *static_cast<ThreadBuffer*>(t_cache.buffer);
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    const std::thread::id thisThread = std::this_thread::get_id();
+    ThreadBuffer* buffer = nullptr;
+    for (auto& candidate : m_buffers) {
+        if (candidate->thread == thisThread) {
+            buffer = candidate.get();
+        }
+    }
+    if (!buffer) {
+        m_buffers.emplace_back(new ThreadBuffer());
+        buffer = m_buffers.back().get();
+        buffer->thread = thisThread;
+        buffer->id = static_cast<unsigned int>(m_buffers.size());
+        buffer->name = "Thread " + std::to_string(buffer->id);
+        buffer->events.resize(m_eventsPerThread);
+    }
+    t_cache.recorder = this;
+    t_cache.session = session;
+    t_cache.buffer = buffer;
+    return *buffer;
+}
+
+void TraceRecorder::push(const Event& event) {
+    ThreadBuffer& buffer = threadBuffer();
+    buffer.events[buffer.next % buffer.events.size()] = event;
+    buffer.next++;
+}
+
+size_t TraceRecorder::eventCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t count = 0;
+    for (const auto& buffer : m_buffers) {
+        count += std::min(buffer->next, buffer->events.size());
+    }
+    return count;
+}
+
+/**
+ * @brief Writes all recorded events to path in the Chrome trace event JSON format
+ * @return true if the file was written successfully
+ */
+bool TraceRecorder::write(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out.is_open()) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    auto separator = [&first, &out] {
+        if (!first) {
+            out << ",\n";
+        }
+        first = false;
+    };
+
+    for (const auto& buffer : m_buffers) {
+        const std::string tid = std::to_string(buffer->id);
+        separator();
+        out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+            << ",\"args\":{\"name\":\"" << escapeJson(buffer->name) << "\"}}";
+
+        // Oldest event first. If the ring buffer has wrapped, the oldest event is the next to be
+        // overwritten
+        const size_t size = buffer->events.size();
+        const size_t count = std::min(buffer->next, size);
+        for (size_t i = buffer->next - count; i < buffer->next; i++) {
+            const Event& e = buffer->events[i % size];
+            const std::string name = escapeJson(e.name);
+            switch (e.phase) {
+                case Phase::Span: {
+                    separator();
+                    out << "{\"name\":\"" << name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+                        << ",\"ts\":" << formatFixed(e.begin)
+                        << ",\"dur\":" << formatFixed(e.end - e.begin)
+                        << ",\"args\":{\"frame\":" << e.frame << "}}";
+                    break;
+                }
+                case Phase::Wait: {
+                    // Asynchronous begin/end pair, identified by the frame
+                    separator();
+                    out << "{\"name\":\"" << name << "\",\"cat\":\"queue\",\"ph\":\"b\",\"id\":"
+                        << e.frame << ",\"pid\":1,\"tid\":" << tid
+                        << ",\"ts\":" << formatFixed(e.begin) << "}";
+                    separator();
+                    out << "{\"name\":\"" << name << "\",\"cat\":\"queue\",\"ph\":\"e\",\"id\":"
+                        << e.frame << ",\"pid\":1,\"tid\":" << tid
+                        << ",\"ts\":" << formatFixed(e.end) << "}";
+                    break;
+                }
+                case Phase::Counter: {
+                    separator();
+                    out << "{\"name\":\"" << name << "\",\"ph\":\"C\",\"pid\":1,\"tid\":" << tid
+                        << ",\"ts\":" << formatFixed(e.begin) << ",\"args\":{\"value\":"
+                        << formatFixed(e.end) << "}}";
+                    break;
+                }
+            }
+        }
+    }
+    out << "\n]}\n";
+    out.close();
+    return !out.fail();
+}
@@ -0,0 +1,129 @@
+#ifndef RTOC_TRACERECORDER_H
+#define RTOC_TRACERECORDER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief The TraceRecorder class
+ * @details Records a timeline of the analyzer pipeline, which is written in the Chrome trace event
+ * format (chrome://tracing, https://ui.perfetto.dev).
+ *
+ * Three kinds of events are recorded:
+ *  - spans: a stage executed by a thread for a frame, eg. a process of the process chain
+ *  - waits: the time a frame spent in a queue, shown as an asynchronous span per frame
+ *  - counters: a sampled value, eg. the depth of a queue
+ *
+ * Each thread records into its own ring buffer, such that recording is lock-free once a thread has
+ * registered its buffer on its first event. When a ring buffer is full, the oldest events of the
+ * thread are overwritten. Recording is a single relaxed load when the recorder is disabled.
+ *
+ * Event names are not copied, and must outlive the recorder - ie. string literals, or names
+ * returned by internName().
+ *
+ * start() and write() must not be called while other threads are recording.
+ */
+class TraceRecorder {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    explicit TraceRecorder(size_t eventsPerThread = 1 << 16);
+
+    void start();
+    void stop() { m_enabled.store(false, std::memory_order_relaxed); }
+    bool enabled() const { return m_enabled.load(std::memory_order_relaxed); }
+
+    const char* internName(const std::string& name);
+    void setThreadName(const std::string& name);
+
+    void span(const char* name, long frame, Clock::time_point begin, Clock::time_point end) {
+        if (enabled()) {
+            push({name, toUs(begin), toUs(end), frame, Phase::Span});
+        }
+    }
+    void wait(const char* name, long frame, Clock::time_point begin, Clock::time_point end) {
+        if (enabled()) {
+            push({name, toUs(begin), toUs(end), frame, Phase::Wait});
+        }
+    }
+    void counter(const char* name, double value) {
+        if (enabled()) {
+            push({name, toUs(Clock::now()), value, -1, Phase::Counter});
+        }
+    }
+
+    bool write(const std::string& path) const;
+    size_t eventCount() const;
+
+private:
+    enum class Phase : char { Span, Wait, Counter };
+
+    struct Event {
+        const char* name;
+        double begin;  // µs since start()
+        double end;    // µs since start() - or the value of a counter
+        long frame;
+        Phase phase;
+    };
+
+    struct ThreadBuffer {
+        std::thread::id thread;
+        std::string name;
+        unsigned int id;  // thread id in the trace
+        std::vector<Event> events;
+        size_t next = 0;  // total number of events pushed; events[next % size] is written next
+    };
+
+    double toUs(Clock::time_point t) const {
+        return std::chrono::duration<double, std::micro>(t - m_origin).count();
+    }
+
+    void push(const Event& event);
+    ThreadBuffer& threadBuffer();
+
+    std::atomic<bool> m_enabled{false};
+    size_t m_eventsPerThread;
+    Clock::time_point m_origin;
+    // Set by start() to a value unique across all recorders, such that threads register a new
+    // buffer for each recording
+    std::atomic<unsigned long> m_session{0};
+    static std::atomic<unsigned long> s_nextSession;
+
+    mutable std::mutex m_mutex;  // guards registration of thread buffers and names
+    std::vector<std::unique_ptr<ThreadBuffer>> m_buffers;
+    std::deque<std::string> m_names;  // deque, such that interned names are never relocated
+};
+
+/**
+ * @brief Records a span from construction until destruction
+ */
+class TraceSpan {
+public:
+    TraceSpan(TraceRecorder& recorder, const char* name, long frame)
+        : m_recorder(recorder),
+          m_name(name),
+          m_frame(frame),
+          m_active(recorder.enabled()),
+          m_begin(m_active ? TraceRecorder::Clock::now() : TraceRecorder::Clock::time_point()) {}
+    ~TraceSpan() {
+        if (m_active) {
+            m_recorder.span(m_name, m_frame, m_begin, TraceRecorder::Clock::now());
+        }
+    }
+
+private:
+    TraceRecorder& m_recorder;
+    const char* m_name;
+    long m_frame;
+    bool m_active;
+    TraceRecorder::Clock::time_point m_begin;
+};
+
+#endif  // RTOC_TRACERECORDER_H
@@ -0,0 +1,211 @@
+#include "catch.hpp"
+
+#include "../lib/analyzer.h"
+#include "../lib/batchrunner.h"
+#include "../lib/batchscheduler.h"
+#include "../lib/flowgenerator.h"
+
+#include <boost/filesystem.hpp>
+
+namespace {
+namespace fs = boost::filesystem;
+
+Setup batchSetup(const std::string& outputPath) {
+    Setup setup;
+    setup.runProcessing = true;
+    setup.extractData = true;
+    setup.storeRaw = false;
+    setup.storeProcessed = true;
+    setup.storeImagesDuringExperiment = true;
+    setup.countThreshold = 3;
+    setup.distanceThresholdInlet = 12;
+    setup.distanceThresholdPath = 12;
+    setup.dataFlags = data::AllFlags;
+    setup.conditionFlags = 0;
+    setup.inlet = {32, 224};
+    setup.outlet = {32, 224};
+    setup.rawPrefix = "raw";
+    setup.processedPrefix = "processed";
+    setup.outputPath = outputPath;
+    setup.experimentName = "batch";
+    setup.exportFormat = ExportFormat::Binary;
+    return setup;
+}
+
+/**
+ * @brief Writes a recorded experiment, a process preset and an experiment setup to root, and
+ * returns a job analyzing them
+ */
+BatchJob writeBatchInput(const fs::path& root) {
+    fs::remove_all(root);
+    fs::create_directories(root / "images");
+
+    // A recorded experiment: the empty channel followed by a flow of cells
+    FlowGeneratorConfig flow;
+    flow.width = 256;
+    flow.height = 64;
+    flow.inlet = {32, 224};
+    flow.outlet = {32, 224};
+    flow.density = 3;
+    flow.majorAxisMin = 8;
+    flow.majorAxisMax = 12;
+    FlowGenerator generator(flow);
+    cv::imwrite((root / "images" / "raw_0.png").string(), generator.background());
+    for (long i = 0; i < 40; i++) {
+        cv::Mat frame;
+        generator.render(i, frame);
+        cv::imwrite((root / "images" / ("raw_" + std::to_string(i + 1) + ".png")).string(),
+                    frame);
+    }
+
+    Analyzer presetAnalyzer;
+    processContainerPtr processes = presetAnalyzer.getProcessContainerPtr();
+    processes->emplace_back(new SubtractBG());
+    auto binarize = new Binarize();
+    binarize->m_edgeThreshold.setValue(30);
+    processes->emplace_back(binarize);
+    processes->emplace_back(new FloodFillProcess());
+    REQUIRE(presetAnalyzer.storeSetup((root / "preset.xml").string()));
+    REQUIRE(storeExperimentSetup(batchSetup((root / "output").string()),
+                                 (root / "setup.xml").string()));
+
+    BatchJob job;
+    job.presetPath = (root / "preset.xml").string();
+    job.setupPath = (root / "setup.xml").string();
+    job.inputPath = (root / "images").string();
+    job.prefetchThreads = 2;
+    return job;
+}
+}  // namespace
+
+TEST_CASE("Experiment setup serialization", "[full], [batchrunner]") {
+    Setup setup = batchSetup("./output");
+    setup.classifyObjects = true;
+    setup.modelPath = "./model.txt";
+    setup.earlyDecisionMargin = 0.25;
+    const std::string path = "./setup_roundtrip.xml";
+    REQUIRE(storeExperimentSetup(setup, path));
+
+    Setup loaded;
+    REQUIRE(loadExperimentSetup(path, loaded));
+    CHECK(loaded.outlet == setup.outlet);
+    CHECK(loaded.experimentName == setup.experimentName);
+    CHECK(loaded.exportFormat == ExportFormat::Binary);
+    CHECK(loaded.classifyObjects);
+    CHECK(loaded.modelPath == setup.modelPath);
+    CHECK(loaded.earlyDecisionMargin == setup.earlyDecisionMargin);
+
+    CHECK(!loadExperimentSetup("./does_not_exist.xml", loaded));
+    fs::remove(path);
+}
+
+TEST_CASE("Batch runner", "[full], [batchrunner]") {
+    const fs::path root = "./batchrunner";
+    BatchJob job = writeBatchInput(root);
+
+    SECTION("an image folder is analyzed and exported") {
+        const BatchResult result = runBatchJob(job);
+        INFO(result.error);
+        REQUIRE(result.success);
+        CHECK(result.frames == 41);
+        CHECK(result.experimentFolder == (root / "output" / "batch").string());
+        CHECK(fs::exists(root / "output" / "batch" / "batch.rtoc"));
+        CHECK(fs::exists(root / "output" / "batch" / "processed"));
+
+        // Existing experiments are not overwritten by default
+        const BatchResult again = runBatchJob(job);
+        CHECK(!again.success);
+        job.overwrite = true;
+        CHECK(runBatchJob(job).success);
+    }
+    SECTION("the recording time of the setup does not cut the analysis short") {
+        Setup setup = batchSetup((root / "output").string());
+        setup.recordingTime = 1;
+        REQUIRE(storeExperimentSetup(setup, job.setupPath));
+        const BatchResult result = runBatchJob(job);
+        INFO(result.error);
+        REQUIRE(result.success);
+        CHECK(result.frames == 41);
+    }
+    SECTION("the experiment name and output path can be overridden") {
+        job.outputPath = (root / "other").string();
+        job.experimentName = "renamed";
+        REQUIRE(runBatchJob(job).success);
+        CHECK(fs::exists(root / "other" / "renamed" / "renamed.rtoc"));
+    }
+    SECTION("errors are reported") {
+        job.inputPath = (root / "missing").string();
+        BatchResult result = runBatchJob(job);
+        CHECK(!result.success);
+        CHECK(result.error.find("input") != std::string::npos);
+
+        job.inputPath = (root / "images").string();
+        job.setupPath = (root / "missing.xml").string();
+        result = runBatchJob(job);
+        CHECK(!result.success);
+        CHECK(result.error.find("setup") != std::string::npos);
+    }
+    fs::remove_all(root);
+}
+
+TEST_CASE("Batch scheduler", "[full], [batchrunner]") {
+    const fs::path root = "./batchscheduler";
+    BatchJob job = writeBatchInput(root);
+    job.prefetchThreads = 0;
+
+    BatchSchedulerConfig config;
+    config.threads = 4;
+    config.maxConcurrentJobs = 2;
+
+    SECTION("experiments are analyzed concurrently into separate folders") {
+        BatchScheduler scheduler(config);
+        for (const std::string name : {"a", "b", "c"}) {
+            job.experimentName = name;
+            scheduler.addJob(job);
+        }
+        // Writes to the experiment folder of the first job
+        job.experimentName = "a";
+        scheduler.addJob(job);
+
+        std::vector<size_t> finished;
+        scheduler.setProgressCallback(
+            [&finished](size_t index, const BatchResult&) { finished.push_back(index); });
+        const std::vector<BatchResult> results = scheduler.run();
+        REQUIRE(results.size() == 4);
+        for (size_t i = 0; i < 3; i++) {
+            INFO(results[i].error);
+            CHECK(results[i].success);
+            CHECK(results[i].frames == 41);
+        }
+        for (const std::string name : {"a", "b", "c"}) {
+            CHECK(fs::exists(root / "output" / name / (name + ".rtoc")));
+        }
+        CHECK(!results[3].success);
+        CHECK(results[3].error.find("also written by job 0") != std::string::npos);
+        CHECK(finished.size() == 4);
+        CHECK(scheduler.peakConcurrentJobs() <= 2);
+    }
+    SECTION("the memory budget limits the concurrent experiments") {
+        const size_t memory = estimateBatchJobMemory(job);
+        // The queues of the setup are unbounded, such that every frame may be held
+        REQUIRE(memory >= 41 * 256 * 64);
+        job.queueCapacity = 4;
+        const size_t boundedMemory = estimateBatchJobMemory(job);
+        REQUIRE(boundedMemory > 0);
+        REQUIRE(boundedMemory < memory);
+
+        config.memoryBudget = boundedMemory + boundedMemory / 2;
+        config.queueCapacity = 4;
+        BatchScheduler scheduler(config);
+        for (const std::string name : {"a", "b", "c"}) {
+            job.experimentName = name;
+            scheduler.addJob(job);
+        }
+        for (const auto& result : scheduler.run()) {
+            CHECK(result.success);
+        }
+        CHECK(scheduler.peakConcurrentJobs() == 1);
+        CHECK(scheduler.peakMemory() == boundedMemory);
+    }
+    fs::remove_all(root);
+}
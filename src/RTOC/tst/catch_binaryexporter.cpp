@@ -0,0 +1,77 @@
+#include "catch.hpp"
+
+#include "../lib/binaryexporter.h"
+
+#include <cstdio>
+#include <cstring>
+
+TEST_CASE("BinaryExporter file layout", "[full], [binaryexporter]") {
+    const unsigned long flags = data::Area | data::Centroid | data::Frame;
+    std::vector<std::unique_ptr<DataContainer>> tracks;
+    for (int i = 0; i < 3; i++) {
+        tracks.emplace_back(new DataContainer(flags));
+        for (int j = 0; j <= i; j++) {
+            DataObject* object = tracks.back()->appendNew();
+            object->setValue(data::Area, 10.0 * i + j);
+            object->setValue(data::Centroid, cv::Point(i, j));
+            object->setValue(data::Frame, j);
+        }
+    }
+
+    BinaryExporter exporter;
+    REQUIRE(exporter.open("./binaryexporter_test.rtoc", flags));
+    REQUIRE(exporter.writeBlock(tracks, 0, 2));
+    REQUIRE(exporter.writeBlock(tracks, 2, 3));
+    REQUIRE(exporter.trackCount() == 3);
+    REQUIRE(exporter.objectCount() == 6);
+    REQUIRE(exporter.close());
+
+    std::ifstream in("./binaryexporter_test.rtoc", std::ios::binary);
+    std::vector<char> file((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    REQUIRE(std::memcmp(file.data(), "RTOCBIN\0", 8) == 0);
+
+    uint64_t trailerOffset;
+    std::memcpy(&trailerOffset, file.data() + file.size() - 8, 8);
+    REQUIRE(std::memcmp(file.data() + trailerOffset, "RTOCEND\0", 8) == 0);
+
+    uint64_t nBlocks, firstBlock;
+    std::memcpy(&nBlocks, file.data() + trailerOffset + 8, 8);
+    std::memcpy(&firstBlock, file.data() + trailerOffset + 16, 8);
+    REQUIRE(nBlocks == 2);
+
+    // First block: tracks 0 and 1, holding 1 + 2 objects. Area is the first column
+    const char* block = file.data() + firstBlock;
+    uint64_t nTracks, nObjects;
+    std::memcpy(&nTracks, block + 4, 8);
+    std::memcpy(&nObjects, block + 12, 8);
+    REQUIRE(nTracks == 2);
+    REQUIRE(nObjects == 3);
+    double areas[3];
+    std::memcpy(areas, block + 20 + (nTracks + 1) * 8, sizeof(areas));
+    REQUIRE(areas[0] == 0.0);
+    REQUIRE(areas[1] == 10.0);
+    REQUIRE(areas[2] == 11.0);
+
+    std::remove("./binaryexporter_test.rtoc");
+}
+
+TEST_CASE("BinaryExporter skips released tracks", "[full], [binaryexporter]") {
+    std::vector<std::unique_ptr<DataContainer>> tracks;
+    for (int i = 0; i < 4; i++) {
+        tracks.emplace_back(new DataContainer(data::Area));
+        tracks.back()->appendNew()->setValue(data::Area, (double) i);
+    }
+    BinaryExporter exporter;
+    REQUIRE(exporter.open("./binaryexporter_stream.rtoc", data::Area));
+
+    // Stream track 1 as it closes, and release it as done by the ObjectFinder
+    REQUIRE(exporter.writeBlock(std::vector<DataContainer*>{tracks[1].get()}));
+    tracks[1].reset();
+    REQUIRE(exporter.writeBlock(tracks, 0, tracks.size()));
+    REQUIRE(exporter.trackCount() == 4);
+    REQUIRE(exporter.objectCount() == 4);
+    REQUIRE(exporter.close());
+    REQUIRE_FALSE(exporter.isOpen());
+
+    std::remove("./binaryexporter_stream.rtoc");
+}
@@ -0,0 +1,68 @@
+#include "catch.hpp"
+
+#include "../lib/boundedqueue.h"
+
+#include <thread>
+
+TEST_CASE("BoundedQueue policies", "[full], [boundedqueue]") {
+    SECTION("unbounded queue never drops") {
+        BoundedQueue<int> q;
+        for (int i = 0; i < 1000; i++) {
+            REQUIRE(q.enqueue(i));
+        }
+        REQUIRE(q.size_approx() == 1000);
+        REQUIRE(q.droppedCount() == 0);
+    }
+    SECTION("drop newest") {
+        BoundedQueue<int> q(3, QueuePolicy::DropNewest);
+        for (int i = 0; i < 5; i++) {
+            q.enqueue(i);
+        }
+        REQUIRE(q.size_approx() == 3);
+        REQUIRE(q.droppedCount() == 2);
+        int v;
+        REQUIRE(q.try_dequeue(v));
+        REQUIRE(v == 0);
+    }
+    SECTION("drop oldest") {
+        BoundedQueue<int> q(3, QueuePolicy::DropOldest);
+        for (int i = 0; i < 5; i++) {
+            q.enqueue(i);
+        }
+        REQUIRE(q.size_approx() == 3);
+        REQUIRE(q.droppedCount() == 2);
+        int v;
+        REQUIRE(q.try_dequeue(v));
+        REQUIRE(v == 2);
+    }
+    SECTION("block releases producer when consumer dequeues") {
+        BoundedQueue<int> q(1, QueuePolicy::Block);
+        q.enqueue(0);
+        std::thread producer([&q] { q.enqueue(1); });
+        int v;
+        q.wait_dequeue(v);
+        REQUIRE(v == 0);
+        producer.join();
+        REQUIRE(q.try_dequeue(v));
+        REQUIRE(v == 1);
+        REQUIRE(q.droppedCount() == 0);
+    }
+    SECTION("abort releases a blocked producer") {
+        BoundedQueue<int> q(1, QueuePolicy::Block);
+        q.enqueue(0);
+        std::thread producer([&q] { q.enqueue(1); });
+        q.abort();
+        producer.join();
+        REQUIRE(q.droppedCount() == 1);
+    }
+    SECTION("clear keeps drop count") {
+        BoundedQueue<int> q(1, QueuePolicy::DropNewest);
+        q.enqueue(0);
+        q.enqueue(1);
+        q.clear();
+        REQUIRE(q.size_approx() == 0);
+        REQUIRE(q.droppedCount() == 1);
+        q.resetDroppedCount();
+        REQUIRE(q.droppedCount() == 0);
+    }
+}
@@ -0,0 +1,183 @@
+#include "catch.hpp"
+
+#include "../lib/flowgenerator.h"
+
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <string>
+
+namespace {
+FlowGeneratorConfig testConfig() {
+    FlowGeneratorConfig config;
+    config.width = 512;
+    config.height = 128;
+    // Straight inlet and outlet lines at x = 64 and x = 448
+    config.inlet = {64, 448};
+    config.outlet = {64, 448};
+    config.density = 4;
+    config.speed = 4;
+    config.noise = 0;
+    config.seed = 7;
+    return config;
+}
+}  // namespace
+
+TEST_CASE("FlowGenerator ground truth", "[full], [flowgenerator]") {
+    FlowGeneratorConfig config = testConfig();
+
+    SECTION("ground truth only depends on the configuration and the frame number") {
+        FlowGenerator a(config);
+        FlowGenerator b(config);
+        b.groundTruth(200);
+        const auto truthA = a.groundTruth(50);
+        const auto truthB = b.groundTruth(50);
+        REQUIRE(!truthA.empty());
+        REQUIRE(truthA.size() == truthB.size());
+        for (size_t i = 0; i < truthA.size(); i++) {
+            CHECK(truthA[i].cell == truthB[i].cell);
+            CHECK(truthA[i].centroid.x == truthB[i].centroid.x);
+            CHECK(truthA[i].centroid.y == truthB[i].centroid.y);
+        }
+    }
+    SECTION("cells flow from the inlet to the outlet") {
+        FlowGenerator generator(config);
+        std::map<long, std::vector<FlowObject>> tracks;
+        for (long frame = 0; frame < 600; frame++) {
+            for (const auto& object : generator.groundTruth(frame)) {
+                tracks[object.cell].push_back(object);
+            }
+        }
+        int crossed = 0;
+        for (const auto& track : tracks) {
+            const auto& objects = track.second;
+            for (size_t i = 1; i < objects.size(); i++) {
+                CHECK(std::abs(objects[i].centroid.x - objects[i - 1].centroid.x - 4) < 1e-9);
+                CHECK(objects[i].centroid.y == objects[i - 1].centroid.y);
+                CHECK(objects[i].outletXpos == objects[i].inletXpos - 384);
+            }
+            if (objects.front().inletXpos < 0 && objects.back().outletXpos > 0) {
+                crossed++;
+            }
+        }
+        REQUIRE(crossed > 5);
+    }
+    SECTION("consecutive cells keep the minimum spacing") {
+        config.minSpacing = 1.5;
+        config.density = 10;
+        FlowGenerator spaced(config);
+        for (long frame = 0; frame < 300; frame++) {
+            for (const auto& object : spaced.groundTruth(frame)) {
+                REQUIRE(!object.overlapping);
+            }
+        }
+
+        config.minSpacing = 0;
+        config.density = 40;
+        FlowGenerator dense(config);
+        int overlapping = 0;
+        for (long frame = 0; frame < 300; frame++) {
+            for (const auto& object : dense.groundTruth(frame)) {
+                overlapping += object.overlapping;
+            }
+        }
+        REQUIRE(overlapping > 0);
+    }
+    SECTION("periodic flows repeat") {
+        config.period = 100;
+        FlowGenerator generator(config);
+        for (long frame : {0, 17, 99}) {
+            const auto first = generator.groundTruth(frame);
+            const auto next = generator.groundTruth(frame + config.period);
+            REQUIRE(first.size() == next.size());
+            for (size_t i = 0; i < first.size(); i++) {
+                CHECK(first[i].centroid.x == Approx(next[i].centroid.x));
+                CHECK(first[i].centroid.y == Approx(next[i].centroid.y));
+                CHECK(first[i].cell != next[i].cell);
+            }
+        }
+    }
+    SECTION("cells flow perpendicular to slanted inlet and outlet lines") {
+        config.inlet = {100, 20};
+        config.outlet = {400, 100};
+        FlowGenerator generator(config);
+        std::map<long, std::vector<double>> xpos;
+        for (long frame = 0; frame < 100; frame++) {
+            for (const auto& object : generator.groundTruth(frame)) {
+                xpos[object.cell].push_back(object.inletXpos);
+            }
+        }
+        REQUIRE(!xpos.empty());
+        for (const auto& track : xpos) {
+            // Centroids are rounded to pixels before the distance to the line is computed
+            for (size_t i = 1; i < track.second.size(); i++) {
+                CHECK(track.second[i] - track.second[i - 1] == Approx(4).margin(1.5));
+            }
+        }
+    }
+    SECTION("ground truth is written as CSV") {
+        FlowGenerator generator(config);
+        size_t rows = 0;
+        for (long frame = 0; frame < 20; frame++) {
+            rows += generator.groundTruth(frame).size();
+        }
+        const std::string path = "./flowgenerator_truth.csv";
+        REQUIRE(generator.writeGroundTruth(path, 20));
+        std::ifstream in(path);
+        std::string line;
+        size_t lines = 0;
+        while (std::getline(in, line)) {
+            lines++;
+        }
+        in.close();
+        std::remove(path.c_str());
+        REQUIRE(lines == rows + 1);
+    }
+}
+
+TEST_CASE("FlowGenerator rendering", "[full], [flowgenerator]") {
+    FlowGeneratorConfig config = testConfig();
+    config.minSpacing = 2;
+    FlowGenerator generator(config);
+
+    SECTION("regionProps finds the rendered cells") {
+        for (long frame : {10, 100}) {
+            cv::Mat img;
+            generator.render(frame, img);
+            cv::Mat diff;
+            cv::subtract(generator.background(), img, diff);
+            cv::Mat binary = diff > 40;
+
+            DataContainer output(0xffff);
+            const int found = mathlab::regionProps(binary, data::Centroid | data::Area, output);
+            const auto truth = generator.groundTruth(frame);
+            // Cells at the border of the frame may not cover any pixel
+            REQUIRE(found <= static_cast<int>(truth.size()));
+            for (const auto& object : truth) {
+                if (object.clipped) {
+                    continue;
+                }
+                bool matched = false;
+                for (int i = 0; i < found; i++) {
+                    const cv::Point centroid = output[i]->getValue<cv::Point>(data::Centroid);
+                    if (std::abs(centroid.x - object.centroid.x) <= 1.5 &&
+                        std::abs(centroid.y - object.centroid.y) <= 1.5) {
+                        matched = true;
+                        CHECK(output[i]->getValue<double>(data::Area) ==
+                              Approx(object.area).epsilon(0.35));
+                    }
+                }
+                CHECK(matched);
+            }
+        }
+    }
+    SECTION("rendering is deterministic") {
+        config.noise = 5;
+        FlowGenerator noisy(config);
+        cv::Mat a, b;
+        noisy.render(42, a);
+        noisy.render(43, b);
+        noisy.render(42, b);
+        REQUIRE(cv::countNonZero(a != b) == 0);
+    }
+}
@@ -0,0 +1,86 @@
+#include "catch.hpp"
+
+#include "../lib/framecache.h"
+
+#include <opencv2/imgcodecs.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+namespace {
+// Waits until the worker has decoded all frames of the window
+bool waitForFrames(const FrameCache& cache, size_t first, size_t last) {
+    for (int attempt = 0; attempt < 500; attempt++) {
+        bool cached = true;
+        for (size_t i = first; i <= last; i++) {
+            cached &= cache.contains(i);
+        }
+        if (cached) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+}  // namespace
+
+TEST_CASE("FrameCache prefetches around the position", "[full], [framecache]") {
+    // Encode the file index into the pixel value of each image
+    std::vector<std::string> files;
+    for (int i = 0; i < 40; i++) {
+        std::string file = "./framecache_test_" + std::to_string(i) + ".png";
+        cv::imwrite(file, cv::Mat(16, 32, CV_8UC1, cv::Scalar(i)));
+        files.push_back(file);
+    }
+    const size_t frameBytes = 16 * 32;
+
+    FrameCache cache;
+    FrameCacheConfig config;
+    config.memoryBudget = 12 * frameBytes;
+    config.lookahead = 6;
+    config.lookbehind = 2;
+    cache.setConfig(config);
+    cache.setFiles(files);
+
+    SECTION("frames are decoded along the direction of movement") {
+        cache.setPosition(10);
+        REQUIRE(waitForFrames(cache, 8, 16));
+        CHECK(!cache.contains(17));
+        cv::Mat frame;
+        REQUIRE(cache.frame(16, frame));
+        CHECK(frame.at<uchar>(0, 0) == 16);
+
+        cache.setPosition(30, -1);
+        REQUIRE(waitForFrames(cache, 24, 32));
+        CHECK(!cache.contains(23));
+        CHECK(cache.stats().memory <= config.memoryBudget);
+        CHECK(cache.stats().evicted > 0);
+    }
+    SECTION("missing frames are decoded by readFrame") {
+        cv::Mat frame;
+        CHECK(!cache.frame(3, frame));
+        REQUIRE(cache.readFrame(3, frame));
+        CHECK(frame.at<uchar>(0, 0) == 3);
+        CHECK(cache.frame(3, frame));
+        CHECK(cache.stats().hits == 1);
+        CHECK(!cache.readFrame(40, frame));
+    }
+    SECTION("thumbnails are bounded by the configured size") {
+        config.thumbnailWidth = 8;
+        config.thumbnailHeight = 8;
+        config.keepFrames = false;
+        cache.setConfig(config);
+        cache.setPosition(0);
+        REQUIRE(waitForFrames(cache, 0, 6));
+        cv::Mat thumbnail;
+        REQUIRE(cache.thumbnail(0, thumbnail));
+        CHECK(thumbnail.cols == 8);
+        CHECK(thumbnail.rows == 4);
+        CHECK(!cache.frame(0, thumbnail));
+    }
+
+    for (const auto& file : files) {
+        std::remove(file.c_str());
+    }
+}
@@ -2,6 +2,8 @@
 
 #include "../lib/framefinder.h"
 
+#include <cstdio>
+
 TEST_CASE("exists()", "[full], [framefinder]") {
     SECTION("basic operation") {
         REQUIRE(framefinder::exists("./Makefile"));
@@ -55,3 +57,67 @@ TEST_CASE("framefinder::extractBetween", "[full], [framefinder]") {
     }
 }
 
+
+TEST_CASE("framefinder::hasChanged", "[full], [framefinder]") {
+    cv::Mat a(480, 640, CV_8UC1, cv::Scalar(100));
+    cv::Mat b = a.clone();
+    SECTION("identical images") {
+        REQUIRE(!framefinder::hasChanged(a, b, 0));
+    }
+    SECTION("difference in either direction") {
+        b.at<uchar>(300, 633) = 111;
+        REQUIRE(framefinder::hasChanged(a, b, 10));
+        REQUIRE(framefinder::hasChanged(b, a, 10));
+        REQUIRE(!framefinder::hasChanged(a, b, 11));
+    }
+    SECTION("roi and subsampling") {
+        b.at<uchar>(10, 11) = 200;
+        REQUIRE(!framefinder::hasChanged(a, b, 10, cv::Rect(100, 100, 200, 200)));
+        REQUIRE(framefinder::hasChanged(a, b, 10, cv::Rect(0, 0, 20, 20)));
+        REQUIRE(!framefinder::hasChanged(a, b, 10, cv::Rect(0, 0, 640, 480), 2));
+        b.at<uchar>(10, 10) = 200;
+        REQUIRE(framefinder::hasChanged(a, b, 10, cv::Rect(0, 0, 640, 480), 2));
+    }
+}
+
+TEST_CASE("framefinder::accept_or_reject", "[full], [framefinder]") {
+    // Frames 0-4 static, 5 moves, 6-9 static, 10-24 static with noise, 25-29 drift slowly
+    const std::string folder = ".";
+    std::vector<framefinder::Frame> frames;
+    for (int i = 0; i < 30; i++) {
+        int value = i < 5 ? 100 : 150;
+        if (i >= 10 && i < 25) {
+            value += i % 2 ? 3 : -3;
+        } else if (i >= 25) {
+            value += 4 * (i - 24);
+        }
+        std::string filename = "ff_test_" + std::to_string(i) + ".png";
+        cv::imwrite(folder + "/" + filename, cv::Mat(16, 16, CV_8UC1, cv::Scalar(value)));
+        frames.push_back({cv::Mat(), filename, i, false});
+    }
+
+    framefinder::accept_or_reject(frames, folder, 10, 3);
+
+    std::vector<int> accepted;
+    for (const auto& f : frames) {
+        REQUIRE(f.image.empty());
+        if (f.accepted) {
+            accepted.push_back(f.id);
+        }
+    }
+    // Slow drift is accepted once it differs from the last accepted frame by more than the
+    // threshold, while noise around a static scene is not
+    REQUIRE(accepted == std::vector<int>{0, 5, 27});
+
+    REQUIRE(framefinder::write_frame_lists(frames, "./ff_accepted.txt", "./ff_rejected.txt"));
+    std::vector<std::string> list;
+    REQUIRE(framefinder::read_frame_list("./ff_accepted.txt", list));
+    REQUIRE(list.size() == 3);
+    REQUIRE(list[1] == "ff_test_5.png");
+
+    for (const auto& f : frames) {
+        std::remove((folder + "/" + f.filename).c_str());
+    }
+    std::remove("./ff_accepted.txt");
+    std::remove("./ff_rejected.txt");
+}
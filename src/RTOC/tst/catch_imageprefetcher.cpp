@@ -0,0 +1,50 @@
+#include "catch.hpp"
+
+#include "../lib/imageprefetcher.h"
+
+#include <opencv2/imgcodecs.hpp>
+
+#include <cstdio>
+
+TEST_CASE("ImagePrefetcher delivers images in order", "[full], [imageprefetcher]") {
+    // Encode the file index into the pixel value of each image
+    std::vector<std::string> files;
+    for (int i = 0; i < 40; i++) {
+        std::string file = "./prefetch_test_" + std::to_string(i) + ".png";
+        cv::imwrite(file, cv::Mat(8, 8, CV_8UC1, cv::Scalar(i)));
+        files.push_back(file);
+    }
+
+    ImagePrefetcher prefetcher;
+    prefetcher.setConfig(4, 3);
+    prefetcher.setFiles(files);
+
+    SECTION("sequential read") {
+        cv::Mat image;
+        for (int i = 0; i < 40; i++) {
+            REQUIRE(prefetcher.next(image));
+            REQUIRE(image.at<uchar>(0, 0) == i);
+        }
+        REQUIRE(!prefetcher.next(image));
+        REQUIRE(prefetcher.stats().consumedImages == 40);
+    }
+    SECTION("seek discards prefetched images") {
+        cv::Mat image;
+        for (int i = 0; i < 10; i++) {
+            prefetcher.next(image);
+        }
+        prefetcher.seek(2);
+        REQUIRE(prefetcher.next(image));
+        REQUIRE(image.at<uchar>(0, 0) == 2);
+    }
+    SECTION("missing file yields an empty image") {
+        prefetcher.setFiles({"./prefetch_test_missing.png"});
+        cv::Mat image;
+        REQUIRE(prefetcher.next(image));
+        REQUIRE(image.empty());
+    }
+
+    for (const auto& file : files) {
+        std::remove(file.c_str());
+    }
+}
@@ -0,0 +1,84 @@
+#include "catch.hpp"
+
+#include "../lib/latencyrecorder.h"
+
+#include <thread>
+
+TEST_CASE("LatencyHistogram percentiles", "[full], [latencyrecorder]") {
+    LatencyHistogram h;
+    SECTION("empty histogram") {
+        REQUIRE(h.count() == 0);
+        REQUIRE(h.percentile(50) == 0);
+        REQUIRE(h.max() == 0);
+    }
+    SECTION("small values are exact") {
+        for (uint64_t v = 1; v <= 10; v++) {
+            h.record(v);
+        }
+        REQUIRE(h.count() == 10);
+        REQUIRE(h.percentile(50) == 5);
+        REQUIRE(h.percentile(100) == 10);
+        REQUIRE(h.max() == 10);
+        REQUIRE(h.mean() == Approx(5.5));
+    }
+    SECTION("large values are within the relative error bound") {
+        for (uint64_t v = 1; v <= 100000; v++) {
+            h.record(v * 1000);
+        }
+        for (double p : {1.0, 50.0, 90.0, 99.0, 99.9}) {
+            const double exact = p / 100.0 * 100000 * 1000;
+            const double reported = static_cast<double>(h.percentile(p));
+            REQUIRE(reported >= exact * 0.999);
+            REQUIRE(reported <= exact * (1 + 1 / 16.0));
+        }
+        REQUIRE(h.percentile(100) == 100000 * 1000);
+    }
+    SECTION("reset") {
+        h.record(1234567);
+        h.reset();
+        REQUIRE(h.count() == 0);
+        REQUIRE(h.max() == 0);
+    }
+}
+
+TEST_CASE("LatencyHistogram concurrent recording", "[full], [latencyrecorder]") {
+    LatencyHistogram h;
+    const int threads = 4;
+    const int samples = 100000;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&h, t] {
+            for (int i = 0; i < samples; i++) {
+                h.record(static_cast<uint64_t>(t * samples + i));
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    REQUIRE(h.count() == threads * samples);
+    REQUIRE(h.max() == threads * samples - 1);
+}
+
+TEST_CASE("LatencyRecorder report", "[full], [latencyrecorder]") {
+    LatencyRecorder recorder;
+    recorder.setProcessNames({"Subtract background", "Threshold"});
+    recorder.record(LatencyStage::Acquire, std::chrono::microseconds(1500));
+    recorder.recordProcess(1, std::chrono::milliseconds(2));
+    recorder.recordProcess(2, std::chrono::milliseconds(2));  // out of range, ignored
+    recorder.recordQueueDepth(LatencyQueue::Analysis, 7);
+
+    REQUIRE(recorder.stageHistogram(LatencyStage::Acquire).count() == 1);
+    REQUIRE(recorder.stageHistogram(LatencyStage::Acquire).max() == 1500000);
+    REQUIRE(recorder.queueHistogram(LatencyQueue::Analysis).max() == 7);
+
+    const std::string report = recorder.report();
+    REQUIRE(report.find("Acquire") != std::string::npos);
+    REQUIRE(report.find("1. Subtract background") != std::string::npos);
+    REQUIRE(report.find("2. Threshold") != std::string::npos);
+    REQUIRE(report.find("Analysis queue") != std::string::npos);
+
+    recorder.reset();
+    REQUIRE(recorder.stageHistogram(LatencyStage::Acquire).count() == 0);
+    REQUIRE(recorder.report().find("2. Threshold") != std::string::npos);
+}
@@ -0,0 +1,67 @@
+#include "catch.hpp"
+
+#include "../lib/latestframeslot.h"
+
+#include <atomic>
+#include <thread>
+
+TEST_CASE("LatestFrameSlot hands frames to a display", "[full], [latestframeslot]") {
+    LatestFrameSlot slot;
+    cv::Mat frame;
+
+    SECTION("frames are only copied when asked for") {
+        REQUIRE(slot.publish(cv::Mat(4, 4, CV_8UC1, cv::Scalar(1))));
+        CHECK(!slot.publish(cv::Mat(4, 4, CV_8UC1, cv::Scalar(2))));
+        REQUIRE(slot.take(frame));
+        CHECK(frame.at<uchar>(0, 0) == 1);
+        CHECK(!slot.take(frame));
+
+        REQUIRE(slot.publish(cv::Mat(4, 4, CV_8UC1, cv::Scalar(3))));
+        REQUIRE(slot.take(frame));
+        CHECK(frame.at<uchar>(0, 0) == 3);
+        CHECK(slot.publishedFrames() == 2);
+    }
+    SECTION("reset discards the published frame") {
+        REQUIRE(slot.publish(cv::Mat(4, 4, CV_8UC1, cv::Scalar(1))));
+        slot.reset();
+        CHECK(!slot.take(frame));
+        CHECK(slot.publishedFrames() == 0);
+        // A frame is copied again without the consumer asking first
+        REQUIRE(slot.publish(cv::Mat(4, 4, CV_8UC1, cv::Scalar(2))));
+        REQUIRE(slot.take(frame));
+        CHECK(frame.at<uchar>(0, 0) == 2);
+    }
+    SECTION("frames are taken whole while the producer runs") {
+        std::atomic<bool> done{false};
+        std::thread producer([&] {
+            cv::Mat image(32, 32, CV_8UC1);
+            for (int i = 0; i < 200000; i++) {
+                image.setTo(cv::Scalar(i % 256));
+                slot.publish(image);
+            }
+            done = true;
+        });
+        long taken = 0;
+        bool whole = true;
+        while (!done) {
+            if (slot.take(frame)) {
+                taken++;
+                whole &= cv::countNonZero(frame != frame.at<uchar>(0, 0)) == 0;
+            }
+        }
+        producer.join();
+        CHECK(whole);
+        // At most one frame is copied for each request
+        CHECK(slot.publishedFrames() <= taken + 1);
+    }
+    SECTION("frames are downscaled to fit the display") {
+        cv::Mat display;
+        const cv::Mat image(100, 300, CV_8UC1, cv::Scalar(7));
+        downscaleToFit(image, 150, 150, display);
+        CHECK(display.cols == 150);
+        CHECK(display.rows == 50);
+        CHECK(display.at<uchar>(0, 0) == 7);
+        downscaleToFit(image, 400, 400, display);
+        CHECK(display.data == image.data);
+    }
+}
@@ -0,0 +1,406 @@
+#include "catch.hpp"
+
+#include "../lib/machinelearning.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+namespace {
+// Reference: the per-term Shepard interpolation of the original LogisticRegression
+double referencePossibility(DataContainer& dc, const std::vector<int>& positions,
+                            const std::vector<data::DataFlags>& attributes,
+                            const std::vector<double>& coefficients, double intercept) {
+    double possibility = 0;
+    for (size_t i = 0; i < positions.size(); i++) {
+        double numerator = 0;
+        double denominator = 0;
+        for (const auto& item : dc) {
+            double d = std::pow(
+                0.01 + std::fabs(positions[i] - item->getValue<double>(data::RelativeXpos)), 2);
+            numerator += item->getValue<double>(attributes[i]) / d;
+            denominator += 1 / d;
+        }
+        possibility += coefficients[i] * numerator / denominator;
+    }
+    possibility = std::exp(possibility + intercept);
+    return possibility / (1 + possibility);
+}
+}  // namespace
+
+TEST_CASE("LogisticRegression compiled scoring", "[full], [machinelearning]") {
+    // Terms share positions and attributes, to exercise grouping of terms
+    const std::vector<int> positions = {0, 0, 50, 100, 50, 0};
+    const std::vector<data::DataFlags> attributes = {data::Area,      data::Circularity,
+                                                     data::Area,      data::Solidity,
+                                                     data::Area,      data::Area};
+    const std::vector<std::string> names = {"Area",     "Circularity", "Area",
+                                            "Solidity", "Area",        "Area"};
+    const std::vector<double> coefficients = {0.01, -2.0, 0.02, 1.5, -0.005, 0.003};
+    {
+        std::ofstream model("./machinelearning_test.csv");
+        model << "LR,-1,";
+        for (size_t i = 0; i < positions.size(); i++) {
+            model << positions[i] << "," << names[i] << "," << coefficients[i] << ",";
+        }
+    }
+    std::unique_ptr<Machinelearning> lr = identifyModel("./machinelearning_test.csv");
+    REQUIRE(lr != nullptr);
+    lr->loadModel("./machinelearning_test.csv");
+
+    std::vector<std::unique_ptr<DataContainer>> tracks;
+    std::vector<DataContainer*> batch;
+    for (int t = 0; t < 20; t++) {
+        tracks.emplace_back(new DataContainer(data::AllFlags));
+        // Odd object counts exercise the scalar tail of the SIMD kernels
+        for (int k = 0; k < 5 + t; k++) {
+            DataObject* object = tracks.back()->appendNew();
+            object->setValue(data::RelativeXpos, -40.0 + 9.7 * k);
+            object->setValue(data::Area, 100.0 + 3 * t + k);
+            object->setValue(data::Circularity, 0.5 + 0.01 * k);
+            object->setValue(data::Solidity, 0.9 - 0.02 * t);
+            object->setValue(data::Label, t);
+        }
+        batch.push_back(tracks.back().get());
+    }
+
+    std::vector<int> labels = lr->predictObjects(batch);
+    REQUIRE(labels.size() == batch.size());
+    REQUIRE(lr->getResults().size() == batch.size());
+    for (size_t t = 0; t < batch.size(); t++) {
+        double expected = referencePossibility(*batch[t], positions, attributes, coefficients, -1);
+        REQUIRE(lr->getResults()[t].probabilityOut == Approx(expected));
+        REQUIRE(lr->getResults()[t].label == static_cast<int>(t));
+        REQUIRE(labels[t] == (expected >= 0.5 ? 1 : 0));
+    }
+
+    std::remove("./machinelearning_test.csv");
+}
+
+TEST_CASE("TrackResampler interpolation styles", "[full], [machinelearning]") {
+    // Unsorted track, with observations equally close to positions 0 and 20
+    DataContainer dc(data::AllFlags);
+    const std::vector<double> xpos = {30.0, -10.0, 19.5, 10.0, 20.5};
+    for (size_t k = 0; k < xpos.size(); k++) {
+        DataObject* object = dc.appendNew();
+        object->setValue(data::RelativeXpos, xpos[k]);
+        object->setValue(data::Area, 100.0 * k);
+    }
+
+    TrackResampler resampler;
+    resampler.setGrid({0, 20, 25, 500}, {data::Area});
+    resampler.setXBoundary(250);
+
+    SECTION("Closest data point") {
+        resampler.setInterpolation(TrackResampler::Interpolation::ClosestDataPoint);
+        const std::vector<double>& grid = resampler.resample(dc);
+        REQUIRE(grid[0] == 100.0);  // -10 and 10 are equally close, -10 comes first in the track
+        REQUIRE(grid[1] == 200.0);
+        REQUIRE(grid[2] == 400.0);  // 20.5 is within the window of 5 pixels, 30 is not
+        REQUIRE(grid[3] == 0.0);  // No observation within the boundary
+    }
+    SECTION("Average of closest data points") {
+        resampler.setInterpolation(TrackResampler::Interpolation::AverageOfClosest);
+        const std::vector<double>& grid = resampler.resample(dc);
+        REQUIRE(grid[0] == Approx(0.5 * 100.0 + 0.5 * 300.0));
+        REQUIRE(grid[1] == Approx(0.5 * 200.0 + 0.5 * 400.0));
+        REQUIRE(grid[2] == Approx((400.0 * 5 + 0.0 * 4.5) / 9.5));
+        REQUIRE(grid[3] == 0.0);
+    }
+    SECTION("Inverse distance weighting") {
+        resampler.setInterpolation(TrackResampler::Interpolation::InverseDistance);
+        const std::vector<double>& grid = resampler.resample(dc);
+        double numerator = 0;
+        double denominator = 0;
+        for (size_t k = 0; k < xpos.size(); k++) {
+            double w = 1 / std::pow(0.01 + std::fabs(20 - xpos[k]), 2);
+            numerator += w * 100.0 * k;
+            denominator += w;
+        }
+        REQUIRE(grid[1] == Approx(numerator / denominator));
+    }
+    SECTION("Streamed tracks are resampled from their new observations") {
+        for (auto style : {TrackResampler::Interpolation::ClosestDataPoint,
+                           TrackResampler::Interpolation::AverageOfClosest,
+                           TrackResampler::Interpolation::InverseDistance}) {
+            resampler.setInterpolation(style);
+            const std::vector<double> full = resampler.resample(dc);
+            // Observations arrive one at a time, out of x-position order
+            DataContainer streamed(data::AllFlags);
+            SortedTrack track;
+            for (size_t k = 0; k < xpos.size(); k++) {
+                DataObject* object = streamed.appendNew();
+                object->setValue(data::RelativeXpos, xpos[k]);
+                object->setValue(data::Area, 100.0 * k);
+                resampler.resample(streamed, track, 0, 0);
+            }
+            REQUIRE(track.size() == xpos.size());
+            REQUIRE(std::is_sorted(track.xpos.begin(), track.xpos.end()));
+            const std::vector<double>& grid = resampler.resample(streamed, track, 0, 4);
+            for (size_t p = 0; p < full.size(); p++) {
+                REQUIRE(grid[p] == Approx(full[p]));
+            }
+        }
+    }
+    SECTION("Attributes must be extracted scalar values") {
+        REQUIRE_THROWS(resampler.setGrid({0}, {data::Frame}));
+        REQUIRE_THROWS(resampler.setGrid({0}, {data::Centroid}));
+        REQUIRE_THROWS(resampler.setGrid({0}, {data::BoundingBox}));
+
+        DataContainer partial(data::RelativeXpos | data::Area);
+        partial.appendNew()->setValue(data::RelativeXpos, 0.0);
+        resampler.setGrid({0}, {data::Solidity});
+        REQUIRE_THROWS(resampler.resample(partial));
+        resampler.setGrid({0}, {data::Area});
+        REQUIRE_NOTHROW(resampler.resample(partial));
+    }
+}
+
+namespace {
+// Track with constant attribute values, such that the resampled value is independent of the
+// interpolation
+std::unique_ptr<DataContainer> constantTrack(double area, double solidity, int label) {
+    std::unique_ptr<DataContainer> dc(new DataContainer(data::AllFlags));
+    for (int k = 0; k < 12; k++) {
+        DataObject* object = dc->appendNew();
+        object->setValue(data::RelativeXpos, -20.0 + 10 * k);
+        object->setValue(data::Area, area);
+        object->setValue(data::Solidity, solidity);
+        object->setValue(data::Label, label);
+    }
+    return dc;
+}
+}  // namespace
+
+TEST_CASE("TreeEnsemble evaluation", "[full], [machinelearning]") {
+    // Two trees over features (0, Area) and (50, Solidity). Tree 1 lists its children before its
+    // root's right subtree, to exercise flattening
+    const std::string trees =
+        "2,\n0,Area,\n50,Solidity,\n2,\n"
+        "5,\n0,100,1,2,0,\n-1,0,-1,-1,-1.0,\n1,0.5,3,4,0,\n-1,0,-1,-1,0.5,\n-1,0,-1,-1,2.0,\n"
+        "3,\n1,0.8,1,2,0,\n-1,0,-1,-1,0.25,\n-1,0,-1,-1,-0.25,\n";
+
+    SECTION("Gradient boosted") {
+        {
+            std::ofstream model("./machinelearning_tree.csv");
+            model << "GBT,\n0.1,\n" << trees;
+        }
+        std::unique_ptr<Machinelearning> model = identifyModel("./machinelearning_tree.csv");
+        REQUIRE(dynamic_cast<TreeEnsemble*>(model.get()) != nullptr);
+        model->loadModel("./machinelearning_tree.csv");
+
+        std::vector<std::unique_ptr<DataContainer>> tracks;
+        tracks.push_back(constantTrack(50, 0.9, 0));   // -1.0 - 0.25
+        tracks.push_back(constantTrack(150, 0.4, 1));  // 0.5 + 0.25
+        tracks.push_back(constantTrack(150, 0.9, 2));  // 2.0 - 0.25
+        const std::vector<double> sums = {-1.25, 0.75, 1.75};
+
+        std::vector<int> labels = model->predictObjects({tracks[0].get(), tracks[1].get()});
+        labels.push_back(model->predictObject(*tracks[2]));
+        for (size_t i = 0; i < tracks.size(); i++) {
+            const double expected = 1 / (1 + std::exp(-(0.1 + sums[i])));
+            REQUIRE(model->getResults()[i].probabilityOut == Approx(expected));
+            REQUIRE(model->getResults()[i].label == static_cast<int>(i));
+            REQUIRE(labels[i] == (expected >= 0.5 ? 1 : 0));
+        }
+    }
+    SECTION("Random forest") {
+        {
+            std::ofstream model("./machinelearning_tree.csv");
+            model << "RF,\n0,\n" << trees;
+        }
+        std::unique_ptr<Machinelearning> model = identifyModel("./machinelearning_tree.csv");
+        model->loadModel("./machinelearning_tree.csv");
+        auto track = constantTrack(150, 0.4, 0);
+        model->predictObject(*track);
+        REQUIRE(model->getResults()[0].probabilityOut == Approx(0.75 / 2));
+    }
+    std::remove("./machinelearning_tree.csv");
+}
+
+TEST_CASE("Classifier latency", "[.][benchmark][machinelearning]") {
+    // Compares per-track latency of a logistic regression model with a tree ensemble of 100
+    // complete trees of depth 6, over the same features
+    {
+        std::ofstream model("./machinelearning_bench_lr.csv");
+        model << "LR,\n1,\n0,Area,0.05,\n25,Major axis,-0.7,\n50,Perimeter,0.02,\n"
+              << "90,Symmetry,0.5";
+    }
+    std::unique_ptr<Machinelearning> lr = identifyModel("./machinelearning_bench_lr.csv");
+    REQUIRE(lr != nullptr);
+    lr->loadModel("./machinelearning_bench_lr.csv");
+
+    const int depth = 6;
+    const int nNodes = (1 << (depth + 1)) - 1;
+    {
+        std::ofstream model("./machinelearning_bench.csv");
+        model << "GBT,\n0,\n4,\n0,Area,\n25,Major axis,\n50,Perimeter,\n90,Symmetry,\n100,\n";
+        for (int tree = 0; tree < 100; tree++) {
+            model << nNodes << ",\n";
+            for (int node = 0; node < nNodes; node++) {
+                if (node >= nNodes / 2) {
+                    model << "-1,0,-1,-1," << (node % 7 - 3) * 0.01 << ",\n";
+                } else {
+                    model << (node + tree) % 4 << "," << (node * 37 + tree) % 100 << ","
+                          << 2 * node + 1 << "," << 2 * node + 2 << ",0,\n";
+                }
+            }
+        }
+    }
+    std::unique_ptr<Machinelearning> trees = identifyModel("./machinelearning_bench.csv");
+    trees->loadModel("./machinelearning_bench.csv");
+
+    std::vector<std::unique_ptr<DataContainer>> tracks;
+    std::vector<DataContainer*> batch;
+    for (int t = 0; t < 1000; t++) {
+        tracks.emplace_back(new DataContainer(data::AllFlags));
+        for (int k = 0; k < 40; k++) {
+            DataObject* object = tracks.back()->appendNew();
+            object->setValue(data::RelativeXpos, -50.0 + 5 * k);
+            object->setValue(data::Area, 50.0 + (t * 13 + k) % 100);
+            object->setValue(data::Major_axis, 10.0 + (t + k) % 20);
+            object->setValue(data::Perimeter, 30.0 + (t * 7) % 50);
+            object->setValue(data::Symmetry, 0.01 * ((t + 3 * k) % 100));
+        }
+        batch.push_back(tracks.back().get());
+    }
+
+    BENCHMARK("LogisticRegression, 1000 tracks") {
+        lr->predictObjects(batch);
+    }
+    BENCHMARK("TreeEnsemble, 100 trees, 1000 tracks") {
+        trees->predictObjects(batch);
+    }
+    std::remove("./machinelearning_bench.csv");
+    std::remove("./machinelearning_bench_lr.csv");
+}
+
+TEST_CASE("ArtificialNeuralNetwork evaluation", "[full], [machinelearning]") {
+    // 5 features -> 6 hidden relu units -> 1 sigmoid output. Sizes which are not multiples of
+    // four exercise the row padding
+    const int nFeatures = 5;
+    const int nHidden = 6;
+    std::vector<double> w1, b1, w2;
+    for (int i = 0; i < nHidden * nFeatures; i++) {
+        w1.push_back(0.01 * ((i * 7) % 11 - 5));
+    }
+    for (int i = 0; i < nHidden; i++) {
+        b1.push_back(0.1 * (i % 3 - 1));
+        w2.push_back(0.2 * (i % 4 - 1.5));
+    }
+    const double b2 = 0.05;
+    {
+        std::ofstream model("./machinelearning_ann.csv");
+        model << "ANN,\n" << nFeatures << ",\n0,Area,\n0,Solidity,\n40,Area,\n40,Perimeter,\n"
+              << "80,Solidity,\n2,\n";
+        model << nFeatures << "," << nHidden << ",relu,\n";
+        for (double w : w1) model << w << ",";
+        for (double b : b1) model << b << ",";
+        model << "\n" << nHidden << ",1,sigmoid,\n";
+        for (double w : w2) model << w << ",";
+        model << b2 << ",\n";
+    }
+    std::unique_ptr<Machinelearning> ann = identifyModel("./machinelearning_ann.csv");
+    REQUIRE(dynamic_cast<ArtificialNeuralNetwork*>(ann.get()) != nullptr);
+    ann->loadModel("./machinelearning_ann.csv");
+
+    std::vector<std::unique_ptr<DataContainer>> tracks;
+    std::vector<DataContainer*> batch;
+    for (int t = 0; t < 9; t++) {
+        tracks.emplace_back(new DataContainer(data::AllFlags));
+        for (int k = 0; k < 10; k++) {
+            DataObject* object = tracks.back()->appendNew();
+            object->setValue(data::RelativeXpos, -10.0 + 10 * k);
+            object->setValue(data::Area, 20.0 + 5 * t + k);
+            object->setValue(data::Solidity, 0.5 + 0.05 * t);
+            object->setValue(data::Perimeter, 30.0 - 2 * t + k);
+            object->setValue(data::Label, t);
+        }
+        batch.push_back(tracks.back().get());
+    }
+    std::vector<int> labels = ann->predictObjects(batch);
+
+    // Reference forward pass on the resampled features, in double precision
+    TrackResampler resampler;
+    resampler.setGrid({0, 40, 80}, {data::Area, data::Solidity, data::Perimeter});
+    for (size_t t = 0; t < batch.size(); t++) {
+        const std::vector<double>& grid = resampler.resample(*batch[t]);
+        const double x[] = {grid[0], grid[1], grid[3], grid[5], grid[7]};
+        double out = b2;
+        for (int h = 0; h < nHidden; h++) {
+            double a = b1[h];
+            for (int f = 0; f < nFeatures; f++) {
+                a += w1[h * nFeatures + f] * x[f];
+            }
+            out += w2[h] * std::max(a, 0.0);
+        }
+        const double expected = 1 / (1 + std::exp(-out));
+        REQUIRE(ann->getResults()[t].probabilityOut == Approx(expected).epsilon(1e-4));
+        REQUIRE(ann->getResults()[t].label == static_cast<int>(t));
+        REQUIRE(labels[t] == (expected >= 0.5 ? 1 : 0));
+    }
+    std::remove("./machinelearning_ann.csv");
+}
+
+TEST_CASE("LogisticRegression early decisions", "[full], [machinelearning]") {
+    {
+        std::ofstream model("./machinelearning_early.csv");
+        model << "LR,\n0,\n0,Area,1.0,\n50,Area,-0.5,\n100,Solidity,2.0";
+    }
+    std::unique_ptr<Machinelearning> lr = identifyModel("./machinelearning_early.csv");
+    lr->loadModel("./machinelearning_early.csv");
+    static_cast<LogisticRegression*>(lr.get())->setInterpolation_style("Closest data point");
+
+    // Feeds a track observation by observation, and returns the observation count at which the
+    // label was committed
+    auto feed = [&](DataContainer& dc, double area, double margin, StreamingState& state) {
+        for (int k = 0; k < 15; k++) {
+            DataObject* object = dc.appendNew();
+            object->setValue(data::RelativeXpos, -20.0 + 10 * k);
+            object->setValue(data::Area, area);
+            object->setValue(data::Solidity, 0.5);
+            object->setValue(data::Label, 0);
+            if (lr->updateObject(dc, state, margin) >= 0) {
+                return k + 1;
+            }
+        }
+        return -1;
+    };
+
+    SECTION("Confident track commits after the first position") {
+        DataContainer dc(data::AllFlags);
+        StreamingState state;
+        // Area 10 gives a probability of ~1 after the first term
+        REQUIRE(feed(dc, 10.0, 0.4, state) == 4);
+        REQUIRE(state.label == 1);
+        REQUIRE(state.passedPositions == 1);
+    }
+    SECTION("Undecided track commits the full score once all positions are passed") {
+        DataContainer dc(data::AllFlags);
+        StreamingState state;
+        // The score is 1.0 * 0.2 - 0.5 * 0.2 + 2.0 * 0.5 = 1.1, ie. a probability of ~0.75, which
+        // is never within the margin
+        REQUIRE(feed(dc, 0.2, 0.49, state) == 14);
+        REQUIRE(state.passedPositions == 3);
+
+        // Closest-point terms are final once passed, so the streamed score equals the score of
+        // the complete track
+        lr->predictObject(dc);
+        REQUIRE(lr->getResults().size() == 2);
+        REQUIRE(lr->getResults()[1].probabilityOut ==
+                Approx(lr->getResults()[0].probabilityOut));
+    }
+    SECTION("Withdrawn results are removed") {
+        DataContainer confident(data::AllFlags), other(data::AllFlags);
+        StreamingState confidentState;
+        REQUIRE(feed(confident, 10.0, 0.4, confidentState) == 4);
+        other.appendNew()->setValue(data::Label, 1);
+        REQUIRE(lr->getResults().size() == 1);
+        lr->withdrawResult(other);
+        REQUIRE(lr->getResults().size() == 1);
+        lr->withdrawResult(confident);
+        REQUIRE(lr->getResults().empty());
+    }
+    std::remove("./machinelearning_early.csv");
+}
@@ -0,0 +1,179 @@
+#include "catch.hpp"
+
+#include "../lib/flowgenerator.h"
+#include "../lib/objectfinder.h"
+#include "../lib/parametersweep.h"
+
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <memory>
+
+namespace {
+Setup sweepSetup() {
+    Setup setup;
+    setup.runProcessing = true;
+    setup.extractData = true;
+    setup.storeRaw = false;
+    setup.storeProcessed = false;
+    setup.storeImagesDuringExperiment = false;
+    setup.countThreshold = 3;
+    setup.distanceThresholdInlet = 12;
+    setup.distanceThresholdPath = 12;
+    setup.dataFlags = data::AllFlags;
+    setup.inlet = {32, 224};
+    setup.outlet = {32, 224};
+    return setup;
+}
+
+std::vector<cv::Mat> sweepFrames() {
+    FlowGeneratorConfig flow;
+    flow.width = 256;
+    flow.height = 64;
+    flow.inlet = {32, 224};
+    flow.outlet = {32, 224};
+    flow.density = 3;
+    flow.majorAxisMin = 8;
+    flow.majorAxisMax = 12;
+    FlowGenerator generator(flow);
+    std::vector<cv::Mat> frames = {generator.background()};
+    std::vector<cv::Mat> flowFrames = generator.renderFrames(60);
+    frames.insert(frames.end(), flowFrames.begin(), flowFrames.end());
+    return frames;
+}
+
+/**
+ * @brief Runs a single configuration as the analyzer does, one frame at a time through the whole
+ * process chain
+ */
+SweepResult referenceRun(const std::vector<std::unique_ptr<ProcessBase>>& chain, Setup setup,
+                         const std::vector<cv::Mat>& frames) {
+    // Processes may keep state between frames
+    std::vector<std::unique_ptr<ProcessBase>> processes;
+    for (const auto& process : chain) {
+        processes.push_back(cloneProcess(*process));
+    }
+    Experiment experiment;
+    experiment.setInletOutletLines(setup.inlet, setup.outlet);
+    ObjectFinder finder(&experiment, &setup);
+    cv::Mat bg = frames.front().clone();
+    for (const cv::Mat& raw : frames) {
+        cv::Mat img = raw.clone();
+        for (const auto& process : processes) {
+            process->doProcessing(img, bg, experiment);
+        }
+        DataContainer components(data::AllFlags);
+        mathlab::regionProps(img, mathlab::WithoutPixelIdxList, components);
+        finder.findObjects(raw, img, components);
+    }
+    finder.cleanObjects();
+
+    SweepResult result;
+    long trackFrames = 0;
+    for (const auto& track : experiment.data) {
+        result.objects++;
+        trackFrames += static_cast<long>(track->size());
+    }
+    result.meanTrackLength = result.objects > 0 ? double(trackFrames) / result.objects : 0;
+    return result;
+}
+
+std::function<bool(cv::Mat&)> frameSource(const std::vector<cv::Mat>& frames) {
+    auto next = std::make_shared<size_t>(0);
+    return [&frames, next](cv::Mat& frame) {
+        if (*next >= frames.size()) {
+            return false;
+        }
+        frame = frames[(*next)++];
+        return true;
+    };
+}
+}  // namespace
+
+TEST_CASE("Parameter sweep", "[full], [parametersweep]") {
+    const std::vector<cv::Mat> frames = sweepFrames();
+    const Setup setup = sweepSetup();
+
+    std::vector<std::unique_ptr<ProcessBase>> processes;
+    processes.emplace_back(new SubtractBG());
+    processes.emplace_back(new Binarize());
+    processes.emplace_back(new FloodFillProcess());
+
+    SECTION("combinations match single configuration runs") {
+        ParameterSweep sweep(processes, setup);
+        sweep.addAxis({1, "Edge_threshold", {"20", "30", "40"}});
+        sweep.addAxis({-1, "countThreshold", {"1", "3"}});
+        sweep.addAxis({-1, "distanceThresholdPath", {"8", "12"}});
+        REQUIRE(sweep.combinationCount() == 12);
+
+        const std::vector<SweepResult> results = sweep.run(frameSource(frames));
+        REQUIRE(results.size() == 12);
+        CHECK(sweep.frames() == static_cast<long>(frames.size()));
+        // The background subtraction is shared by all combinations, and each threshold is shared by
+        // the combinations which only differ by setup parameters
+        CHECK(sweep.processEvaluations() == 7);
+        CHECK(sweep.chainEvaluations() == 3);
+
+        for (const SweepResult& result : results) {
+            Setup combinationSetup = setup;
+            combinationSetup.countThreshold = std::stoi(result.values[1]);
+            combinationSetup.distanceThresholdPath = std::stod(result.values[2]);
+            static_cast<Binarize*>(processes[1].get())
+                ->m_edgeThreshold.setValue(std::stod(result.values[0]));
+            const SweepResult reference = referenceRun(processes, combinationSetup, frames);
+            INFO(result.values[0] << " " << result.values[1] << " " << result.values[2]);
+            CHECK(result.objects == reference.objects);
+            CHECK(result.meanTrackLength == Approx(reference.meanTrackLength));
+        }
+        CHECK(results[0].objects > 0);
+        // Short tracks are rejected by a higher count threshold
+        CHECK(results[0].objects >= results[2].objects);
+    }
+    SECTION("chains with a dynamic background keep their own background") {
+        ParameterSweep sweep(processes, setup);
+        sweep.addAxis({0, "Subtract_method", {"Static", "Dynamic"}});
+        sweep.addAxis({1, "Edge_threshold", {"20", "40"}});
+        const std::vector<SweepResult> results = sweep.run(frameSource(frames));
+        REQUIRE(results.size() == 4);
+        // The background of a dynamic subtraction only depends on the processes up to the
+        // subtraction, so it is shared by both thresholds as well
+        CHECK(sweep.processEvaluations() == 2 * (1 + 2 + 2));
+
+        auto subtract = static_cast<SubtractBG*>(processes[0].get());
+        auto binarize = static_cast<Binarize*>(processes[1].get());
+        for (const SweepResult& result : results) {
+            subtract->m_subtractMethod.setValueStr(result.values[0]);
+            binarize->m_edgeThreshold.setValue(std::stod(result.values[1]));
+            const SweepResult reference = referenceRun(processes, setup, frames);
+            INFO(result.values[0] << " " << result.values[1]);
+            CHECK(result.objects == reference.objects);
+        }
+    }
+    SECTION("results are written as CSV") {
+        ParameterSweep sweep(processes, setup);
+        sweep.addAxis({1, "Edge_threshold", ParameterSweep::range(20, 40, 10)});
+        const std::vector<SweepResult> results = sweep.run(frameSource(frames));
+        REQUIRE(results.size() == 3);
+
+        const std::string path = "./parametersweep.csv";
+        REQUIRE(sweep.writeResults(path, results));
+        std::ifstream in(path);
+        std::string line;
+        std::getline(in, line);
+        CHECK(line == "process1.Edge_threshold,objects,mean_track_length");
+        std::getline(in, line);
+        CHECK(line.find("20,") == 0);
+        in.close();
+        std::remove(path.c_str());
+    }
+    SECTION("invalid axes are rejected") {
+        ParameterSweep sweep(processes, setup);
+        CHECK_THROWS(sweep.addAxis({1, "Unknown", {"1"}}));
+        CHECK_THROWS(sweep.addAxis({3, "Edge_threshold", {"1"}}));
+        CHECK_THROWS(sweep.addAxis({-1, "inlet", {"1"}}));
+        CHECK_THROWS(sweep.addAxis({1, "Edge_threshold", {}}));
+        CHECK_THROWS(ParameterSweep::range(0, 1, 0));
+        const std::vector<std::string> values = {"0", "0.1", "0.2", "0.3"};
+        CHECK(ParameterSweep::range(0, 0.3, 0.1) == values);
+    }
+}
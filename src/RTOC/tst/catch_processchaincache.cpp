@@ -0,0 +1,100 @@
+#include "catch.hpp"
+
+#include "../lib/flowgenerator.h"
+#include "../lib/processchaincache.h"
+
+#include <opencv2/imgcodecs.hpp>
+
+#include <cstdio>
+
+namespace {
+/**
+ * @brief Processes a frame through a copy of a process chain, as Analyzer::processSingleFrame()
+ * does for the first frame
+ */
+cv::Mat processChain(const std::vector<std::unique_ptr<ProcessBase>>& chain,
+                     const cv::Mat& frame) {
+    Experiment experiment;
+    cv::Mat img = frame.clone();
+    cv::Mat bg = frame.clone();
+    for (const auto& process : chain) {
+        cloneProcess(*process)->doProcessing(img, bg, experiment);
+    }
+    return img;
+}
+
+bool equal(const cv::Mat& a, const cv::Mat& b) {
+    return a.size() == b.size() && a.type() == b.type() && cv::countNonZero(a != b) == 0;
+}
+}  // namespace
+
+TEST_CASE("Process chain cache", "[full], [processchaincache]") {
+    FlowGeneratorConfig flow;
+    flow.width = 256;
+    flow.height = 64;
+    flow.density = 4;
+    FlowGenerator generator(flow);
+    const std::vector<cv::Mat> frames = generator.renderFrames(2);
+
+    std::vector<std::unique_ptr<ProcessBase>> processes;
+    processes.emplace_back(new Normalize());
+    processes.emplace_back(new Binarize());
+    processes.emplace_back(new FloodFillProcess());
+    auto binarize = static_cast<Binarize*>(processes[1].get());
+
+    ProcessChainCache cache;
+    cache.setChain(processes);
+    cache.setFrame(frames[0]);
+    cv::Mat output;
+
+    SECTION("only processes following a changed process are rerun") {
+        REQUIRE(cache.process(output));
+        CHECK(cache.lastEvaluations() == 3);
+        CHECK(equal(output, processChain(processes, frames[0])));
+
+        // An unchanged chain is not processed again
+        cache.setChain(processes);
+        REQUIRE(cache.process(output));
+        CHECK(cache.lastEvaluations() == 0);
+
+        binarize->m_edgeThreshold.setValue(binarize->m_edgeThreshold.getValue() + 10);
+        cache.setChain(processes);
+        CHECK(cache.cachedStages() == 1);
+        REQUIRE(cache.process(output));
+        CHECK(cache.lastEvaluations() == 2);
+        CHECK(equal(output, processChain(processes, frames[0])));
+
+        // Removing the last process leaves the remaining outputs intact
+        processes.pop_back();
+        cache.setChain(processes);
+        REQUIRE(cache.process(output));
+        CHECK(cache.lastEvaluations() == 0);
+        CHECK(equal(output, processChain(processes, frames[0])));
+    }
+    SECTION("a new frame is processed through the whole chain") {
+        REQUIRE(cache.process(output));
+        cache.setFrame(frames[1]);
+        REQUIRE(cache.process(output));
+        CHECK(cache.lastEvaluations() == 3);
+    }
+    SECTION("a cancelled run is continued by the next run") {
+        int polls = 0;
+        CHECK(!cache.process(output, [&polls] { return ++polls > 2; }));
+        CHECK(cache.cachedStages() == 2);
+        REQUIRE(cache.process(output));
+        CHECK(cache.lastEvaluations() == 1);
+        CHECK(equal(output, processChain(processes, frames[0])));
+    }
+    SECTION("frames are only read once from file") {
+        const std::string path = "./processchaincache_test.png";
+        cv::imwrite(path, frames[1]);
+        REQUIRE(cache.loadFrame(path));
+        REQUIRE(cache.process(output));
+        CHECK(cache.lastEvaluations() == 3);
+        REQUIRE(cache.loadFrame(path));
+        REQUIRE(cache.process(output));
+        CHECK(cache.lastEvaluations() == 0);
+        CHECK(!cache.loadFrame("./processchaincache_missing.png"));
+        std::remove(path.c_str());
+    }
+}
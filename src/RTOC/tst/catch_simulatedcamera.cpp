@@ -0,0 +1,55 @@
+#include "catch.hpp"
+
+#include "../lib/simulatedcamera.h"
+
+#include <chrono>
+#include <thread>
+
+TEST_CASE("SimulatedCamera acquisition", "[full], [simulatedcamera]") {
+    SimulatedCamera camera;
+    SimulatedCameraConfig config;
+    config.width = 256;
+    config.height = 64;
+    config.fps = 200;
+    config.bufferCount = 4;
+    camera.setConfig(config);
+
+    SECTION("frames are delivered in order while the consumer keeps up") {
+        // Enough buffers to absorb scheduling delays of the consumer
+        config.bufferCount = 16;
+        camera.setConfig(config);
+        camera.start();
+        SimulatedFrame frame;
+        long lastFrameNo = -1;
+        for (int i = 0; i < 50; i++) {
+            REQUIRE(camera.acquireFrame(frame, 1000));
+            REQUIRE(frame.image.cols == 256);
+            REQUIRE(frame.image.rows == 64);
+            REQUIRE(frame.frameNo > lastFrameNo);
+            lastFrameNo = frame.frameNo;
+            camera.releaseFrame(frame);
+        }
+        camera.stop();
+        REQUIRE(camera.generatedFrames() >= 50);
+        // Frames are only missed if the consumer stalls for several frame periods
+        REQUIRE(camera.missedFrames() * 10 < camera.generatedFrames());
+    }
+    SECTION("frames are missed when the consumer holds all buffers") {
+        camera.start();
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        camera.stop();
+        REQUIRE(camera.generatedFrames() == 4);
+        REQUIRE(camera.missedFrames() > 0);
+    }
+    SECTION("replayed frames are copied into the buffers") {
+        cv::Mat replay(32, 48, CV_8UC1, cv::Scalar(17));
+        camera.setReplayFrames({replay});
+        REQUIRE(camera.getConfig().width == 48);
+        camera.start();
+        SimulatedFrame frame;
+        REQUIRE(camera.acquireFrame(frame, 1000));
+        REQUIRE(cv::countNonZero(frame.image != replay) == 0);
+        camera.releaseFrame(frame);
+        camera.stop();
+    }
+}
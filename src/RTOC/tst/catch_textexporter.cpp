@@ -0,0 +1,85 @@
+#include "catch.hpp"
+
+#include "../lib/textexporter.h"
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <random>
+#include <sstream>
+
+namespace {
+std::string formatted(double value) {
+    char buffer[64];
+    return std::string(buffer, TextExporter::formatDouble(value, buffer));
+}
+
+std::string streamed(double value) {
+    std::ostringstream out;
+    out << value;
+    return out.str();
+}
+}  // namespace
+
+TEST_CASE("TextExporter formats doubles as std::ostream", "[full], [textexporter]") {
+    std::vector<double> values = {0.0,      -0.0,     1.0,     -1.0,       0.5,     999999.0,
+                                  1000000.0, -999999.0, 123456.5, 1234567.0, 1e-5,   0.0001,
+                                  1.0 / 3,  -2.0 / 3, 1e300,   -1e-300,    12.5e10, 99999.95,
+                                  std::numeric_limits<double>::infinity(),
+                                  std::numeric_limits<double>::quiet_NaN()};
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<double> exponent(-8, 8);
+    std::uniform_int_distribution<int> integer(-2000000, 2000000);
+    for (int i = 0; i < 10000; i++) {
+        values.push_back(std::pow(10.0, exponent(rng)) * (i % 2 ? 1 : -1));
+        values.push_back(integer(rng));
+    }
+
+    for (const double value : values) {
+        REQUIRE(formatted(value) == streamed(value));
+    }
+}
+
+TEST_CASE("TextExporter file layout", "[full], [textexporter]") {
+    std::vector<std::unique_ptr<DataContainer>> tracks;
+    for (int i = 0; i < 11; i++) {
+        tracks.emplace_back(new DataContainer(data::AllFlags));
+        for (int j = 0; j < i % 4 + 1; j++) {
+            DataObject* object = tracks.back()->appendNew();
+            object->setValue(data::Area, 10.0 * i + j);
+            object->setValue(data::Centroid, cv::Point(i, -j));
+            object->setValue(data::Frame, j);
+            object->setValue(data::RelativeXpos, i / 7.0 - j);
+        }
+    }
+
+    // Reference: the previous single threaded iostream implementation
+    std::ostringstream expected;
+    for (const auto& attribute : tracks[0]->extractAttributeName()) {
+        expected << attribute << "'";
+    }
+    expected << "\n";
+    for (const auto& value : tracks[0]->extractAttributeLengths()) {
+        expected << value << " ";
+    }
+    expected << "\n" << tracks.size() << "\n";
+    for (int i = 0; i < tracks.size(); i++) {
+        expected << "Observation" << (i + 1) << " " << tracks[i]->size() << "\n";
+        for (int j = 0; j < tracks[i]->size(); j++) {
+            for (const auto& item : tracks[i]->extractObjectInDoubles(j)) {
+                expected << item << " ";
+            }
+            expected << "\n";
+        }
+    }
+
+    // Small chunks, such that several waves of chunks are formatted
+    TextExporter exporter(3, 2);
+    REQUIRE(exporter.write("./textexporter_test.txt", tracks));
+    std::ifstream in("./textexporter_test.txt");
+    std::string file((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    REQUIRE(file == expected.str());
+
+    std::remove("./textexporter_test.txt");
+}
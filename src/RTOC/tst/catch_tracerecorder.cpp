@@ -0,0 +1,104 @@
+#include "catch.hpp"
+
+#include "../lib/tracerecorder.h"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+namespace {
+std::string readFile(const std::string& path) {
+    std::ifstream in(path);
+    std::stringstream ss;
+    ss << in.rdbuf();
+    return ss.str();
+}
+
+size_t countOccurrences(const std::string& s, const std::string& pattern) {
+    size_t count = 0;
+    for (size_t pos = s.find(pattern); pos != std::string::npos; pos = s.find(pattern, pos + 1)) {
+        count++;
+    }
+    return count;
+}
+}  // namespace
+
+TEST_CASE("TraceRecorder records nothing while disabled", "[full], [tracerecorder]") {
+    TraceRecorder trace;
+    const auto now = TraceRecorder::Clock::now();
+    trace.span("span", 0, now, now);
+    trace.counter("counter", 1);
+    { TraceSpan span(trace, "scoped", 0); }
+    REQUIRE(trace.eventCount() == 0);
+
+    trace.start();
+    trace.span("span", 0, now, now);
+    trace.stop();
+    trace.span("span", 1, now, now);
+    REQUIRE(trace.eventCount() == 1);
+}
+
+TEST_CASE("TraceRecorder keeps the latest events of each thread", "[full], [tracerecorder]") {
+    TraceRecorder trace(4);
+    trace.start();
+    const auto now = TraceRecorder::Clock::now();
+    for (long i = 0; i < 10; i++) {
+        trace.span("span", i, now, now);
+    }
+    REQUIRE(trace.eventCount() == 4);
+
+    const std::string path = "./tracerecorder_ring.json";
+    REQUIRE(trace.write(path));
+    const std::string json = readFile(path);
+    std::remove(path.c_str());
+    REQUIRE(json.find("\"frame\":5}") == std::string::npos);
+    REQUIRE(json.find("\"frame\":6}") != std::string::npos);
+    REQUIRE(json.find("\"frame\":9}") != std::string::npos);
+    // Oldest first
+    REQUIRE(json.find("\"frame\":6}") < json.find("\"frame\":9}"));
+
+    // A new recording discards the events of the previous one
+    trace.start();
+    REQUIRE(trace.eventCount() == 0);
+}
+
+TEST_CASE("TraceRecorder Chrome trace export", "[full], [tracerecorder]") {
+    TraceRecorder trace;
+    trace.start();
+    const char* processName = trace.internName("Process \"A\"");
+    REQUIRE(trace.internName("Process \"A\"") == processName);
+
+    const int threads = 3;
+    const long frames = 100;
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&trace, t, processName] {
+            trace.setThreadName("Worker " + std::to_string(t));
+            for (long i = 0; i < frames; i++) {
+                const auto begin = TraceRecorder::Clock::now();
+                { TraceSpan span(trace, processName, i); }
+                trace.wait("Queue", t * frames + i, begin, TraceRecorder::Clock::now());
+                trace.counter("Depth", static_cast<double>(i));
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    trace.stop();
+    REQUIRE(trace.eventCount() == threads * frames * 3);
+
+    const std::string path = "./tracerecorder_export.json";
+    REQUIRE(trace.write(path));
+    const std::string json = readFile(path);
+    std::remove(path.c_str());
+    REQUIRE(json.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[") == 0);
+    REQUIRE(countOccurrences(json, "\"ph\":\"M\"") == threads);
+    REQUIRE(countOccurrences(json, "\"ph\":\"X\"") == threads * frames);
+    REQUIRE(countOccurrences(json, "\"ph\":\"b\"") == threads * frames);
+    REQUIRE(countOccurrences(json, "\"ph\":\"e\"") == threads * frames);
+    REQUIRE(countOccurrences(json, "\"ph\":\"C\"") == threads * frames);
+    REQUIRE(json.find("\"name\":\"Worker 2\"") != std::string::npos);
+    REQUIRE(json.find("Process \\\"A\\\"") != std::string::npos);
+}